@@ -0,0 +1,226 @@
+#include "acquisitionEngine.h"
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+
+AcquisitionEngine::AcquisitionEngine(std::shared_ptr<QNiSysConfigWrapper> aSysConfigInstance,
+                                     std::shared_ptr<QNiDaqWrapper>       aDaqMxInstance,
+                                     std::shared_ptr<DaqBackend>          aDaqBackend)
+    : m_sysConfig (aSysConfigInstance),
+      m_daqMx     (aDaqMxInstance),
+      m_daqBackend(aDaqBackend)
+{
+}
+
+AcquisitionEngine::~AcquisitionEngine()
+{
+    stop();
+}
+
+bool AcquisitionEngine::isAcquirable(NIDeviceModule *module) const
+{
+    if (!module) return false;
+    // Only analogic modules with a configured [acquisition] section run continuously,
+    // counters and digital outputs are handled on demand by their readers and writers
+    ModuleType modType = module->getModuleType();
+    if (modType != isAnalogicInputCurrent && modType != isAnalogicInputVoltage) return false;
+    return (module->getSamplingRate() > 0.0) && (module->getSamplesPerChannel() > 0) && (module->getNbChannel() > 0);
+}
+
+void AcquisitionEngine::start()
+{
+    if (m_keepRunning.load())
+    {
+        return;
+    }
+
+    // Build every worker first so that the alias lookup table is complete and immutable once threads run
+    m_workers.clear();
+    m_workersByAlias.clear();
+    for (NIDeviceModule *module : m_sysConfig->getModuleList())
+    {
+        if (!isAcquirable(module))
+        {
+            continue;
+        }
+        std::unique_ptr<ModuleWorker> worker(new ModuleWorker());
+        worker->module = module;
+        worker->chanNames = module->getChanNames();
+        worker->store.resize(module->getNbChannel());
+        m_workersByAlias[module->getAlias()] = worker.get();
+        m_workers.push_back(std::move(worker));
+    }
+
+    m_keepRunning.store(true);
+    for (std::unique_ptr<ModuleWorker> &worker : m_workers)
+    {
+        ModuleWorker *aWorker = worker.get();
+        aWorker->thread = std::thread([this, aWorker]() { runWorker(aWorker); });
+        std::cout << "Acquisition worker started for " << aWorker->module->getAlias()
+                  << " (" << aWorker->module->getModuleName() << ", "
+                  << aWorker->module->getSamplingRate() << " Hz, "
+                  << aWorker->module->getSamplesPerChannel() << " samples per block)" << std::endl;
+    }
+}
+
+void AcquisitionEngine::stop()
+{
+    m_keepRunning.store(false);
+    for (std::unique_ptr<ModuleWorker> &worker : m_workers)
+    {
+        if (worker->thread.joinable())
+        {
+            worker->thread.join();
+        }
+    }
+}
+
+void AcquisitionEngine::runWorker(ModuleWorker *worker)
+{
+    NIDeviceModule *module = worker->module;
+    const std::string alias = module->getAlias();
+    const size_t channelsCount = module->getNbChannel();
+
+    // Buffers are allocated once per worker, the loop only reuses them
+    std::vector<double> dataBuffer(channelsCount * module->getSamplesPerChannel());
+    std::vector<double> averages  (channelsCount, 0.0);
+    std::vector<double> oldValues;
+    // Low-pass state of every channel of this module, kept across blocks and task recreations
+    LowPassFilterBank   filterBank(channelsCount);
+    // Per channel chain of the module ini file, compiled once, null when the module has none
+    DspChain            dspChain;
+    DspChain           *activeChain = nullptr;
+    if (module->getDspChainSettings().isConfigured())
+    {
+        std::string  error;
+        const double fullScale = std::max(std::fabs(module->getChanMin()), std::fabs(module->getChanMax()));
+        if (dspChain.compile(module->getDspChainSettings(), module->getSamplingRate(), fullScale, channelsCount, error))
+        {
+            activeChain = &dspChain;
+            std::cout << "Filter chain of " << alias << " compiled into " << dspChain.getNbStages() << " stages, "
+                      << dspChain.getOutputRate(0) << " Hz output on channel 0" << std::endl;
+        }
+        else
+        {
+            appendCommentWithTimestamp(m_fileNamesContainer.acquisitionEngineLogFile,
+                                       "In\n"
+                                       "void AcquisitionEngine::runWorker(ModuleWorker *worker)\n"
+                                       "Error: invalid [filters] section for "+alias+", the blocks are only averaged.\n"+error);
+        }
+    }
+
+    // Native codes of the module when its ini file asks for a raw acquisition and the backend can deliver them
+    RawAnalogBlock      rawBlock;
+
+    while (m_keepRunning.load())
+    {
+        TaskHandle taskHandle = nullptr;
+        try
+        {
+            taskHandle = m_daqBackend->createContinuousAnalogTask(module);
+            bool useRaw = false;
+            if (module->getRawAcquisition())
+            {
+                useRaw = m_daqBackend->getAnalogRawScaling(taskHandle, module, rawBlock);
+                if (!useRaw)
+                {
+                    appendCommentWithTimestamp(m_fileNamesContainer.acquisitionEngineLogFile,
+                                               "In\n"
+                                               "void AcquisitionEngine::runWorker(ModuleWorker *worker)\n"
+                                               "Warning: no raw acquisition available for "+alias+" on the "+m_daqBackend->getBackendName()+" backend, scaled reads are used.");
+                }
+            }
+            auto lastCycleTime = std::chrono::steady_clock::now();
+            while (m_keepRunning.load())
+            {
+                const bool blockRead = useRaw ? m_daqBackend->readAnalogBlockRaw(taskHandle, module, rawBlock)
+                                              : m_daqBackend->readAnalogBlock   (taskHandle, module, dataBuffer);
+                if (!blockRead)
+                {
+                    // incomplete or lost block, wait for the next one
+                    continue;
+                }
+                auto currentCycleTime = std::chrono::steady_clock::now();
+                float deltaTime = std::chrono::duration<float>(currentCycleTime - lastCycleTime).count();
+                lastCycleTime = currentCycleTime;
+
+                if (useRaw)
+                {
+                    m_daqMx->reduceRawAnalogBlock(module, rawBlock, dataBuffer, averages, oldValues, filterBank, activeChain, deltaTime);
+                }
+                else
+                {
+                    m_daqMx->reduceAnalogBlock(module, dataBuffer, averages, oldValues, filterBank, activeChain, deltaTime);
+                }
+                worker->store.publish(averages);
+                {
+                    std::lock_guard<std::mutex> lock(m_frameMutex);
+                    ++m_frameEpoch;
+                }
+                m_frameCondition.notify_all();
+            }
+        }
+        catch (const std::exception &e)
+        {
+            appendCommentWithTimestamp(m_fileNamesContainer.acquisitionEngineLogFile,
+                                       "In\n"
+                                       "void AcquisitionEngine::runWorker(ModuleWorker *worker)\n"
+                                       "Error: acquisition failed on "+alias+", the task will be recreated.\n"+
+                                       std::string(e.what()));
+            if (workerErrorSignal)
+            {
+                workerErrorSignal(alias, this);
+            }
+            // Give the hardware some time before recreating the task
+            std::this_thread::sleep_for(std::chrono::seconds(1));
+        }
+        m_daqBackend->clearContinuousTask(taskHandle);
+    }
+}
+
+SeqlockFrameStore<double> *AcquisitionEngine::getModuleStore(const std::string &moduleAlias)
+{
+    auto it = m_workersByAlias.find(moduleAlias);
+    if (it == m_workersByAlias.end())
+    {
+        return nullptr;
+    }
+    return &(it->second->store);
+}
+
+bool AcquisitionEngine::findChannelIndex(const std::string &moduleAlias, const std::string &chanName, size_t &index) const
+{
+    auto it = m_workersByAlias.find(moduleAlias);
+    if (it == m_workersByAlias.end())
+    {
+        return false;
+    }
+    const std::vector<std::string> &chanNames = it->second->chanNames;
+    for (size_t i = 0; i < chanNames.size(); ++i)
+    {
+        if (chanNames[i] == chanName)
+        {
+            index = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool AcquisitionEngine::waitForNewFrames(uint64_t &frameEpoch, std::chrono::milliseconds timeout)
+{
+    std::unique_lock<std::mutex> lock(m_frameMutex);
+    const bool newFrames = m_frameCondition.wait_for(lock, timeout, [this, &frameEpoch]() { return m_frameEpoch != frameEpoch; });
+    frameEpoch = m_frameEpoch;
+    return newFrames;
+}
+
+unsigned int AcquisitionEngine::getNbWorkers() const
+{
+    return static_cast<unsigned int>(m_workers.size());
+}
+
+bool AcquisitionEngine::isRunning() const
+{
+    return m_keepRunning.load();
+}
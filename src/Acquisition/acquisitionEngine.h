@@ -0,0 +1,79 @@
+#ifndef ACQUISITIONENGINE_H
+#define ACQUISITIONENGINE_H
+
+#include <vector>
+#include <string>
+#include <map>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <functional>
+
+#include "../NiWrappers/QNiSysConfigWrapper.h"
+#include "../NiWrappers/QNiDaqWrapper.h"
+#include "../DaqBackends/daqBackend.h"
+#include "../NiModulesDefinitions/NIDeviceModule.h"
+#include "../threadSafeBuffers/seqlockFrameStore.h"
+#include "../filesUtils/appendToFileHelper.h"
+#include "../globals/globalEnumStructs.h"
+
+// Generic continuous acquisition engine:
+// one worker thread per plugged module returned by QNiSysConfigWrapper::EnumerateCRIOPluggedModules().
+// Channel set, range, sample rate and block size come from each module ini file ([channels] and [acquisition]),
+// so adding a module or moving it to another slot is only a matter of configuration.
+// Blocks come from a DaqBackend (real DAQmx or simulated), the reduction stays in QNiDaqWrapper.
+class AcquisitionEngine {
+public:
+    AcquisitionEngine(std::shared_ptr<QNiSysConfigWrapper> aSysConfigInstance,
+                      std::shared_ptr<QNiDaqWrapper>       aDaqMxInstance,
+                      std::shared_ptr<DaqBackend>          aDaqBackend);
+    ~AcquisitionEngine();
+
+    // Creates and starts one worker per acquirable module (modules must have been enumerated before)
+    void start();
+    // Stops and joins all the workers
+    void stop();
+
+    // Latest reduced frame of a module (one value per channel, in the order of the module channel names),
+    // lock free for the readers, never blocks the worker
+    SeqlockFrameStore<double> *getModuleStore(const std::string &moduleAlias);
+    // Position of a channel in the frame of a module, string compares only (no allocation)
+    bool                       findChannelIndex(const std::string &moduleAlias, const std::string &chanName, size_t &index) const;
+    // Blocks until any worker published a frame after frameEpoch, or until the timeout.
+    // frameEpoch is updated, the caller then compares the frameNumber() of the stores it uses
+    bool                       waitForNewFrames(uint64_t &frameEpoch, std::chrono::milliseconds timeout);
+    unsigned int               getNbWorkers() const;
+    bool                       isRunning   () const;
+
+    //signals
+    std::function<void(const std::string &moduleAlias, AcquisitionEngine *sender)> workerErrorSignal = nullptr;
+
+private:
+    // Everything a worker owns, the module pointer belongs to QNiSysConfigWrapper
+    struct ModuleWorker
+    {
+        NIDeviceModule           *module = nullptr;
+        std::vector<std::string>  chanNames;      // snapshot of the module channel names, frame order
+        SeqlockFrameStore<double> store;
+        std::thread               thread;
+    };
+
+    void runWorker(ModuleWorker *worker);
+    bool isAcquirable(NIDeviceModule *module) const;
+
+    std::shared_ptr<QNiSysConfigWrapper>         m_sysConfig;
+    std::shared_ptr<QNiDaqWrapper>               m_daqMx;
+    std::shared_ptr<DaqBackend>                  m_daqBackend;
+    std::vector<std::unique_ptr<ModuleWorker>>   m_workers;
+    std::map<std::string, ModuleWorker*>         m_workersByAlias; // filled before the threads start, read only afterwards
+    std::atomic<bool>                            m_keepRunning{false};
+    std::mutex                                   m_frameMutex;
+    std::condition_variable                      m_frameCondition;  // notified by every worker after each published frame
+    uint64_t                                     m_frameEpoch = 0;  // frames published by all the workers, guarded by m_frameMutex
+    GlobalFileNamesContainer                     m_fileNamesContainer;
+};
+
+#endif // ACQUISITIONENGINE_H
@@ -3,35 +3,69 @@
 #include <cstdlib> // for std::rand
 #include <vector>
 #include <chrono>
+#include "../filesUtils/iniObject.h"
+
+// Rate group names, as written in the 10th column of mapping.csv and in modbus.ini [rategroups]
+static const char *const rateGroupNames[rateGroupsCount]     = {"fast", "medium", "slow"};
+static const int         defaultRateGroupPeriodsMs[rateGroupsCount] = {125, 500, 2000};
 
 // Constructor
-NItoModbusBridge::NItoModbusBridge(std::shared_ptr<AnalogicReader>  analogicReader,
-                                   std::shared_ptr<DigitalReader>   digitalReader,
-                                   std::shared_ptr<DigitalWriter>   digitalWriter,
-                                   std::shared_ptr<NewModbusServer> modbusServer)
+NItoModbusBridge::NItoModbusBridge(std::shared_ptr<AnalogicReader>    analogicReader,
+                                   std::shared_ptr<DigitalReader>     digitalReader,
+                                   std::shared_ptr<DigitalWriter>     digitalWriter,
+                                   std::shared_ptr<NewModbusServer>   modbusServer,
+                                   std::shared_ptr<PeriodicScheduler> scheduler)
     : m_simulationBuffer (),
       m_realDataBuffer   (),
+      m_scheduler        (scheduler),
       m_analogicReader   (analogicReader),
       m_digitalReader    (digitalReader),
       m_digitalWriter    (digitalWriter),
       m_modbusServer     (modbusServer)
 {
+    // Every tick is a job of the shared scheduler, created stopped, on absolute deadlines
+    m_simulateJob = m_scheduler->addJob("bridge simulation",
+                                        std::chrono::milliseconds(250),
+                                        [this]() { this->onSimulationTimerTimeOut(); });
+    // One publication job per rate group, each one only does the rows of its group
+    loadRateGroupPeriods();
+    for (int i = 0; i < rateGroupsCount; ++i)
+    {
+        const RateGroup rateGroup = static_cast<RateGroup>(i);
+        m_rateGroupJobs[i] = m_scheduler->addJob("bridge acquisition " + std::string(rateGroupNames[i]),
+                                                 std::chrono::milliseconds(m_rateGroupPeriodsMs[i]),
+                                                 [this, rateGroup]() { this->onDataAcquisitionTimerTimeOut(rateGroup); });
+    }
+}
 
-    m_simulateTimer = std::make_shared<SimpleTimer>();
-    std::chrono::milliseconds mss(250);
-    m_simulateTimer->setInterval(mss);
-    m_simulateTimer->stop();
-    // Wire up the signals and slots
-    m_simulateTimer->setSlotFunction([this]()
-                                     { this->onSimulationTimerTimeOut(); });
+NItoModbusBridge::~NItoModbusBridge()
+{
+    // The scheduler may outlive the bridge, its jobs must not run on a destroyed object
+    stopEventThread();
+    m_scheduler->stopJob(m_simulateJob);
+    for (PeriodicScheduler::JobId jobId : m_rateGroupJobs)
+    {
+        m_scheduler->stopJob(jobId);
+    }
+}
 
-    m_dataAcquTimer = std::make_shared<SimpleTimer>();
-    std::chrono::milliseconds msr(125);
-    m_dataAcquTimer->setInterval(msr);
-    m_dataAcquTimer->stop();
-    // Wire up the signals and slots
-    m_dataAcquTimer->setSlotFunction([this]()
-                                     { this->onDataAcquisitionTimerTimeOut(); });
+void NItoModbusBridge::loadRateGroupPeriods()
+{
+    IniObject ini;
+    for (int i = 0; i < rateGroupsCount; ++i)
+    {
+        const std::string key = std::string(rateGroupNames[i]) + "periodms";
+        bool ok = false;
+        m_rateGroupPeriodsMs[i] = ini.readInteger("rategroups", key, defaultRateGroupPeriodsMs[i], m_fileNamesContainer.modbusIniFile, ok);
+        if (!ok || m_rateGroupPeriodsMs[i] <= 0)
+        {
+            appendCommentWithTimestamp(m_fileNamesContainer.niToModbusBridgeLogFile,
+                                       "in\n"
+                                       "void NItoModbusBridge::loadRateGroupPeriods()\n"
+                                       "Warning: reading 'rategroups' '"+key+"' failed, "+std::to_string(defaultRateGroupPeriodsMs[i])+" ms used");
+            m_rateGroupPeriodsMs[i] = defaultRateGroupPeriodsMs[i];
+        }
+    }
 }
 
 // Getters and setters for AnalogicReader
@@ -267,9 +301,222 @@ void NItoModbusBridge::loadMapping()
             continue; // Skip this line and proceed to the next one
         }
 
+        // Optional 'rateGroup' field: fast, medium or slow (or 0, 1, 2), fast when absent
+        if (getline(iss, token, ';'))
+        {
+            token = toLowerCase(removeSpacesFromCharStar(token.c_str()));
+            token.erase(std::remove(token.begin(), token.end(), '\r'), token.end());
+            bool found = false;
+            for (int i = 0; i < rateGroupsCount && !found; ++i)
+            {
+                if (token == rateGroupNames[i] || token == std::to_string(i))
+                {
+                    config.rateGroup = static_cast<RateGroup>(i);
+                    found = true;
+                }
+            }
+            if (!found && !token.empty())
+            {
+                appendCommentWithTimestamp(m_fileNamesContainer.niToModbusBridgeLogFile,
+                                           "in\n"
+                                           "void NItoModbusBridge::loadMapping()\n"
+                                           "Warning: unknown rate group '"+token+"', mapping row "+std::to_string(config.index)+" stays in the fast group");
+            }
+        }
+
+        // Optional 'deadband' field, in source units, 0 when absent
+        if (getline(iss, token, ';') && !removeSpacesFromCharStar(token.c_str()).empty())
+        {
+            try
+            {
+                config.deadband = std::fabs(std::stof(token));
+            }
+            catch (const std::invalid_argument& e)
+            {
+                appendCommentWithTimestamp(m_fileNamesContainer.niToModbusBridgeLogFile,
+                                           "in\n"
+                                           "void NItoModbusBridge::loadMapping()\n"
+                                           "Warning: failed to parse 'deadband' value, mapping row "+std::to_string(config.index)+" publishes every change:\n"+std::string(e.what()));
+            }
+        }
+
         // Add the parsed config to the m_mappingData vector
         m_mappingData.push_back(config);
     }
+
+    // Resolve everything that does not change at runtime once and for all
+    compileMappingPlan();
+}
+
+void NItoModbusBridge::compileMappingPlan()
+{
+    m_analogPlan.clear();
+    m_counterPlan.clear();
+    m_otherRows.clear();
+    for (std::vector<int> &registers : m_rateGroupRegisters)
+    {
+        registers.clear();
+    }
+
+    std::shared_ptr<AcquisitionEngine> engine = m_analogicReader ? m_analogicReader->getAcquisitionEngine() : nullptr;
+    const int registersCount = m_modbusServer ? m_modbusServer->getSRUMappingSizeWithoutAlarms() : 0;
+
+    for (std::size_t i = 0; i < m_mappingData.size(); ++i)
+    {
+        const MappingConfig &config = m_mappingData[i];
+        if (config.moduleType == ModuleType::isCounter)
+        {
+            compileCounterRow(i, registersCount);
+            continue;
+        }
+        if (config.moduleType != ModuleType::isAnalogicInputCurrent && config.moduleType != ModuleType::isAnalogicInputVoltage)
+        {
+            m_otherRows.push_back(i);
+            continue;
+        }
+
+        MappingPlanEntry entry;
+        entry.mappingIndex        = i;
+        entry.destinationRegister = config.modbusChannel;
+        entry.source              = engine ? engine->getModuleStore(config.module) : nullptr;
+        if (!entry.source)
+        {
+            appendCommentWithTimestamp(m_fileNamesContainer.niToModbusBridgeLogFile,
+                                       "in\n"
+                                       "void NItoModbusBridge::compileMappingPlan()\n"
+                                       "Error: no acquisition running for module "+config.module+", mapping row "+std::to_string(config.index)+" ignored");
+            continue;
+        }
+        if (!engine->findChannelIndex(config.module, config.channel, entry.channelIndex))
+        {
+            entry.channelIndex = extractChanIndex(config.channel);
+        }
+        if (entry.channelIndex >= entry.source->size())
+        {
+            appendCommentWithTimestamp(m_fileNamesContainer.niToModbusBridgeLogFile,
+                                       "in\n"
+                                       "void NItoModbusBridge::compileMappingPlan()\n"
+                                       "Error: unknown channel "+config.module+config.channel+", mapping row "+std::to_string(config.index)+" ignored");
+            continue;
+        }
+        if (entry.destinationRegister < 0 || entry.destinationRegister >= registersCount)
+        {
+            appendCommentWithTimestamp(m_fileNamesContainer.niToModbusBridgeLogFile,
+                                       "in\n"
+                                       "void NItoModbusBridge::compileMappingPlan()\n"
+                                       "Error: modbus register "+std::to_string(entry.destinationRegister)+" out of range, mapping row "+std::to_string(config.index)+" ignored");
+            continue;
+        }
+
+        // Precompute the linear interpolation, a degenerated source range always gives minDest
+        entry.minDest = static_cast<double>(config.minDest);
+        entry.maxDest = static_cast<double>(config.maxDest);
+        if (config.maxSource != config.minSource)
+        {
+            entry.scale = (entry.maxDest - entry.minDest) / (static_cast<double>(config.maxSource) - static_cast<double>(config.minSource));
+        }
+        entry.offset   = entry.minDest - entry.scale * static_cast<double>(config.minSource);
+        entry.deadband = static_cast<double>(config.deadband);
+        m_analogPlan.push_back(entry);
+    }
+
+    // Structure of arrays used at every update: one frame read per module, one scaling pass for all the rows of the module
+    m_analogSources.clear();
+    for (const MappingPlanEntry &entry : m_analogPlan)
+    {
+        const RateGroup rateGroup = m_mappingData[entry.mappingIndex].rateGroup;
+        auto group = std::find_if(m_analogSources.begin(), m_analogSources.end(),
+                                  [&entry, rateGroup](const AnalogSourceGroup &aGroup) { return aGroup.source == entry.source && aGroup.rateGroup == rateGroup; });
+        if (group == m_analogSources.end())
+        {
+            m_analogSources.push_back(AnalogSourceGroup());
+            group = m_analogSources.end() - 1;
+            group->source    = entry.source;
+            group->rateGroup = rateGroup;
+            group->frame.assign(entry.source->size(), 0.0);
+        }
+        m_rateGroupRegisters[rateGroup].push_back(entry.destinationRegister);
+        group->channelIndexes.push_back(entry.channelIndex);
+        group->scaler.addRow(entry.scale, entry.offset, entry.minDest, entry.maxDest, entry.destinationRegister, entry.deadband);
+    }
+
+    std::size_t counterRows = 0;
+    for (const CounterPlanGroup &group : m_counterPlan)
+    {
+        counterRows += group.entries.size();
+    }
+    std::cout << "Mapping plan compiled: " << m_analogPlan.size() << " analogic rows, "
+              << counterRows << " counter rows, "
+              << m_otherRows.size() << " other rows" << std::endl;
+    for (int i = 0; i < rateGroupsCount; ++i)
+    {
+        std::cout << "    " << rateGroupNames[i] << " rate group: " << m_rateGroupRegisters[i].size()
+                  << " registers every " << m_rateGroupPeriodsMs[i] << " ms" << std::endl;
+    }
+}
+
+void NItoModbusBridge::compileCounterRow(std::size_t mappingIndex, int registersCount)
+{
+    const MappingConfig &config = m_mappingData[mappingIndex];
+    std::shared_ptr<QNiSysConfigWrapper> sysConfig = m_digitalReader ? m_digitalReader->getSysConfig() : nullptr;
+    NIDeviceModule *module = sysConfig ? sysConfig->getModuleByAlias(config.module) : nullptr;
+    if (!module || module->getModuleType() != ModuleType::isCounter)
+    {
+        appendCommentWithTimestamp(m_fileNamesContainer.niToModbusBridgeLogFile,
+                                   "in\n"
+                                   "void NItoModbusBridge::compileCounterRow(std::size_t mappingIndex, int registersCount)\n"
+                                   "Error: no counter module "+config.module+", mapping row "+std::to_string(config.index)+" ignored");
+        return;
+    }
+    // Frequency, high word and low word must all fit in the register line
+    if (config.modbusChannel < 0 || config.modbusChannel + 2 >= registersCount)
+    {
+        appendCommentWithTimestamp(m_fileNamesContainer.niToModbusBridgeLogFile,
+                                   "in\n"
+                                   "void NItoModbusBridge::compileCounterRow(std::size_t mappingIndex, int registersCount)\n"
+                                   "Error: modbus registers "+std::to_string(config.modbusChannel)+" to "+std::to_string(config.modbusChannel+2)+" out of range, mapping row "+std::to_string(config.index)+" ignored");
+        return;
+    }
+
+    // One group per module whatever the rate groups of its rows, a module has a single set of counter tasks
+    const RateGroup rateGroup = config.rateGroup;
+    auto groupIter = std::find_if(m_counterPlan.begin(), m_counterPlan.end(),
+                                  [module](const CounterPlanGroup &group) { return group.module == module; });
+    if (groupIter == m_counterPlan.end())
+    {
+        m_counterPlan.emplace_back();
+        groupIter = m_counterPlan.end() - 1;
+        groupIter->module = module;
+    }
+    CounterPlanGroup &group = *groupIter;
+    group.rateGroupsMask |= 1u << rateGroup;
+
+    // Several rows may publish the same counter, it is still read only once
+    CounterPlanEntry entry;
+    auto chanIter = std::find(group.chanNames.begin(), group.chanNames.end(), config.channel);
+    entry.valueIndex = static_cast<size_t>(chanIter - group.chanNames.begin());
+    if (chanIter == group.chanNames.end())
+    {
+        group.chanNames.push_back(config.channel);
+        group.values.push_back(0);
+        group.rates.emplace_back(module->getFrequencyWindow());
+    }
+    entry.mappingIndex        = mappingIndex;
+    entry.destinationRegister = config.modbusChannel;
+    entry.minDest             = static_cast<double>(config.minDest);
+    entry.maxDest             = static_cast<double>(config.maxDest);
+    if (config.maxSource != config.minSource)
+    {
+        entry.scale = (entry.maxDest - entry.minDest) / (static_cast<double>(config.maxSource) - static_cast<double>(config.minSource));
+    }
+    entry.offset   = entry.minDest - entry.scale * static_cast<double>(config.minSource);
+    entry.deadband  = static_cast<double>(config.deadband);
+    entry.rateGroup = rateGroup;
+    group.entries.push_back(entry);
+    for (int k = 0; k < 3; ++k)
+    {
+        m_rateGroupRegisters[rateGroup].push_back(entry.destinationRegister + k);
+    }
 }
 
 void NItoModbusBridge::loadAlarmMapping()
@@ -427,22 +674,26 @@ void NItoModbusBridge::loadAlarmMapping()
 
 bool NItoModbusBridge::startModbusSimulation()
 {
-    // Check if the simulateTimer is already active
-    if (m_simulateTimer->isActive())
+    // Check if the simulation job is already active
+    if (isModbusSimulationActive())
     {
         return true; // Simulation is already running, return true
     }
 
     try
     {
-        // Stop the data acquisition timer to avoid conflicts
-        m_dataAcquTimer->stop();
+        // Stop the data acquisition jobs and the event thread to avoid conflicts
+        stopEventThread();
+        for (PeriodicScheduler::JobId jobId : m_rateGroupJobs)
+        {
+            m_scheduler->stopJob(jobId);
+        }
 
         // Clear the simulation buffer to start with a clean slate
         m_simulationBuffer.clear();
 
-        // Start the simulation timer
-        m_simulateTimer->start();
+        // Start the simulation job
+        m_scheduler->startJob(m_simulateJob);
 
         return true; // Successfully started the simulation
     }
@@ -464,8 +715,8 @@ void NItoModbusBridge::stopModbusSimulation()
 {
     try
     {
-        // Stop the simulation timer
-        m_simulateTimer->stop();
+        // Stop the simulation job
+        m_scheduler->stopJob(m_simulateJob);
     }
     catch (const std::exception &e)
     {
@@ -479,8 +730,8 @@ void NItoModbusBridge::stopModbusSimulation()
 
 bool NItoModbusBridge::startAcquisition()
 {
-    // Check if the data acquisition timer is already active
-    if (m_dataAcquTimer->isActive())
+    // Check if the data acquisition job is already active
+    if (isAcquisitionActive())
     {
         return true; // Data acquisition is already running, return true
     }
@@ -493,17 +744,44 @@ bool NItoModbusBridge::startAcquisition()
         // Calculate the buffer size based on SRU mapping size without alarms
         int bufferSize = m_modbusServer->getSRUMappingSizeWithoutAlarms();
 
-        // Clear the realDataBufferLine to start with a clean slate
-        m_realDataBufferLine.clear();
+        {
+            std::lock_guard<std::mutex> lock(m_registerLineMutex);
+            // Clear the realDataBufferLine to start with a clean slate
+            m_realDataBufferLine.clear();
 
-        // Resize and initialize the realDataBufferLine with zeros
-        m_realDataBufferLine.resize(bufferSize, 0);
+            // Resize and initialize the realDataBufferLine with zeros
+            m_realDataBufferLine.resize(bufferSize, 0);
+            for (AnalogSourceGroup &group : m_analogSources)
+            {
+                group.lastFrameNumber = 0;
+                group.scaler.resetPublished();
+            }
+            for (CounterPlanGroup &group : m_counterPlan)
+            {
+                for (CounterPlanEntry &entry : group.entries)
+                {
+                    entry.published = false;
+                }
+            }
+            // The jobs only remap the registers of their rows, the others are cleared once here
+            m_modbusServer->reMapInputRegisterValuesForAnalogics(m_realDataBufferLine);
+        }
 
-        // Stop the simulation timer to avoid conflicts
-        m_simulateTimer->stop();
+        // Stop the simulation job to avoid conflicts
+        m_scheduler->stopJob(m_simulateJob);
 
-        // Start the data acquisition timer
-        m_dataAcquTimer->start();
+        // Start the data acquisition jobs, a rate group without rows stays stopped (fast always runs, it is the acquisition state)
+        for (int i = 0; i < rateGroupsCount; ++i)
+        {
+            if (i == fastRateGroup || !m_rateGroupRegisters[i].empty())
+            {
+                m_scheduler->startJob(m_rateGroupJobs[i]);
+            }
+        }
+#ifdef EventDrivenBridge
+        // The fast analogic registers follow the module frames, the jobs keep the counters and the slower rows
+        startEventThread();
+#endif
 
         return true; // Successfully started data acquisition
     }
@@ -525,8 +803,12 @@ void NItoModbusBridge::stopAcquisition()
 {
     try
     {
-        // Stop the data acquisition timer
-        m_dataAcquTimer->stop();
+        // Stop the data acquisition jobs
+        stopEventThread();
+        for (PeriodicScheduler::JobId jobId : m_rateGroupJobs)
+        {
+            m_scheduler->stopJob(jobId);
+        }
     }
     catch (const std::exception &e)
     {
@@ -537,70 +819,163 @@ void NItoModbusBridge::stopAcquisition()
     }
 }
 
-void NItoModbusBridge::acquireCounters() 
+void NItoModbusBridge::updateAnalogGroup(AnalogSourceGroup &group, std::vector<int> &dirtyRegisters)
+{
+    // Caller holds m_registerLineMutex
+    group.source->readFrame(group.frame.data(), group.frame.size(), &group.lastFrameNumber);
+    double *values = group.scaler.values();
+    for (size_t k = 0; k < group.channelIndexes.size(); ++k)
+    {
+        values[k] = group.frame[group.channelIndexes[k]];
+    }
+    group.scaler.scaleFrame(m_realDataBufferLine.data(), &dirtyRegisters);
+}
+
+void NItoModbusBridge::startEventThread()
 {
-    try {
-        // Iterate over each mapping configuration to handle counters
-        for (auto &config : m_mappingData) {
-            if (config.moduleType == ModuleType::isCounter) 
+    std::shared_ptr<AcquisitionEngine> engine = m_analogicReader ? m_analogicReader->getAcquisitionEngine() : nullptr;
+    if (!engine || m_eventThreadRunning.load())
+    {
+        return;
+    }
+    m_eventThreadRunning.store(true);
+    m_eventThread = std::thread([this]() { this->runEventThread(); });
+}
+
+void NItoModbusBridge::stopEventThread()
+{
+    m_eventThreadRunning.store(false);
+    if (m_eventThread.joinable())
+    {
+        m_eventThread.join();
+    }
+}
+
+void NItoModbusBridge::runEventThread()
+{
+    std::shared_ptr<AcquisitionEngine> engine = m_analogicReader->getAcquisitionEngine();
+    uint64_t frameEpoch = 0;
+    while (m_eventThreadRunning.load())
+    {
+        // The timeout only bounds the reaction to stopEventThread()
+        if (!engine->waitForNewFrames(frameEpoch, std::chrono::milliseconds(100)))
+        {
+            continue;
+        }
+        try
+        {
+            for (AnalogSourceGroup &group : m_analogSources)
             {
-                double counterValue = 0.0;
-                // Read the counter value using DigitalReader
-                try
+                // Medium and slow rows keep the period of their rate group
+                if (group.rateGroup != fastRateGroup || group.source->frameNumber() == group.lastFrameNumber)
                 {
-                    m_digitalReader->manualReadOneShot(config.module, config.channel, counterValue);
+                    continue;
                 }
-                catch(const std::exception& e)
+                // Only the changed registers of this module are copied to the modbus map, the server lock is held for a few words
+                std::lock_guard<std::mutex> lock(m_registerLineMutex);
+                m_eventDirtyRegisters.clear();
+                updateAnalogGroup(group, m_eventDirtyRegisters);
+                if (!m_eventDirtyRegisters.empty())
                 {
-                    std::cout<<"in\nvoid NItoModbusBridge::acquireCounters()\nException:\n"<<e.what()<<std::endl;
-                    appendCommentWithTimestamp(m_fileNamesContainer.niToModbusBridgeLogFile,"in\n"
-                                                                                             "void NItoModbusBridge::acquireCounters()\n"
-                                                                                             "Exception:\n" +std::string(e.what())); 
+                    m_modbusServer->reMapInputRegisters(m_realDataBufferLine, m_eventDirtyRegisters);
                 }
-                // Convert the read value to an unsigned integer
-                unsigned int counterIntValue = static_cast<unsigned int>(counterValue);
-                // Update current time and counter value
-                config.currentTime = std::chrono::steady_clock::now();
-                config.currentCounterValue = counterIntValue;
+            }
+        }
+        catch (const std::exception &e)
+        {
+            appendCommentWithTimestamp(m_fileNamesContainer.niToModbusBridgeLogFile,"in\nNItoModbusBridge::runEventThread()\nException:\n"+std::string(e.what()));
+            std::cerr << "Exception in runEventThread: " << e.what() << std::endl;
+        }
+    }
+}
 
-                double frequencyValue = 0.0;
-                // Calculate delta time in seconds
-                auto deltaTime = std::chrono::duration_cast<std::chrono::seconds>(config.currentTime - config.previousTime).count();
+void NItoModbusBridge::acquireCounters(RateGroup rateGroup, std::vector<int> &dirtyRegisters)
+{
+    try 
+    {
+        std::lock_guard<std::mutex> counterLock(m_counterMutex);
+        for (CounterPlanGroup &group : m_counterPlan)
+        {
+            if (!(group.rateGroupsMask & (1u << rateGroup)))
+            {
+                continue;
+            }
+            // One batched read per counter module, whatever the number of mapped rows
+            if (!m_digitalReader->readCounters(group.module, group.chanNames, group.values))
+            {
+                // The previous values are not fresh anymore: nothing of this group is published for this tick
+                appendCommentWithTimestamp(m_fileNamesContainer.niToModbusBridgeLogFile,
+                                           "in\n"
+                                           "void NItoModbusBridge::acquireCounters(RateGroup rateGroup, std::vector<int> &dirtyRegisters)\n"
+                                           "Error: reading counters of "+group.module->getAlias()+" failed, registers not updated");
+                continue;
+            }
+            const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+            // Nanosecond resolution rate over the module frequency window, updated on every tick
+            for (std::size_t i = 0; i < group.rates.size(); ++i)
+            {
+                group.rates[i].update(group.values[i], now);
+            }
 
-                if (deltaTime > 0) 
+            // The DAQmx read above stays outside of the lock, the event thread is only held for the register writes
+            std::lock_guard<std::mutex> lock(m_registerLineMutex);
+            for (CounterPlanEntry &entry : group.entries)
+            {
+                // The whole module was read, only the rows of this tick are published
+                if (entry.rateGroup != rateGroup)
                 {
-                    // Calculate the change in counter value
-                    unsigned int deltaCounter = config.currentCounterValue - config.previousCounterValue;
-                    // Calculate frequency (counts per second)
-                    frequencyValue = static_cast<double>(deltaCounter) / deltaTime;
+                    continue;
                 }
+                MappingConfig &config = m_mappingData[entry.mappingIndex];
+                const uint32_t counterIntValue = group.values[entry.valueIndex];
+                config.currentTime         = now;
+                config.currentCounterValue = counterIntValue;
 
-                // Use the min/max source and destination values directly from the config
-                uint16_t frequency = linearInterpolation16Bits(
-                    frequencyValue, // The calculated frequency
-                    config.minSource, config.maxSource, // Actual source range from configuration
-                    config.minDest, config.maxDest // Actual destination range from configuration
-                );
+                const double frequencyValue = group.rates[entry.valueIndex].getFrequency();
 
-                // Split the 32-bit counter value into two 16-bit values
-                uint16_t highValue = static_cast<uint16_t>((counterIntValue >> 16) & 0xFFFF);
-                uint16_t lowValue = static_cast<uint16_t>(counterIntValue & 0xFFFF);
+                // Precomputed linear interpolation, clamped to the destination range
+                double frequency = entry.offset + entry.scale * frequencyValue;
+                if (frequency < entry.minDest)
+                {
+                    frequency = entry.minDest;
+                }
+                else if (frequency > entry.maxDest)
+                {
+                    frequency = entry.maxDest;
+                }
 
-                // Update the Modbus server registers
-                int firstDestinationRegister = config.modbusChannel;
-                m_realDataBufferLine[firstDestinationRegister] = frequency;
-                m_realDataBufferLine[firstDestinationRegister + 1] = highValue;
-                m_realDataBufferLine[firstDestinationRegister + 2] = lowValue;
+                // Frequency then the 32-bit counter value split into two 16-bit registers, only the changed ones are dirty
+                const uint16_t words[3] = {static_cast<uint16_t>(frequency),
+                                           static_cast<uint16_t>((counterIntValue >> 16) & 0xFFFF),
+                                           static_cast<uint16_t>(counterIntValue & 0xFFFF)};
+                const bool frequencyMoved = !entry.published || entry.deadband <= 0.0
+                                            || std::fabs(frequencyValue - entry.publishedFrequency) >= entry.deadband;
+                for (int k = 0; k < 3; ++k)
+                {
+                    uint16_t &reg = m_realDataBufferLine[entry.destinationRegister + k];
+                    if ((reg == words[k] && entry.published) || (k == 0 && !frequencyMoved))
+                    {
+                        continue;
+                    }
+                    reg = words[k];
+                    dirtyRegisters.push_back(entry.destinationRegister + k);
+                    if (k == 0)
+                    {
+                        entry.publishedFrequency = frequencyValue;
+                    }
+                }
+                entry.published = true;
 
                 // Prepare for next acquisition by updating previous time and counter values
-                config.previousTime = config.currentTime;
+                config.previousTime         = config.currentTime;
                 config.previousCounterValue = config.currentCounterValue;
             }
         }
     } 
     catch (const std::exception &e) 
     {
-        appendCommentWithTimestamp(m_fileNamesContainer.niToModbusBridgeLogFile,"in\nNItoModbusBridge::acquireCounters()\nException:\n"+std::string(e.what())); 
+        appendCommentWithTimestamp(m_fileNamesContainer.niToModbusBridgeLogFile,"in\nNItoModbusBridge::acquireCounters(RateGroup rateGroup, std::vector<int> &dirtyRegisters)\nException:\n"+std::string(e.what())); 
         std::cerr << "Exception in acquireCounters: " << e.what() << std::endl;
     }
 }
@@ -844,6 +1219,62 @@ void NItoModbusBridge::simulateCoders(std::vector<uint16_t> &analogChannelsResul
     }
 }
 
+bool NItoModbusBridge::setRelays(const std::vector<uint16_t> &coilsAddr, const std::vector<bool> &states, std::vector<uint16_t> *failedCoils)
+{
+    if (!m_digitalWriter)
+    {
+        appendCommentWithTimestamp(m_fileNamesContainer.niToModbusBridgeLogFile,
+                                    "in\n"
+                                    "bool NItoModbusBridge::setRelays(const std::vector<uint16_t> &coilsAddr, const std::vector<bool> &states, std::vector<uint16_t> *failedCoils)\n"
+                                    "Error : m_digitalWriter is nullptr"); 
+        if (failedCoils)
+        {
+            failedCoils->insert(failedCoils->end(), coilsAddr.begin(), coilsAddr.end());
+        }
+        return false;
+    }
+
+    // Group the requested lines by module so that each module is written in one go
+    std::map<std::string, std::vector<std::pair<std::string, bool>>> linesByModule;
+    std::map<std::string, std::vector<uint16_t>>                     coilsByModule;
+    for (std::size_t i = 0; i < coilsAddr.size() && i < states.size(); ++i)
+    {
+        bool found = false;
+        for (const AlarmsMappingConfig &config : m_alarmsMappingData)
+        {
+            if (coilsAddr[i] == config.modbusCoilsChannel)
+            {
+                linesByModule[config.module].emplace_back(config.channel, states[i]);
+                coilsByModule[config.module].push_back(coilsAddr[i]);
+                found = true;
+                break;
+            }
+        }
+        if (!found)
+        {
+            appendCommentWithTimestamp(m_fileNamesContainer.niToModbusBridgeLogFile,
+                                "in\n"
+                                "bool NItoModbusBridge::setRelays(const std::vector<uint16_t> &coilsAddr, const std::vector<bool> &states, std::vector<uint16_t> *failedCoils)\n"
+                                "Error : Relay "+std::to_string(coilsAddr[i])+" not found inside alarmsMapping"); 
+        }
+    }
+
+    bool written = true;
+    for (const auto &module : linesByModule)
+    {
+        if (!m_digitalWriter->manualSetOutputs(module.first, module.second))
+        {
+            written = false;
+            if (failedCoils)
+            {
+                const std::vector<uint16_t> &moduleCoils = coilsByModule[module.first];
+                failedCoils->insert(failedCoils->end(), moduleCoils.begin(), moduleCoils.end());
+            }
+        }
+    }
+    return written;
+}
+
 void NItoModbusBridge::simulateRelays() 
 {
     bool relay[4] = {false,false,false,false};
@@ -853,67 +1284,56 @@ void NItoModbusBridge::simulateRelays()
         relay[i] =  m_simulatedAlarmStepCounter==i;
     }
    
-    // Iterate through each relay configuration defined in the mapping data.
+    // Every simulated relay sits on Mod6 port0, the whole step is a single port write
     std::string modAlias = "Mod6";
-    for (int i = 0; i < m_modbusServer->getSRUMapping().m_nbSRUAlarms; ++i)
-    {       std::string chanStr = "/port0/line" + std::to_string(i);
-            bool newState = relay[i];
-            try 
-            {
-                m_digitalWriter->manualSetOutput(modAlias, chanStr, newState);
-            } 
-            catch (const std::exception& e) 
-            {
-                
-                appendCommentWithTimestamp(m_fileNamesContainer.niToModbusBridgeLogFile,
-                                           "in\n"
-                                           "NItoModbusBridge::simulateRelays()\n"
-                                           "Error: impossible to simulate relay state\n"+std::string(e.what()));
-                std::cerr << "Error simulating relay state: " << e.what() << std::endl;
-            }
-        
+    std::vector<std::pair<std::string, bool>> lineStates;
+    for (int i = 0; i < m_modbusServer->getSRUMapping().m_nbSRUAlarms && i < 4; ++i)
+    {
+        lineStates.emplace_back("/port0/line" + std::to_string(i), relay[i]);
     }
+    m_digitalWriter->manualSetOutputs(modAlias, lineStates);
     m_simulatedAlarmStepCounter = (m_simulatedAlarmStepCounter + 1) % 4;    
 }
 
 
 
-void NItoModbusBridge::acquireData()
+void NItoModbusBridge::acquireData(RateGroup rateGroup)
 {
     try
     {    
-        // Iterate through the mapping data
-        for (std::size_t i = 0; i < m_mappingData.size(); ++i)
+        // Analogic rows of the group: each module frame is read once and scaled in one vectorized pass,
+        // the event thread does it for the fast rows as soon as the frame is published
+        const bool analogsByEvents = rateGroup == fastRateGroup && m_eventThreadRunning.load();
+        std::vector<int> &dirtyRegisters = m_rateGroupDirtyRegisters[rateGroup];
+        dirtyRegisters.clear();
+        if (!analogsByEvents)
+        {
+            std::lock_guard<std::mutex> lock(m_registerLineMutex);
+            for (AnalogSourceGroup &group : m_analogSources)
+            {
+                if (group.rateGroup == rateGroup)
+                {
+                    updateAnalogGroup(group, dirtyRegisters);
+                }
+            }
+        }
+
+        // Counter rows of the group: every counter read once, frequency and 32-bit count written in the same pass
+        acquireCounters(rateGroup, dirtyRegisters);
+
+        // Other rows, on the fast tick
+        const std::vector<std::size_t>  noRows;
+        const std::vector<std::size_t> &otherRows = (rateGroup == fastRateGroup) ? m_otherRows : noRows;
+        for (std::size_t i : otherRows)
         { 
-          // Retrieve the configuration for the current mapping line
-           MappingConfig lineCfg = m_mappingData[i];
-          // 
-          // // Initialize variables
-           double   result              = 0.0                  ;
-           double   minInput            = lineCfg.minSource    ;
-           double   maxInput            = lineCfg.maxSource    ;
-           uint16_t minOutput           = lineCfg.minDest      ;
-           uint16_t maxOutput           = lineCfg.maxDest      ;
-           int      destinationRegister = lineCfg.modbusChannel;
-           std::string modName          = lineCfg.module       ;
-           std::string chanName         = lineCfg.channel      ;
-           
+           const MappingConfig &lineCfg = m_mappingData[i];
 
            switch (lineCfg.moduleType)
            {
-               // We have the same function  process  whether Moule Type is  AnalogicInputCurrent or AnalogicInputVoltage.
                case ModuleType::isAnalogicInputCurrent:
                case ModuleType::isAnalogicInputVoltage:
                {
-                   // Read analog data
-                   m_analogicReader->manualReadOneShot(lineCfg.module, lineCfg.channel, result);
-                   // Perform linear interpolation
-                   uint16_t interpolatedResult = linearInterpolation16Bits(result, minInput, maxInput, minOutput, maxOutput);
-                   
-                   // Update the real data buffer line
-                   m_realDataBufferLine[destinationRegister] = interpolatedResult;
-                   
-
+                   // Compiled into m_analogPlan
                    break;
                }
                
@@ -924,7 +1344,7 @@ void NItoModbusBridge::acquireData()
                }
                case ModuleType::isCounter:
                {
-                   acquireCounters();
+                   // Compiled into m_counterPlan
                    break;
                }
                case ModuleType::isDigitalInput:
@@ -940,8 +1360,12 @@ void NItoModbusBridge::acquireData()
            }
         }
         
-        // Remap the input register values for analogics
-        m_modbusServer->reMapInputRegisterValuesForAnalogics(m_realDataBufferLine);
+        // Remap only the input registers changed by this tick
+        if (!dirtyRegisters.empty())
+        {
+            std::lock_guard<std::mutex> lock(m_registerLineMutex);
+            m_modbusServer->reMapInputRegisters(m_realDataBufferLine, dirtyRegisters);
+        }
     }
     catch (const std::exception &e)
     {
@@ -952,18 +1376,18 @@ void NItoModbusBridge::acquireData()
     }
 }
 
-void NItoModbusBridge::onDataAcquisitionTimerTimeOut()
+void NItoModbusBridge::onDataAcquisitionTimerTimeOut(RateGroup rateGroup)
 {
     try
     {
-        // Trigger data acquisition
-        acquireData();
+        // Trigger data acquisition of the rows due on this tick
+        acquireData(rateGroup);
     }
     catch (const std::exception &e)
     {
         // Handle any exceptions that may occur during timer timeout
         // Log the error message for debugging purposes
-        appendCommentWithTimestamp(m_fileNamesContainer.niToModbusBridgeLogFile,"in NItoModbusBridge::onDataAcquisitionTimerTimeOut() An exception occurred: "+std::string(e.what()));
+        appendCommentWithTimestamp(m_fileNamesContainer.niToModbusBridgeLogFile,"in NItoModbusBridge::onDataAcquisitionTimerTimeOut(RateGroup rateGroup) An exception occurred: "+std::string(e.what()));
         std::cerr << "An exception occurred: " << e.what() << std::endl;
     }
 }
@@ -973,16 +1397,20 @@ ThreadSafeCircularBuffer<std::vector<uint16_t>>& NItoModbusBridge::getSimulation
     return m_simulationBuffer;
 }
 
-// Getter for m_simulateTimer
-std::shared_ptr<SimpleTimer> NItoModbusBridge::getSimulateTimer() const 
+// Getter for m_scheduler
+std::shared_ptr<PeriodicScheduler> NItoModbusBridge::getScheduler() const 
+{
+    return m_scheduler;
+}
+
+bool NItoModbusBridge::isModbusSimulationActive() const
 {
-    return m_simulateTimer;
+    return m_scheduler->isJobActive(m_simulateJob);
 }
 
-// Getter for m_dataAcquTimer
-std::shared_ptr<SimpleTimer> NItoModbusBridge::getDataAcquTimer() const 
+bool NItoModbusBridge::isAcquisitionActive() const
 {
-    return m_dataAcquTimer;
+    return m_scheduler->isJobActive(m_rateGroupJobs[fastRateGroup]);
 }
 
 // Getter for m_modbusServer
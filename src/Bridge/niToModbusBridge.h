@@ -3,27 +3,88 @@
 
 #include <memory>
 #include <functional>
+#include <thread>
+#include <mutex>
+#include <atomic>
 
 #include "../channelReaders/analogicReader.h"
 #include "../channelReaders/digitalReader.h"
 #include "../channelWriters/digitalWriter.h"
 #include "../Modbus/NewModbusServer.h"
 #include "../globals/globalEnumStructs.h"
-#include "../timers/simpleTimer.h"
+#include "../timers/periodicScheduler.h"
 #include "../threadSafeBuffers/ThreadSafeCircularBuffer.h"
 #include "../stringUtils/stringUtils.h"
+#include "../Filters/CounterRateEstimator.h"
+#include "registerFrameScaler.h"
 #include "../filesUtils/appendToFileHelper.h"
 #include <algorithm> 
 
 
+// One analogic row of mapping.csv compiled once by loadMapping():
+// the source frame store and channel position are resolved and the linear interpolation
+// is reduced to register = offset + scale * value, clamped to [minDest, maxDest]
+struct MappingPlanEntry {
+    const SeqlockFrameStore<double> *source              = nullptr; // latest frame of the module, owned by the acquisition engine
+    size_t                           channelIndex        = 0;       // position of the channel inside the frame
+    double                           scale               = 0.0;     // (maxDest - minDest) / (maxSource - minSource)
+    double                           offset              = 0.0;     // minDest - scale * minSource
+    double                           minDest             = 0.0;
+    double                           maxDest             = 0.0;
+    int                              destinationRegister = 0;       // index in the register line
+    double                           deadband            = 0.0;     // source units, 0 publishes every change
+    std::size_t                      mappingIndex        = 0;       // row in m_mappingData, for diagnostics only
+};
+
+// Analogic rows reading the same module in the same rate group: its frame is copied once per update,
+// then every row picks its channel into the values of the group scaler (row k of the group is scaler row k)
+struct AnalogSourceGroup {
+    const SeqlockFrameStore<double> *source              = nullptr;
+    RateGroup                        rateGroup           = fastRateGroup;
+    std::vector<double>              frame               ;          // latest frame of the module
+    std::vector<size_t>              channelIndexes      ;          // channel of each row of the group
+    RegisterFrameScaler              scaler              ;          // scale, offset and clamp of the rows of the group
+    uint64_t                         lastFrameNumber     = 0;       // frame of the source already in the register line
+};
+
+// One counter row of mapping.csv: the row owns three consecutive registers,
+// frequency (offset + scale * frequency, clamped), then the high and low words of the 32-bit count
+struct CounterPlanEntry {
+    size_t                                valueIndex          = 0;   // position of the counter in CounterPlanGroup::values and rates
+    double                                scale               = 0.0;
+    double                                offset              = 0.0;
+    double                                minDest             = 0.0;
+    double                                maxDest             = 0.0;
+    int                                   destinationRegister = 0;   // frequency register, count follows in +1 and +2
+    double                                deadband            = 0.0; // Hz, applies to the frequency register only
+    double                                publishedFrequency  = 0.0; // frequency of the last written frequency register
+    bool                                  published           = false;
+    std::size_t                           mappingIndex        = 0;   // row in m_mappingData, previous count and time live there
+    RateGroup                             rateGroup           = fastRateGroup; // the tick publishing this row
+};
+
+// Every counter row of one module, read with a single DigitalReader::readCounters() per tick.
+// The wrapper keeps one set of counter tasks per module, so the module is never split between rate groups:
+// it is read on the ticks of every rate group it serves and each tick only publishes its own rows
+struct CounterPlanGroup {
+    NIDeviceModule                       *module              = nullptr;
+    unsigned int                          rateGroupsMask      = 0;   // bit (1 << rateGroup) of every rate group with rows on the module
+    std::vector<std::string>              chanNames           ;      // distinct front terminals, in read order
+    std::vector<uint32_t>                 values              ;      // counts of the last tick, same order as chanNames
+    std::vector<CounterRateEstimator>     rates               ;      // sliding window frequency of each counter, same order
+    std::vector<CounterPlanEntry>         entries             ;
+};
+
 
 class NItoModbusBridge {
 public:
     // Constructor
-    NItoModbusBridge  (std::shared_ptr<AnalogicReader>  analogicReader,
-                       std::shared_ptr<DigitalReader>   digitalReader,
-                       std::shared_ptr<DigitalWriter>   digitalWriter,
-                       std::shared_ptr<NewModbusServer> modbusServer);
+    NItoModbusBridge  (std::shared_ptr<AnalogicReader>    analogicReader,
+                       std::shared_ptr<DigitalReader>     digitalReader,
+                       std::shared_ptr<DigitalWriter>     digitalWriter,
+                       std::shared_ptr<NewModbusServer>   modbusServer,
+                       std::shared_ptr<PeriodicScheduler> scheduler);
+    ~NItoModbusBridge ();
 
     // Getters and setters for AnalogicReader
     std::shared_ptr<AnalogicReader> getAnalogicReader() const;
@@ -36,8 +97,7 @@ public:
 
 
     ThreadSafeCircularBuffer<std::vector<uint16_t>>& getSimulationBuffer();
-    std::shared_ptr<SimpleTimer>       getSimulateTimer()  const;
-    std::shared_ptr<SimpleTimer>       getDataAcquTimer()  const;
+    std::shared_ptr<PeriodicScheduler> getScheduler()      const;
     std::shared_ptr<NewModbusServer>   getModbusServer()   const;
     const std::vector<MappingConfig>&  getMappingData()    const;
 
@@ -47,11 +107,15 @@ public:
 
     bool startModbusSimulation();
     void stopModbusSimulation();
+    bool isModbusSimulationActive() const;
     bool startAcquisition();
     void stopAcquisition();
+    bool isAcquisitionActive() const;
 
-    void acquireCounters();
+    void acquireCounters(RateGroup rateGroup, std::vector<int> &dirtyRegisters);
     void setRelays(uint16_t coilAddr, bool state);
+    // Returns false when a relay write failed, the coils of the failed modules are appended to failedCoils when given
+    bool setRelays(const std::vector<uint16_t> &coilsAddr, const std::vector<bool> &states, std::vector<uint16_t> *failedCoils = nullptr);
     
 
 
@@ -60,18 +124,38 @@ protected:
     GlobalFileNamesContainer                             m_fileNamesContainer;
     ThreadSafeCircularBuffer<std::vector<uint16_t>>      m_simulationBuffer  ;
     ThreadSafeCircularBuffer<std::vector<uint16_t>>      m_realDataBuffer    ;         
-    std::shared_ptr<SimpleTimer>                         m_simulateTimer     ;
-    std::shared_ptr<SimpleTimer>                         m_dataAcquTimer     ;
+    std::shared_ptr<PeriodicScheduler>                   m_scheduler         ;
+    PeriodicScheduler::JobId                             m_simulateJob       ; // 250 ms simulation tick
+    PeriodicScheduler::JobId                             m_rateGroupJobs     [rateGroupsCount]; // publication tick of each rate group
+    int                                                  m_rateGroupPeriodsMs[rateGroupsCount]; // from modbus.ini [rategroups]
+    std::vector<int>                                     m_rateGroupRegisters[rateGroupsCount]; // registers written by each rate group
+    std::vector<int>                                     m_rateGroupDirtyRegisters[rateGroupsCount]; // registers changed by a tick of the rate group, only ones remapped
+    std::vector<int>                                     m_eventDirtyRegisters; // same for the event thread
     std::shared_ptr<AnalogicReader>                      m_analogicReader    ;
     std::shared_ptr<DigitalReader>                       m_digitalReader     ;  
     std::shared_ptr<DigitalWriter>                       m_digitalWriter     ;
     std::shared_ptr<NewModbusServer>                     m_modbusServer      ;
     std::vector<MappingConfig>                           m_mappingData       ;
     std::vector<AlarmsMappingConfig>                     m_alarmsMappingData ;
+    std::vector<MappingPlanEntry>                        m_analogPlan        ; // analogic rows compiled by loadMapping()
+    std::vector<AnalogSourceGroup>                       m_analogSources     ; // m_analogPlan grouped by module frame
+    std::vector<CounterPlanGroup>                        m_counterPlan       ; // counter rows compiled by loadMapping(), one group per module
+    std::vector<std::size_t>                             m_otherRows         ; // rows not covered by the plans (coders, digital inputs...)
 
     std::vector<uint16_t>                                m_realDataBufferLine; // a Real Buffer Data
-
-    void acquireData();
+    std::mutex                                           m_registerLineMutex ; // m_realDataBufferLine is written by the tick and by the event thread
+    std::mutex                                           m_counterMutex      ; // a counter module served by several rate groups is read by one tick at a time
+    std::thread                                          m_eventThread       ; // EventDrivenBridge: publishes each module frame as soon as it is acquired
+    std::atomic<bool>                                    m_eventThreadRunning{false};
+
+    void acquireData(RateGroup rateGroup);
+    void loadRateGroupPeriods();
+    void updateAnalogGroup(AnalogSourceGroup &group, std::vector<int> &dirtyRegisters);
+    void startEventThread ();
+    void stopEventThread  ();
+    void runEventThread   ();
+    void compileMappingPlan();
+    void compileCounterRow(std::size_t mappingIndex, int registersCount);
 
     uint16_t linearInterpolation16Bits(double value, double minSource, double maxSource, uint16_t minDestination, uint16_t maxDestination);
     void onSimulationTimerTimeOut ();
@@ -85,7 +169,7 @@ protected:
 
 
     
-    void onDataAcquisitionTimerTimeOut();
+    void onDataAcquisitionTimerTimeOut(RateGroup rateGroup);
     
 
     // Signal functions to notify changes
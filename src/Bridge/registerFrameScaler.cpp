@@ -0,0 +1,286 @@
+#include "registerFrameScaler.h"
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+  #include <immintrin.h>
+  #define REGISTERFRAMESCALER_X86 1
+#endif
+
+// Same operation order as the vector kernels, so every path gives the same register
+static inline void scaleRowsScalar(const double *scales, const double *offsets, const double *minDests, const double *maxDests,
+                                   const double *values, uint16_t *results, size_t begin, size_t end)
+{
+    for (size_t i = begin; i < end; ++i)
+    {
+        double mappedValue = offsets[i] + scales[i] * values[i];
+        if (!(mappedValue >= minDests[i]))
+        {
+            mappedValue = minDests[i];
+        }
+        else if (mappedValue > maxDests[i])
+        {
+            mappedValue = maxDests[i];
+        }
+        results[i] = static_cast<uint16_t>(mappedValue);
+    }
+}
+
+// Sets the bit of each row whose register changed or was never written, unless its deadband holds it.
+// deadbands is null when no row has one. Against a NaN published value the deadband test is false:
+// the first frame is always written
+static inline void changedRowsScalar(const uint16_t *results, const uint16_t *publishedResults, const double *values,
+                                     const double *publishedValues, const double *deadbands, uint64_t *writeMask,
+                                     size_t begin, size_t end)
+{
+    for (size_t i = begin; i < end; ++i)
+    {
+        bool write = results[i] != publishedResults[i] || std::isnan(publishedValues[i]);
+        if (write && deadbands)
+        {
+            write = !(std::fabs(values[i] - publishedValues[i]) < deadbands[i]);
+        }
+        if (write)
+        {
+            writeMask[i >> 6] |= 1ULL << (i & 63);
+        }
+    }
+}
+
+static inline unsigned int lowestBit(uint64_t bits)
+{
+#if defined(__GNUC__)
+    return static_cast<unsigned int>(__builtin_ctzll(bits));
+#else
+    unsigned int index = 0;
+    while (!(bits & 1))
+    {
+        bits >>= 1;
+        ++index;
+    }
+    return index;
+#endif
+}
+
+#ifdef REGISTERFRAMESCALER_X86
+
+static inline void scaleRowsSse2(const double *scales, const double *offsets, const double *minDests, const double *maxDests,
+                                 const double *values, uint16_t *results, size_t count)
+{
+    // SSE2 has no unsigned 32 -> 16 bit saturation: shift to the signed range, pack, shift back
+    const __m128i bias     = _mm_set1_epi32(32768);
+    const __m128i signFlip = _mm_set1_epi16(static_cast<short>(0x8000));
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128d low  = _mm_add_pd(_mm_loadu_pd(offsets + i),     _mm_mul_pd(_mm_loadu_pd(scales + i),     _mm_loadu_pd(values + i)));
+        __m128d high = _mm_add_pd(_mm_loadu_pd(offsets + i + 2), _mm_mul_pd(_mm_loadu_pd(scales + i + 2), _mm_loadu_pd(values + i + 2)));
+        // max returns its second operand when the first is NaN: a NaN value becomes minDest
+        low  = _mm_min_pd(_mm_max_pd(low,  _mm_loadu_pd(minDests + i)),     _mm_loadu_pd(maxDests + i));
+        high = _mm_min_pd(_mm_max_pd(high, _mm_loadu_pd(minDests + i + 2)), _mm_loadu_pd(maxDests + i + 2));
+        __m128i words = _mm_unpacklo_epi64(_mm_cvttpd_epi32(low), _mm_cvttpd_epi32(high));
+        words = _mm_xor_si128(_mm_packs_epi32(_mm_sub_epi32(words, bias), _mm_setzero_si128()), signFlip);
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(results + i), words);
+    }
+    scaleRowsScalar(scales, offsets, minDests, maxDests, values, results, i, count);
+}
+
+__attribute__((target("avx2")))
+static inline void scaleRowsAvx2(const double *scales, const double *offsets, const double *minDests, const double *maxDests,
+                                 const double *values, uint16_t *results, size_t count)
+{
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        // mul then add, no fma: the rounding stays the one of the scalar path
+        __m256d low  = _mm256_add_pd(_mm256_loadu_pd(offsets + i),     _mm256_mul_pd(_mm256_loadu_pd(scales + i),     _mm256_loadu_pd(values + i)));
+        __m256d high = _mm256_add_pd(_mm256_loadu_pd(offsets + i + 4), _mm256_mul_pd(_mm256_loadu_pd(scales + i + 4), _mm256_loadu_pd(values + i + 4)));
+        low  = _mm256_min_pd(_mm256_max_pd(low,  _mm256_loadu_pd(minDests + i)),     _mm256_loadu_pd(maxDests + i));
+        high = _mm256_min_pd(_mm256_max_pd(high, _mm256_loadu_pd(minDests + i + 4)), _mm256_loadu_pd(maxDests + i + 4));
+        const __m128i words = _mm_packus_epi32(_mm256_cvttpd_epi32(low), _mm256_cvttpd_epi32(high));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(results + i), words);
+    }
+    scaleRowsScalar(scales, offsets, minDests, maxDests, values, results, i, count);
+}
+
+static inline void changedRowsSse2(const uint16_t *results, const uint16_t *publishedResults, const double *values,
+                                   const double *publishedValues, const double *deadbands, uint64_t *writeMask, size_t count)
+{
+    const __m128d absMask = _mm_castsi128_pd(_mm_set1_epi64x(0x7FFFFFFFFFFFFFFFLL));
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        const __m128i same = _mm_cmpeq_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(results + i)),
+                                             _mm_loadu_si128(reinterpret_cast<const __m128i *>(publishedResults + i)));
+        unsigned int bits = ~static_cast<unsigned int>(_mm_movemask_epi8(_mm_packs_epi16(same, _mm_setzero_si128()))) & 0xFF;
+        for (size_t k = 0; k < 8; k += 2)
+        {
+            const __m128d published = _mm_loadu_pd(publishedValues + i + k);
+            bits |= static_cast<unsigned int>(_mm_movemask_pd(_mm_cmpunord_pd(published, published))) << k;
+        }
+        if (bits && deadbands)
+        {
+            unsigned int held = 0;
+            for (size_t k = 0; k < 8; k += 2)
+            {
+                const __m128d moved = _mm_and_pd(_mm_sub_pd(_mm_loadu_pd(values + i + k), _mm_loadu_pd(publishedValues + i + k)), absMask);
+                held |= static_cast<unsigned int>(_mm_movemask_pd(_mm_cmplt_pd(moved, _mm_loadu_pd(deadbands + i + k)))) << k;
+            }
+            bits &= ~held;
+        }
+        writeMask[i >> 6] |= static_cast<uint64_t>(bits) << (i & 63);
+    }
+    changedRowsScalar(results, publishedResults, values, publishedValues, deadbands, writeMask, i, count);
+}
+
+__attribute__((target("avx2")))
+static inline void changedRowsAvx2(const uint16_t *results, const uint16_t *publishedResults, const double *values,
+                                   const double *publishedValues, const double *deadbands, uint64_t *writeMask, size_t count)
+{
+    const __m256d absMask = _mm256_castsi256_pd(_mm256_set1_epi64x(0x7FFFFFFFFFFFFFFFLL));
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        const __m128i same = _mm_cmpeq_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(results + i)),
+                                             _mm_loadu_si128(reinterpret_cast<const __m128i *>(publishedResults + i)));
+        unsigned int bits = ~static_cast<unsigned int>(_mm_movemask_epi8(_mm_packs_epi16(same, _mm_setzero_si128()))) & 0xFF;
+        const __m256d publishedLow  = _mm256_loadu_pd(publishedValues + i);
+        const __m256d publishedHigh = _mm256_loadu_pd(publishedValues + i + 4);
+        bits |= static_cast<unsigned int>(_mm256_movemask_pd(_mm256_cmp_pd(publishedLow,  publishedLow,  _CMP_UNORD_Q)))
+             | (static_cast<unsigned int>(_mm256_movemask_pd(_mm256_cmp_pd(publishedHigh, publishedHigh, _CMP_UNORD_Q))) << 4);
+        if (bits && deadbands)
+        {
+            const __m256d movedLow  = _mm256_and_pd(_mm256_sub_pd(_mm256_loadu_pd(values + i),     publishedLow),  absMask);
+            const __m256d movedHigh = _mm256_and_pd(_mm256_sub_pd(_mm256_loadu_pd(values + i + 4), publishedHigh), absMask);
+            const unsigned int held = static_cast<unsigned int>(_mm256_movemask_pd(_mm256_cmp_pd(movedLow,  _mm256_loadu_pd(deadbands + i),     _CMP_LT_OQ)))
+                                   | (static_cast<unsigned int>(_mm256_movemask_pd(_mm256_cmp_pd(movedHigh, _mm256_loadu_pd(deadbands + i + 4), _CMP_LT_OQ))) << 4);
+            bits &= ~held;
+        }
+        writeMask[i >> 6] |= static_cast<uint64_t>(bits) << (i & 63);
+    }
+    changedRowsScalar(results, publishedResults, values, publishedValues, deadbands, writeMask, i, count);
+}
+
+static inline bool hasAvx2()
+{
+    static const bool avx2 = __builtin_cpu_supports("avx2");
+    return avx2;
+}
+
+#endif // REGISTERFRAMESCALER_X86
+
+void RegisterFrameScaler::clear()
+{
+    m_scales.clear();
+    m_offsets.clear();
+    m_minDests.clear();
+    m_maxDests.clear();
+    m_destinations.clear();
+    m_deadbands.clear();
+    m_publishedValues.clear();
+    m_publishedResults.clear();
+    m_writeMask.clear();
+    m_hasDeadbands = false;
+    m_values.clear();
+    m_results.clear();
+}
+
+size_t RegisterFrameScaler::addRow(double scale, double offset, double minDest, double maxDest, int destinationRegister, double deadband)
+{
+    m_scales.push_back(scale);
+    m_offsets.push_back(offset);
+    m_minDests.push_back(minDest);
+    m_maxDests.push_back(maxDest);
+    m_destinations.push_back(destinationRegister);
+    m_deadbands.push_back(deadband > 0.0 ? deadband : 0.0);
+    m_publishedValues.push_back(std::numeric_limits<double>::quiet_NaN());
+    m_publishedResults.push_back(0);
+    m_hasDeadbands = m_hasDeadbands || deadband > 0.0;
+    m_values.push_back(0.0);
+    m_results.push_back(0);
+    m_writeMask.resize((m_values.size() + 63) / 64);
+    return m_values.size() - 1;
+}
+
+size_t RegisterFrameScaler::size() const
+{
+    return m_values.size();
+}
+
+double *RegisterFrameScaler::values()
+{
+    return m_values.data();
+}
+
+const uint16_t *RegisterFrameScaler::results() const
+{
+    return m_results.data();
+}
+
+const std::vector<int> &RegisterFrameScaler::destinations() const
+{
+    return m_destinations;
+}
+
+void RegisterFrameScaler::scaleValues()
+{
+    const size_t count = m_values.size();
+#ifdef REGISTERFRAMESCALER_X86
+    if (hasAvx2())
+    {
+        scaleRowsAvx2(m_scales.data(), m_offsets.data(), m_minDests.data(), m_maxDests.data(), m_values.data(), m_results.data(), count);
+        return;
+    }
+    scaleRowsSse2(m_scales.data(), m_offsets.data(), m_minDests.data(), m_maxDests.data(), m_values.data(), m_results.data(), count);
+#else
+    scaleRowsScalar(m_scales.data(), m_offsets.data(), m_minDests.data(), m_maxDests.data(), m_values.data(), m_results.data(), 0, count);
+#endif
+}
+
+void RegisterFrameScaler::resetPublished()
+{
+    std::fill(m_publishedValues.begin(), m_publishedValues.end(), std::numeric_limits<double>::quiet_NaN());
+}
+
+size_t RegisterFrameScaler::scaleFrame(uint16_t *registers, std::vector<int> *dirtyRegisters)
+{
+    scaleValues();
+    const size_t  count     = m_results.size();
+    const double *deadbands = m_hasDeadbands ? m_deadbands.data() : nullptr;
+    std::fill(m_writeMask.begin(), m_writeMask.end(), 0);
+#ifdef REGISTERFRAMESCALER_X86
+    if (hasAvx2())
+    {
+        changedRowsAvx2(m_results.data(), m_publishedResults.data(), m_values.data(), m_publishedValues.data(), deadbands, m_writeMask.data(), count);
+    }
+    else
+    {
+        changedRowsSse2(m_results.data(), m_publishedResults.data(), m_values.data(), m_publishedValues.data(), deadbands, m_writeMask.data(), count);
+    }
+#else
+    changedRowsScalar(m_results.data(), m_publishedResults.data(), m_values.data(), m_publishedValues.data(), deadbands, m_writeMask.data(), 0, count);
+#endif
+
+    // Only the rows of the mask are scattered
+    size_t written = 0;
+    for (size_t word = 0; word < m_writeMask.size(); ++word)
+    {
+        uint64_t bits = m_writeMask[word];
+        while (bits)
+        {
+            const size_t i = word * 64 + lowestBit(bits);
+            bits &= bits - 1;
+            registers[m_destinations[i]] = m_results[i];
+            m_publishedResults[i]        = m_results[i];
+            m_publishedValues[i]         = m_values[i];
+            ++written;
+            if (dirtyRegisters)
+            {
+                dirtyRegisters->push_back(m_destinations[i]);
+            }
+        }
+    }
+    return written;
+}
@@ -0,0 +1,52 @@
+#ifndef REGISTERFRAMESCALER_H
+#define REGISTERFRAMESCALER_H
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+// Batch conversion of every analogic row of the mapping into its 16 bit modbus register.
+// The rows are stored as structure of arrays, filled once by NItoModbusBridge::compileMappingPlan():
+// register = clamp(offset + scale * value, minDest, maxDest), truncated like static_cast<uint16_t>.
+// A frame is converted in one vectorized pass (AVX2 when the CPU has it, SSE2 otherwise on x86_64,
+// scalar elsewhere), then the results are scattered to their destination registers.
+// A NaN value gives minDest. The destination range must satisfy 0 <= minDest <= maxDest <= 65535.
+// A row with a deadband (source units) keeps its register until the value moved by at least the deadband
+// from the last published one, and a register is only written when its value changes.
+// The change and deadband tests are a second vectorized pass building a bit mask of the rows to write,
+// made against the last register written by each row: the scaler owns its destination registers,
+// resetPublished() must follow any other change of them.
+class RegisterFrameScaler {
+public:
+    void            clear        ();
+    // Returns the row index, the caller writes the value of that row in values()[index] before scaleFrame()
+    size_t          addRow       (double scale, double offset, double minDest, double maxDest, int destinationRegister, double deadband = 0.0);
+    size_t          size         () const;
+
+    double         *values       ();
+    const uint16_t *results      () const;
+    const std::vector<int> &destinations () const;
+    // Next scaleFrame() publishes every row whatever its deadband (registers line cleared...)
+    void            resetPublished();
+    // Converts every row and writes each changed register of the frame into registers[destinationRegister],
+    // the written destinations are appended to dirtyRegisters when given. Returns the number of written registers
+    size_t          scaleFrame   (uint16_t *registers, std::vector<int> *dirtyRegisters = nullptr);
+    // Converts every row into results() only
+    void            scaleValues  ();
+
+private:
+    std::vector<double>   m_scales;
+    std::vector<double>   m_offsets;
+    std::vector<double>   m_minDests;
+    std::vector<double>   m_maxDests;
+    std::vector<int>      m_destinations;
+    std::vector<double>   m_deadbands;
+    std::vector<double>   m_publishedValues; // value of each row when its register was last written, NaN before the first one
+    std::vector<uint16_t> m_publishedResults;// register last written by each row
+    std::vector<uint64_t> m_writeMask;       // one bit per row to write in the current frame
+    bool                  m_hasDeadbands = false;
+    std::vector<double>   m_values;
+    std::vector<uint16_t> m_results;
+};
+
+#endif // REGISTERFRAMESCALER_H
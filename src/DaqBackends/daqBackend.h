@@ -0,0 +1,68 @@
+#ifndef DAQBACKEND_H
+#define DAQBACKEND_H
+
+#include <vector>
+#include <string>
+#include <utility>
+
+#include "../globals/globalEnumStructs.h"
+#include "../config.h"
+#ifdef CrossCompiled
+  #include <NIDAQmx.h>
+#else
+  #include "../../DAQMX_INCLUDE/NIDAQmx.h"
+#endif
+
+class NIDeviceModule;
+
+// A module as seen by a hardware free backend, used instead of the NISysCfg enumeration.
+// productName and slotNb select the NIDeviceModule class and its ini file (e.g. NI9239_3.ini),
+// when hasSettings is set the other fields override that ini file (a recording replays its own configuration).
+struct DaqModuleDescription
+{
+    std::string              productName;
+    unsigned int             slotNb            = 0;
+    bool                     hasSettings       = false;
+    std::string              alias;
+    ModuleType               moduleType        = errorOrMissingModule;
+    std::vector<std::string> chanNames;
+    double                   chanMin           = 0.0;
+    double                   chanMax           = 0.0;
+    double                   samplingRate      = 0.0;
+    unsigned int             samplesPerChannel = 0;
+    std::vector<std::string> counterNames;
+    unsigned int             nbDigitalOutputs  = 0;
+};
+
+// Hardware access used by the acquisition engine, the readers and the writers.
+// DaqmxBackend talks to the real modules through QNiDaqWrapper, SimulatedDaqBackend produces
+// the same blocks with the same timing without any hardware, so the whole pipeline
+// (engine, filters, bridge, modbus) can run and be profiled on a development host.
+// A TaskHandle is opaque to the callers, each backend decides what it points to.
+class DaqBackend {
+public:
+    virtual ~DaqBackend() {}
+
+    virtual std::string getBackendName() const = 0;
+
+    //continuous analogic acquisition: create and start, read one block per call, stop and clear
+    virtual TaskHandle createContinuousAnalogTask (NIDeviceModule *deviceModule) = 0;
+    virtual bool       readAnalogBlock            (TaskHandle taskHandle, NIDeviceModule *deviceModule, std::vector<double> &dataBuffer) = 0;
+    virtual void       clearContinuousTask        (TaskHandle &taskHandle) = 0;
+
+    //optional raw acquisition of a started task: native codes plus the scaling polynomial of each channel,
+    //a backend that cannot deliver them keeps these defaults and the engine reads scaled doubles
+    virtual bool       getAnalogRawScaling        (TaskHandle taskHandle, NIDeviceModule *deviceModule, RawAnalogBlock &rawBlock) { (void)taskHandle; (void)deviceModule; (void)rawBlock; return false; }
+    virtual bool       readAnalogBlockRaw         (TaskHandle taskHandle, NIDeviceModule *deviceModule, RawAnalogBlock &rawBlock) { (void)taskHandle; (void)deviceModule; (void)rawBlock; return false; }
+
+    //optional module list of a backend running without the cRIO, false means the modules are enumerated by NISysCfg
+    virtual bool       describeModules            (std::vector<DaqModuleDescription> &modules) const { (void)modules; return false; }
+
+    //counters: every requested counter of a module in one pass, values follow the order of chanNames
+    virtual bool       readCounters               (NIDeviceModule *deviceModule, const std::vector<std::string> &chanNames, std::vector<uInt32> &values) = 0;
+
+    //digital outputs: (line, state) pairs of one module
+    virtual void       setRelayStates             (NIDeviceModule *deviceModule, const std::vector<std::pair<std::string, bool>> &lineStates) = 0;
+};
+
+#endif // DAQBACKEND_H
@@ -0,0 +1,139 @@
+#ifndef DAQRECORDFORMAT_H
+#define DAQRECORDFORMAT_H
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+// Binary layout shared by RecordingDaqBackend (writer) and ReplayDaqBackend (reader).
+// Host byte order, the recording is meant to be replayed on a x86_64 host like the cRIO itself.
+//
+//  file   : DaqRecordFileHeader, then records until the end of the file
+//  record : DaqRecordHeader, then payloadSize bytes
+//  string : uint16 length, then the characters (no terminator)
+//
+//  TaskConfig  : alias, moduleType (int32), samplingRate (double), samplesPerChannel (uint32), nbChannels (uint32)
+//  AnalogBlock : alias, count (uint32), count doubles grouped by channel (DAQmx_Val_GroupByChannel)
+//  AnalogLost  : alias, the backend returned false for this read (overflow, incomplete block)
+//  TaskCleared : alias
+//  CounterRead : alias, count (uint32), count x (name, uint32 value)
+//  RelayWrite  : alias, count (uint32), count x (line, uint8 state)
+//  ModuleDescription : alias, productName, slot (uint32), moduleType (int32), count (uint32), count x channel name,
+//                      chanMin (double), chanMax (double), samplingRate (double), samplesPerChannel (uint32),
+//                      count (uint32), count x counter name, nbDigitalOutputs (uint32)
+//                      one per module before any other record, the replay builds its module list from them (version 2)
+namespace DaqRecord {
+
+static const uint32_t fileMagic   = 0x43524444; // "DDRC"
+static const uint16_t fileVersion = 2;
+static const uint16_t firstVersionWithModules = 2;
+
+enum RecordType : uint8_t
+{
+    TaskConfig  = 1,
+    AnalogBlock = 2,
+    AnalogLost  = 3,
+    TaskCleared = 4,
+    CounterRead = 5,
+    RelayWrite  = 6,
+    ModuleDescription = 7
+};
+
+#pragma pack(push, 1)
+struct FileHeader
+{
+    uint32_t magic           = fileMagic;
+    uint16_t version         = fileVersion;
+    uint16_t reserved        = 0;
+    int64_t  startEpochNs    = 0;    // system_clock time of the first record, for the operator only
+};
+
+struct RecordHeader
+{
+    uint8_t  type            = 0;
+    uint8_t  reserved[3]     = {0, 0, 0};
+    uint32_t payloadSize     = 0;
+    int64_t  timestampNs     = 0;    // steady_clock time since the recording started
+};
+#pragma pack(pop)
+
+// Serialisation of a payload into a reusable byte buffer
+class PayloadWriter {
+public:
+    void clear()                        { m_bytes.clear(); }
+    const std::vector<uint8_t> &bytes() const { return m_bytes; }
+
+    template <typename T>
+    void put(const T &value)
+    {
+        const uint8_t *raw = reinterpret_cast<const uint8_t*>(&value);
+        m_bytes.insert(m_bytes.end(), raw, raw + sizeof(T));
+    }
+
+    void putString(const std::string &value)
+    {
+        const uint16_t length = static_cast<uint16_t>(value.size() > 0xFFFF ? 0xFFFF : value.size());
+        put(length);
+        m_bytes.insert(m_bytes.end(), value.begin(), value.begin() + length);
+    }
+
+    void putDoubles(const double *values, size_t count)
+    {
+        const uint8_t *raw = reinterpret_cast<const uint8_t*>(values);
+        m_bytes.insert(m_bytes.end(), raw, raw + count * sizeof(double));
+    }
+
+private:
+    std::vector<uint8_t> m_bytes;
+};
+
+// Bounds checked reading of a payload, throws on a truncated or corrupted record
+class PayloadReader {
+public:
+    PayloadReader(const uint8_t *data, size_t size) : m_data(data), m_size(size), m_pos(0) {}
+
+    template <typename T>
+    T get()
+    {
+        T value;
+        require(sizeof(T));
+        std::memcpy(&value, m_data + m_pos, sizeof(T));
+        m_pos += sizeof(T);
+        return value;
+    }
+
+    std::string getString()
+    {
+        const uint16_t length = get<uint16_t>();
+        require(length);
+        std::string value(reinterpret_cast<const char*>(m_data + m_pos), length);
+        m_pos += length;
+        return value;
+    }
+
+    void getDoubles(double *values, size_t count)
+    {
+        require(count * sizeof(double));
+        std::memcpy(values, m_data + m_pos, count * sizeof(double));
+        m_pos += count * sizeof(double);
+    }
+
+private:
+    void require(size_t count) const
+    {
+        if (m_pos + count > m_size)
+        {
+            throw std::runtime_error("DaqRecord: truncated record payload.");
+        }
+    }
+
+    const uint8_t *m_data;
+    size_t         m_size;
+    size_t         m_pos;
+};
+
+} // namespace DaqRecord
+
+#endif // DAQRECORDFORMAT_H
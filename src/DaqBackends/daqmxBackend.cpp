@@ -0,0 +1,51 @@
+#include "daqmxBackend.h"
+
+DaqmxBackend::DaqmxBackend(std::shared_ptr<QNiDaqWrapper> aDaqMxInstance)
+    : m_daqMx(aDaqMxInstance)
+{
+}
+
+std::string DaqmxBackend::getBackendName() const
+{
+    return "DAQmx";
+}
+
+TaskHandle DaqmxBackend::createContinuousAnalogTask(NIDeviceModule *deviceModule)
+{
+    return m_daqMx->createContinuousAnalogTask(deviceModule);
+}
+
+bool DaqmxBackend::readAnalogBlock(TaskHandle taskHandle, NIDeviceModule *deviceModule, std::vector<double> &dataBuffer)
+{
+    return m_daqMx->readAnalogBlock(taskHandle, deviceModule, dataBuffer);
+}
+
+bool DaqmxBackend::getAnalogRawScaling(TaskHandle taskHandle, NIDeviceModule *deviceModule, RawAnalogBlock &rawBlock)
+{
+    return m_daqMx->getAnalogRawScaling(taskHandle, deviceModule, rawBlock);
+}
+
+bool DaqmxBackend::readAnalogBlockRaw(TaskHandle taskHandle, NIDeviceModule *deviceModule, RawAnalogBlock &rawBlock)
+{
+    return m_daqMx->readAnalogBlockRaw(taskHandle, deviceModule, rawBlock);
+}
+
+void DaqmxBackend::clearContinuousTask(TaskHandle &taskHandle)
+{
+    m_daqMx->clearContinuousTask(taskHandle);
+}
+
+bool DaqmxBackend::readCounters(NIDeviceModule *deviceModule, const std::vector<std::string> &chanNames, std::vector<uInt32> &values)
+{
+    return m_daqMx->readCounters(deviceModule, chanNames, values);
+}
+
+void DaqmxBackend::setRelayStates(NIDeviceModule *deviceModule, const std::vector<std::pair<std::string, bool>> &lineStates)
+{
+    m_daqMx->setRelayStates(deviceModule, lineStates);
+}
+
+std::shared_ptr<QNiDaqWrapper> DaqmxBackend::getDaqMx() const
+{
+    return m_daqMx;
+}
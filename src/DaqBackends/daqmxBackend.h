@@ -0,0 +1,30 @@
+#ifndef DAQMXBACKEND_H
+#define DAQMXBACKEND_H
+
+#include <memory>
+
+#include "daqBackend.h"
+#include "../NiWrappers/QNiDaqWrapper.h"
+
+// Real hardware backend, every call is forwarded to the NI DAQmx wrapper
+class DaqmxBackend : public DaqBackend {
+public:
+    explicit DaqmxBackend(std::shared_ptr<QNiDaqWrapper> aDaqMxInstance);
+
+    std::string getBackendName() const override;
+
+    TaskHandle createContinuousAnalogTask (NIDeviceModule *deviceModule) override;
+    bool       readAnalogBlock            (TaskHandle taskHandle, NIDeviceModule *deviceModule, std::vector<double> &dataBuffer) override;
+    void       clearContinuousTask        (TaskHandle &taskHandle) override;
+    bool       getAnalogRawScaling        (TaskHandle taskHandle, NIDeviceModule *deviceModule, RawAnalogBlock &rawBlock) override;
+    bool       readAnalogBlockRaw         (TaskHandle taskHandle, NIDeviceModule *deviceModule, RawAnalogBlock &rawBlock) override;
+    bool       readCounters               (NIDeviceModule *deviceModule, const std::vector<std::string> &chanNames, std::vector<uInt32> &values) override;
+    void       setRelayStates             (NIDeviceModule *deviceModule, const std::vector<std::pair<std::string, bool>> &lineStates) override;
+
+    std::shared_ptr<QNiDaqWrapper> getDaqMx() const;
+
+private:
+    std::shared_ptr<QNiDaqWrapper> m_daqMx;
+};
+
+#endif // DAQMXBACKEND_H
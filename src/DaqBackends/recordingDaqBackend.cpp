@@ -0,0 +1,233 @@
+#include "recordingDaqBackend.h"
+#include <stdexcept>
+
+RecordingDaqBackend::RecordingDaqBackend(std::shared_ptr<DaqBackend> aRecordedBackend, const std::string &recordFileName,
+                                         uint64_t maxBytes, std::chrono::seconds maxDuration)
+    : m_recordedBackend(aRecordedBackend),
+      m_recordFileName (recordFileName),
+      m_startTime      (std::chrono::steady_clock::now()),
+      m_maxBytes       (maxBytes),
+      m_maxDurationNs  (std::chrono::duration_cast<std::chrono::nanoseconds>(maxDuration).count())
+{
+    if (!m_recordedBackend)
+    {
+        throw std::invalid_argument("RecordingDaqBackend: no backend to record.");
+    }
+    m_recordFile = std::fopen(m_recordFileName.c_str(), "wb");
+    if (!m_recordFile)
+    {
+        appendCommentWithTimestamp(m_fileNamesContainer.acquisitionEngineLogFile,
+                                   "In\n"
+                                   "RecordingDaqBackend::RecordingDaqBackend(...)\n"
+                                   "Error: unable to create the record file "+m_recordFileName);
+        throw std::runtime_error("RecordingDaqBackend: unable to create " + m_recordFileName);
+    }
+    // 1 MB stdio buffer: at 50 kHz a NI9239 block stream is about 1.6 MB/s, a few writes per second
+    std::setvbuf(m_recordFile, nullptr, _IOFBF, 1 << 20);
+
+    DaqRecord::FileHeader header;
+    header.startEpochNs = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    std::fwrite(&header, sizeof(header), 1, m_recordFile);
+    m_recordedBytes = sizeof(header);
+}
+
+RecordingDaqBackend::~RecordingDaqBackend()
+{
+    std::lock_guard<std::mutex> lock(m_fileMutex);
+    if (m_recordFile)
+    {
+        std::fclose(m_recordFile);
+        m_recordFile = nullptr;
+    }
+}
+
+std::string RecordingDaqBackend::getBackendName() const
+{
+    return m_recordedBackend->getBackendName() + " (recorded to " + m_recordFileName + ")";
+}
+
+int64_t RecordingDaqBackend::elapsedNs() const
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_startTime).count();
+}
+
+void RecordingDaqBackend::writeRecord(DaqRecord::RecordType type, const DaqRecord::PayloadWriter &payload)
+{
+    DaqRecord::RecordHeader header;
+    header.type        = type;
+    header.payloadSize = static_cast<uint32_t>(payload.bytes().size());
+
+    std::lock_guard<std::mutex> lock(m_fileMutex);
+    // Timestamped under the lock so that the file stays in time order across the workers
+    header.timestampNs = elapsedNs();
+    if (!m_recordFile)
+    {
+        return;
+    }
+    const uint64_t recordBytes = sizeof(header) + payload.bytes().size();
+    const bool sizeReached     = m_maxBytes > 0 && m_recordedBytes + recordBytes > m_maxBytes;
+    const bool durationReached = m_maxDurationNs > 0 && header.timestampNs > m_maxDurationNs;
+    if (sizeReached || durationReached)
+    {
+        // The last complete record ends the file, the replay sees a recording that simply ends there
+        std::fclose(m_recordFile);
+        m_recordFile = nullptr;
+        appendCommentWithTimestamp(m_fileNamesContainer.acquisitionEngineLogFile,
+                                   "In\n"
+                                   "void RecordingDaqBackend::writeRecord(DaqRecord::RecordType type, const DaqRecord::PayloadWriter &payload)\n"
+                                   "Warning: recording to "+m_recordFileName+" stopped after "+std::to_string(m_recordedBytes)+" bytes and "+
+                                   std::to_string(header.timestampNs / 1000000000LL)+" s, its "+(sizeReached ? "size" : "duration")+" limit is reached");
+        return;
+    }
+    std::fwrite(&header, sizeof(header), 1, m_recordFile);
+    std::fwrite(payload.bytes().data(), 1, payload.bytes().size(), m_recordFile);
+    m_recordedBytes += recordBytes;
+}
+
+TaskHandle RecordingDaqBackend::createContinuousAnalogTask(NIDeviceModule *deviceModule)
+{
+    TaskHandle taskHandle = m_recordedBackend->createContinuousAnalogTask(deviceModule);
+
+    thread_local DaqRecord::PayloadWriter payload;
+    payload.clear();
+    payload.putString(deviceModule->getAlias());
+    payload.put<int32_t> (static_cast<int32_t>(deviceModule->getModuleType()));
+    payload.put<double>  (deviceModule->getSamplingRate());
+    payload.put<uint32_t>(deviceModule->getSamplesPerChannel());
+    payload.put<uint32_t>(deviceModule->getNbChannel());
+    writeRecord(DaqRecord::TaskConfig, payload);
+
+    std::lock_guard<std::mutex> lock(m_fileMutex);
+    m_taskAliases[taskHandle] = deviceModule->getAlias();
+    return taskHandle;
+}
+
+bool RecordingDaqBackend::readAnalogBlock(TaskHandle taskHandle, NIDeviceModule *deviceModule, std::vector<double> &dataBuffer)
+{
+    const bool ok = m_recordedBackend->readAnalogBlock(taskHandle, deviceModule, dataBuffer);
+
+    thread_local DaqRecord::PayloadWriter payload;
+    payload.clear();
+    payload.putString(deviceModule->getAlias());
+    if (!ok)
+    {
+        writeRecord(DaqRecord::AnalogLost, payload);
+        return false;
+    }
+    uint32_t count = deviceModule->getNbChannel() * deviceModule->getSamplesPerChannel();
+    if (count > dataBuffer.size()) count = static_cast<uint32_t>(dataBuffer.size());
+    payload.put<uint32_t>(count);
+    payload.putDoubles(dataBuffer.data(), count);
+    writeRecord(DaqRecord::AnalogBlock, payload);
+    return true;
+}
+
+void RecordingDaqBackend::clearContinuousTask(TaskHandle &taskHandle)
+{
+    std::string alias;
+    {
+        std::lock_guard<std::mutex> lock(m_fileMutex);
+        auto it = m_taskAliases.find(taskHandle);
+        if (it != m_taskAliases.end())
+        {
+            alias = it->second;
+            m_taskAliases.erase(it);
+        }
+    }
+    m_recordedBackend->clearContinuousTask(taskHandle);
+    if (!alias.empty())
+    {
+        DaqRecord::PayloadWriter payload;
+        payload.putString(alias);
+        writeRecord(DaqRecord::TaskCleared, payload);
+    }
+}
+
+bool RecordingDaqBackend::readCounters(NIDeviceModule *deviceModule, const std::vector<std::string> &chanNames, std::vector<uInt32> &values)
+{
+    const bool ok = m_recordedBackend->readCounters(deviceModule, chanNames, values);
+    if (!ok)
+    {
+        return false;
+    }
+
+    thread_local DaqRecord::PayloadWriter payload;
+    payload.clear();
+    payload.putString(deviceModule->getAlias());
+    payload.put<uint32_t>(static_cast<uint32_t>(chanNames.size()));
+    for (size_t i = 0; i < chanNames.size(); ++i)
+    {
+        payload.putString(chanNames[i]);
+        payload.put<uint32_t>(i < values.size() ? values[i] : 0);
+    }
+    writeRecord(DaqRecord::CounterRead, payload);
+    return true;
+}
+
+void RecordingDaqBackend::setRelayStates(NIDeviceModule *deviceModule, const std::vector<std::pair<std::string, bool>> &lineStates)
+{
+    m_recordedBackend->setRelayStates(deviceModule, lineStates);
+
+    thread_local DaqRecord::PayloadWriter payload;
+    payload.clear();
+    payload.putString(deviceModule->getAlias());
+    payload.put<uint32_t>(static_cast<uint32_t>(lineStates.size()));
+    for (const std::pair<std::string, bool> &lineState : lineStates)
+    {
+        payload.putString(lineState.first);
+        payload.put<uint8_t>(lineState.second ? 1 : 0);
+    }
+    writeRecord(DaqRecord::RelayWrite, payload);
+}
+
+bool RecordingDaqBackend::describeModules(std::vector<DaqModuleDescription> &modules) const
+{
+    return m_recordedBackend->describeModules(modules);
+}
+
+void RecordingDaqBackend::recordModules(const std::vector<NIDeviceModule*> &modules)
+{
+    DaqRecord::PayloadWriter payload;
+    for (NIDeviceModule *module : modules)
+    {
+        if (!module)
+        {
+            continue;
+        }
+        const std::vector<std::string> chanNames    = module->getChanNames();
+        const std::vector<std::string> counterNames = module->getCounterNames();
+        payload.clear();
+        payload.putString(module->getAlias());
+        payload.putString(module->getModuleName());
+        payload.put<uint32_t>(module->getSlotNb());
+        payload.put<int32_t> (static_cast<int32_t>(module->getModuleType()));
+        payload.put<uint32_t>(static_cast<uint32_t>(chanNames.size()));
+        for (const std::string &chanName : chanNames)
+        {
+            payload.putString(chanName);
+        }
+        payload.put<double>  (module->getChanMin());
+        payload.put<double>  (module->getChanMax());
+        payload.put<double>  (module->getSamplingRate());
+        payload.put<uint32_t>(module->getSamplesPerChannel());
+        payload.put<uint32_t>(static_cast<uint32_t>(counterNames.size()));
+        for (const std::string &counterName : counterNames)
+        {
+            payload.putString(counterName);
+        }
+        payload.put<uint32_t>(module->getNbDigitalOutputs());
+        writeRecord(DaqRecord::ModuleDescription, payload);
+    }
+}
+
+uint64_t RecordingDaqBackend::getRecordedBytes() const
+{
+    std::lock_guard<std::mutex> lock(m_fileMutex);
+    return m_recordedBytes;
+}
+
+bool RecordingDaqBackend::isRecording() const
+{
+    std::lock_guard<std::mutex> lock(m_fileMutex);
+    return m_recordFile != nullptr;
+}
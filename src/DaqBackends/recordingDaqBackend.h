@@ -0,0 +1,58 @@
+#ifndef RECORDINGDAQBACKEND_H
+#define RECORDINGDAQBACKEND_H
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <chrono>
+#include <cstdio>
+
+#include "daqBackend.h"
+#include "daqRecordFormat.h"
+#include "../NiModulesDefinitions/NIDeviceModule.h"
+#include "../filesUtils/appendToFileHelper.h"
+#include "../globals/globalEnumStructs.h"
+
+// Decorator recording everything another backend returns (raw analogic blocks, counter values,
+// relay writes and task configurations) with their timestamps into a binary file (see daqRecordFormat.h).
+// The acquisition path is unchanged, ReplayDaqBackend feeds the recording back through the same calls.
+// Payloads are encoded outside the lock, only the buffered fwrite is serialised between the workers.
+// The recording stops (file closed, acquisition untouched) once it reaches maxBytes or maxDuration, 0 means no limit.
+class RecordingDaqBackend : public DaqBackend {
+public:
+    RecordingDaqBackend(std::shared_ptr<DaqBackend> aRecordedBackend, const std::string &recordFileName,
+                        uint64_t maxBytes = 0, std::chrono::seconds maxDuration = std::chrono::seconds(0));
+    ~RecordingDaqBackend();
+
+    std::string getBackendName() const override;
+
+    TaskHandle createContinuousAnalogTask (NIDeviceModule *deviceModule) override;
+    bool       readAnalogBlock            (TaskHandle taskHandle, NIDeviceModule *deviceModule, std::vector<double> &dataBuffer) override;
+    void       clearContinuousTask        (TaskHandle &taskHandle) override;
+    bool       readCounters               (NIDeviceModule *deviceModule, const std::vector<std::string> &chanNames, std::vector<uInt32> &values) override;
+    void       setRelayStates             (NIDeviceModule *deviceModule, const std::vector<std::pair<std::string, bool>> &lineStates) override;
+    bool       describeModules            (std::vector<DaqModuleDescription> &modules) const override;
+
+    //module list of the run, written first so that the recording can be replayed without the cRIO
+    void       recordModules              (const std::vector<NIDeviceModule*> &modules);
+
+    uint64_t   getRecordedBytes() const;
+    bool       isRecording() const;
+
+private:
+    void writeRecord(DaqRecord::RecordType type, const DaqRecord::PayloadWriter &payload);
+    int64_t elapsedNs() const;
+
+    std::shared_ptr<DaqBackend>                  m_recordedBackend;
+    std::string                                  m_recordFileName;
+    FILE                                        *m_recordFile = nullptr;
+    mutable std::mutex                           m_fileMutex;
+    std::map<TaskHandle, std::string>            m_taskAliases;       // alias of each running task, for the clear record
+    std::chrono::steady_clock::time_point        m_startTime;
+    uint64_t                                     m_recordedBytes = 0;
+    uint64_t                                     m_maxBytes;
+    int64_t                                      m_maxDurationNs;
+    GlobalFileNamesContainer                     m_fileNamesContainer;
+};
+
+#endif // RECORDINGDAQBACKEND_H
@@ -0,0 +1,398 @@
+#include "replayDaqBackend.h"
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include <algorithm>
+#include <stdexcept>
+
+ReplayDaqBackend::ReplayDaqBackend(const std::string &recordFileName, bool asFastAsPossible, bool loop)
+    : m_recordFileName  (recordFileName),
+      m_asFastAsPossible(asFastAsPossible),
+      m_loop            (loop)
+{
+    loadRecording(recordFileName);
+}
+
+std::string ReplayDaqBackend::getBackendName() const
+{
+    return std::string("Replay of ") + m_recordFileName + (m_asFastAsPossible ? " (as fast as possible)" : " (recorded speed)");
+}
+
+void ReplayDaqBackend::loadRecording(const std::string &recordFileName)
+{
+    std::ifstream file(recordFileName, std::ios::binary);
+    if (!file.is_open())
+    {
+        appendCommentWithTimestamp(m_fileNamesContainer.acquisitionEngineLogFile,
+                                   "In\n"
+                                   "void ReplayDaqBackend::loadRecording(const std::string &recordFileName)\n"
+                                   "Error: unable to open the record file "+recordFileName);
+        throw std::runtime_error("ReplayDaqBackend: unable to open " + recordFileName);
+    }
+
+    DaqRecord::FileHeader fileHeader;
+    if (!file.read(reinterpret_cast<char*>(&fileHeader), sizeof(fileHeader)) ||
+        fileHeader.magic != DaqRecord::fileMagic || fileHeader.version == 0 || fileHeader.version > DaqRecord::fileVersion)
+    {
+        throw std::runtime_error("ReplayDaqBackend: " + recordFileName + " is not a DAQ recording of a supported version.");
+    }
+    m_hasModuleList = (fileHeader.version >= DaqRecord::firstVersionWithModules);
+
+    bool firstRecord = true;
+    int64_t lastTimestampNs = 0;
+    std::vector<uint8_t> payload;
+    DaqRecord::RecordHeader header;
+    while (file.read(reinterpret_cast<char*>(&header), sizeof(header)))
+    {
+        payload.resize(header.payloadSize);
+        if (!file.read(reinterpret_cast<char*>(payload.data()), header.payloadSize))
+        {
+            // The recorder was killed while writing, keep what is complete
+            appendCommentWithTimestamp(m_fileNamesContainer.acquisitionEngineLogFile,
+                                       "In\n"
+                                       "void ReplayDaqBackend::loadRecording(const std::string &recordFileName)\n"
+                                       "Warning: truncated last record ignored in "+recordFileName);
+            break;
+        }
+        DaqRecord::PayloadReader reader(payload.data(), payload.size());
+        const std::string alias = reader.getString();
+        if (header.type == DaqRecord::ModuleDescription)
+        {
+            // Written before the acquisition starts, it is not part of the replayed timeline
+            DaqModuleDescription module;
+            module.hasSettings  = true;
+            module.alias        = alias;
+            module.productName  = reader.getString();
+            module.slotNb       = reader.get<uint32_t>();
+            module.moduleType   = static_cast<ModuleType>(reader.get<int32_t>());
+            const uint32_t nbChannels = reader.get<uint32_t>();
+            for (uint32_t i = 0; i < nbChannels; ++i)
+            {
+                module.chanNames.push_back(reader.getString());
+            }
+            module.chanMin           = reader.get<double>();
+            module.chanMax           = reader.get<double>();
+            module.samplingRate      = reader.get<double>();
+            module.samplesPerChannel = reader.get<uint32_t>();
+            const uint32_t nbCounters = reader.get<uint32_t>();
+            for (uint32_t i = 0; i < nbCounters; ++i)
+            {
+                module.counterNames.push_back(reader.getString());
+            }
+            module.nbDigitalOutputs = reader.get<uint32_t>();
+            m_modules.push_back(module);
+            continue;
+        }
+        if (firstRecord)
+        {
+            m_firstTimestampNs = header.timestampNs;
+            firstRecord = false;
+        }
+        lastTimestampNs = header.timestampNs;
+
+        switch (header.type)
+        {
+            case DaqRecord::TaskConfig:
+            {
+                ModuleStream &stream = m_streams[alias];
+                stream.hasConfig         = true;
+                stream.moduleType        = reader.get<int32_t>();
+                stream.samplingRate      = reader.get<double>();
+                stream.samplesPerChannel = reader.get<uint32_t>();
+                stream.nbChannels        = reader.get<uint32_t>();
+                break;
+            }
+            case DaqRecord::AnalogBlock:
+            {
+                ModuleStream &stream = m_streams[alias];
+                AnalogEntry entry;
+                entry.timestampNs = header.timestampNs;
+                entry.count       = reader.get<uint32_t>();
+                entry.offset      = stream.samples.size();
+                stream.samples.resize(entry.offset + entry.count);
+                reader.getDoubles(stream.samples.data() + entry.offset, entry.count);
+                stream.blocks.push_back(entry);
+                break;
+            }
+            case DaqRecord::AnalogLost:
+            {
+                AnalogEntry entry;
+                entry.timestampNs = header.timestampNs;
+                entry.lost        = true;
+                m_streams[alias].blocks.push_back(entry);
+                break;
+            }
+            case DaqRecord::CounterRead:
+            {
+                CounterEntry entry;
+                entry.timestampNs = header.timestampNs;
+                const uint32_t count = reader.get<uint32_t>();
+                entry.chanNames.reserve(count);
+                entry.values.reserve(count);
+                for (uint32_t i = 0; i < count; ++i)
+                {
+                    entry.chanNames.push_back(reader.getString());
+                    entry.values.push_back(reader.get<uint32_t>());
+                }
+                m_streams[alias].counters.push_back(std::move(entry));
+                break;
+            }
+            default:
+                // TaskCleared and RelayWrite are only there for the operator, relays are outputs
+                break;
+        }
+    }
+    m_durationNs = lastTimestampNs - m_firstTimestampNs;
+    std::sort(m_modules.begin(), m_modules.end(), [](const DaqModuleDescription &a, const DaqModuleDescription &b) { return a.slotNb < b.slotNb; });
+    if (!m_hasModuleList)
+    {
+        appendCommentWithTimestamp(m_fileNamesContainer.acquisitionEngineLogFile,
+                                   "In\n"
+                                   "void ReplayDaqBackend::loadRecording(const std::string &recordFileName)\n"
+                                   "Warning: "+recordFileName+" is a version "+std::to_string(fileHeader.version)+
+                                   " recording without module list, the modules are enumerated from the cRIO");
+    }
+
+    for (const std::pair<const std::string, ModuleStream> &stream : m_streams)
+    {
+        if (!stream.second.blocks.empty())
+        {
+            ++m_analogStreams;
+        }
+        std::cout << "Replay stream " << stream.first << ": " << stream.second.blocks.size() << " blocks, "
+                  << stream.second.counters.size() << " counter reads" << std::endl;
+    }
+}
+
+bool ReplayDaqBackend::describeModules(std::vector<DaqModuleDescription> &modules) const
+{
+    if (!m_hasModuleList)
+    {
+        return false;
+    }
+    modules = m_modules;
+    return true;
+}
+
+void ReplayDaqBackend::startClockIfNeeded()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_clockStarted)
+    {
+        // The replay clock starts with the first request so that the modules keep their recorded alignment
+        m_replayStart  = std::chrono::steady_clock::now();
+        m_clockStarted = true;
+    }
+}
+
+int64_t ReplayDaqBackend::replayNowNs() const
+{
+    return m_firstTimestampNs + std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_replayStart).count();
+}
+
+void ReplayDaqBackend::waitUntilRecordedTime(int64_t recordedNs)
+{
+    const std::chrono::steady_clock::time_point target = m_replayStart + std::chrono::nanoseconds(recordedNs - m_firstTimestampNs);
+    std::this_thread::sleep_until(target);
+    const int64_t lateness = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - target).count();
+    int64_t maxLateness = m_maxLatenessNs.load(std::memory_order_relaxed);
+    while (lateness > maxLateness && !m_maxLatenessNs.compare_exchange_weak(maxLateness, lateness, std::memory_order_relaxed))
+    {
+    }
+}
+
+void ReplayDaqBackend::reportEndOfStream(const std::string &alias)
+{
+    const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_replayStart).count();
+    const uint64_t blocks = m_replayedBlocks.load();
+    const std::string summary = "Replay of " + alias + " finished: " + std::to_string(blocks) + " blocks replayed in "
+                              + std::to_string(elapsed) + " s (" + std::to_string(elapsed > 0.0 ? double(blocks) / elapsed : 0.0)
+                              + " blocks/s, worst lateness " + std::to_string(m_maxLatenessNs.load() / 1000) + " us)";
+    std::cout << summary << std::endl;
+    appendCommentWithTimestamp(m_fileNamesContainer.acquisitionEngineLogFile, summary);
+}
+
+TaskHandle ReplayDaqBackend::createContinuousAnalogTask(NIDeviceModule *deviceModule)
+{
+    if (!deviceModule)
+    {
+        throw std::invalid_argument("ReplayDaqBackend: module is null.");
+    }
+    auto it = m_streams.find(deviceModule->getAlias());
+    if (it == m_streams.end() || !it->second.hasConfig)
+    {
+        appendCommentWithTimestamp(m_fileNamesContainer.acquisitionEngineLogFile,
+                                   "In\n"
+                                   "TaskHandle ReplayDaqBackend::createContinuousAnalogTask(NIDeviceModule *deviceModule)\n"
+                                   "Error: "+deviceModule->getAlias()+" is not in the recording "+m_recordFileName);
+        throw std::invalid_argument("ReplayDaqBackend: " + deviceModule->getAlias() + " is not in the recording.");
+    }
+    ModuleStream &stream = it->second;
+    // The blocks are replayed as recorded, the module must still be configured the same way
+    if (stream.samplesPerChannel != deviceModule->getSamplesPerChannel() || stream.nbChannels != deviceModule->getNbChannel())
+    {
+        appendCommentWithTimestamp(m_fileNamesContainer.acquisitionEngineLogFile,
+                                   "In\n"
+                                   "TaskHandle ReplayDaqBackend::createContinuousAnalogTask(NIDeviceModule *deviceModule)\n"
+                                   "Error: "+deviceModule->getAlias()+" was recorded with "+std::to_string(stream.nbChannels)+
+                                   " channels of "+std::to_string(stream.samplesPerChannel)+" samples, its ini file differs");
+        throw std::invalid_argument("ReplayDaqBackend: " + deviceModule->getAlias() + " does not match its recorded configuration.");
+    }
+
+    startClockIfNeeded();
+    TaskHandle taskHandle = static_cast<TaskHandle>(&stream);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_tasks[taskHandle] = &stream;
+    return taskHandle;
+}
+
+bool ReplayDaqBackend::readAnalogBlock(TaskHandle taskHandle, NIDeviceModule *deviceModule, std::vector<double> &dataBuffer)
+{
+    ModuleStream *stream = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_tasks.find(taskHandle);
+        if (it == m_tasks.end())
+        {
+            throw std::runtime_error("ReplayDaqBackend: unknown task on " + (deviceModule ? deviceModule->getAlias() : std::string("?")));
+        }
+        stream = it->second;
+    }
+
+    if (stream->nextBlock >= stream->blocks.size())
+    {
+        if (m_loop && !stream->blocks.empty())
+        {
+            stream->nextBlock          = 0;
+            stream->blockLoopOffsetNs += m_durationNs;
+        }
+        else
+        {
+            if (!stream->finished)
+            {
+                stream->finished = true;
+                ++m_finishedStreams;
+                reportEndOfStream(deviceModule->getAlias());
+            }
+            // Nothing left to deliver, do not let the worker spin
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            return false;
+        }
+    }
+
+    const AnalogEntry &entry = stream->blocks[stream->nextBlock++];
+    if (!m_asFastAsPossible)
+    {
+        waitUntilRecordedTime(entry.timestampNs + stream->blockLoopOffsetNs);
+    }
+    if (entry.lost)
+    {
+        return false;
+    }
+    if (dataBuffer.size() < entry.count)
+    {
+        dataBuffer.resize(entry.count);
+    }
+    std::copy(stream->samples.begin() + entry.offset, stream->samples.begin() + entry.offset + entry.count, dataBuffer.begin());
+    m_replayedBlocks.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void ReplayDaqBackend::clearContinuousTask(TaskHandle &taskHandle)
+{
+    if (taskHandle)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_tasks.erase(taskHandle);
+        taskHandle = nullptr;
+    }
+}
+
+bool ReplayDaqBackend::readCounters(NIDeviceModule *deviceModule, const std::vector<std::string> &chanNames, std::vector<uInt32> &values)
+{
+    if (!deviceModule)
+    {
+        throw std::invalid_argument("ReplayDaqBackend::readCounters: deviceModule is null.");
+    }
+    auto it = m_streams.find(deviceModule->getAlias());
+    if (it == m_streams.end() || it->second.counters.empty())
+    {
+        return false;
+    }
+    ModuleStream &stream = it->second;
+
+    startClockIfNeeded();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const CounterEntry *entry = nullptr;
+    if (m_asFastAsPossible)
+    {
+        // One recorded read per call
+        if (stream.nextCounter >= stream.counters.size())
+        {
+            stream.nextCounter = m_loop ? 0 : stream.counters.size() - 1;
+        }
+        entry = &stream.counters[stream.nextCounter++];
+    }
+    else
+    {
+        // Latest read recorded before the current replay time
+        int64_t now = replayNowNs();
+        if (m_loop && m_durationNs > 0)
+        {
+            now = m_firstTimestampNs + (now - m_firstTimestampNs) % m_durationNs;
+        }
+        auto next = std::upper_bound(stream.counters.begin(), stream.counters.end(), now,
+                                     [](int64_t t, const CounterEntry &e) { return t < e.timestampNs; });
+        entry = (next == stream.counters.begin()) ? &stream.counters.front() : &*(next - 1);
+    }
+
+    bool allFound = true;
+    values.resize(chanNames.size());
+    for (size_t i = 0; i < chanNames.size(); ++i)
+    {
+        auto name = std::find(entry->chanNames.begin(), entry->chanNames.end(), chanNames[i]);
+        if (name == entry->chanNames.end())
+        {
+            values[i] = 0;
+            allFound  = false;
+            continue;
+        }
+        values[i] = entry->values[name - entry->chanNames.begin()];
+    }
+    return allFound;
+}
+
+void ReplayDaqBackend::setRelayStates(NIDeviceModule *deviceModule, const std::vector<std::pair<std::string, bool>> &lineStates)
+{
+    if (!deviceModule)
+    {
+        throw std::invalid_argument("ReplayDaqBackend::setRelayStates: deviceModule is null.");
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const std::pair<std::string, bool> &lineState : lineStates)
+    {
+        m_relayStates[deviceModule->getAlias() + lineState.first] = lineState.second;
+    }
+}
+
+bool ReplayDaqBackend::getRelayState(const std::string &moduleAlias, const std::string &chanName) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_relayStates.find(moduleAlias + chanName);
+    return (it != m_relayStates.end()) && it->second;
+}
+
+uint64_t ReplayDaqBackend::getReplayedBlocks() const
+{
+    return m_replayedBlocks.load();
+}
+
+int64_t ReplayDaqBackend::getMaxLatenessNs() const
+{
+    return m_maxLatenessNs.load();
+}
+
+bool ReplayDaqBackend::isFinished() const
+{
+    return !m_loop && m_finishedStreams.load() >= m_analogStreams;
+}
@@ -0,0 +1,105 @@
+#ifndef REPLAYDAQBACKEND_H
+#define REPLAYDAQBACKEND_H
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+
+#include "daqBackend.h"
+#include "daqRecordFormat.h"
+#include "../NiModulesDefinitions/NIDeviceModule.h"
+#include "../filesUtils/appendToFileHelper.h"
+#include "../globals/globalEnumStructs.h"
+
+// Feeds a RecordingDaqBackend file back through the acquisition path, hardware free and deterministic:
+//  - paced replay delivers every block and counter value at its recorded time,
+//    the same field data then goes through the engine, filters, bridge and modbus at the real rate
+//  - as fast as possible replay hands the blocks over as soon as they are asked for,
+//    the consumers are then the only limit, which is what a throughput benchmark wants
+// The recording is loaded in memory at construction, nothing is read from the disk while replaying.
+// Each module stream keeps its position when its task is recreated, lost blocks of the recording are lost again.
+// At the end of the recording the streams either loop or stop delivering (readAnalogBlock returns false).
+// The modules (alias, type, channels, acquisition settings) come from the recording as well, nothing is enumerated,
+// a recording made on the cRIO is replayed on any host (version 1 recordings still need the modules to be plugged).
+class ReplayDaqBackend : public DaqBackend {
+public:
+    ReplayDaqBackend(const std::string &recordFileName, bool asFastAsPossible, bool loop);
+
+    std::string getBackendName() const override;
+
+    TaskHandle createContinuousAnalogTask (NIDeviceModule *deviceModule) override;
+    bool       readAnalogBlock            (TaskHandle taskHandle, NIDeviceModule *deviceModule, std::vector<double> &dataBuffer) override;
+    void       clearContinuousTask        (TaskHandle &taskHandle) override;
+    bool       readCounters               (NIDeviceModule *deviceModule, const std::vector<std::string> &chanNames, std::vector<uInt32> &values) override;
+    void       setRelayStates             (NIDeviceModule *deviceModule, const std::vector<std::pair<std::string, bool>> &lineStates) override;
+    bool       describeModules            (std::vector<DaqModuleDescription> &modules) const override;
+
+    bool       getRelayState              (const std::string &moduleAlias, const std::string &chanName) const;
+
+    uint64_t   getReplayedBlocks          () const;
+    // worst delay between the recorded time of a block and its delivery, paced replay only
+    int64_t    getMaxLatenessNs           () const;
+    bool       isFinished                 () const;
+
+private:
+    struct AnalogEntry
+    {
+        int64_t  timestampNs = 0;
+        size_t   offset      = 0;      // first sample in ModuleStream::samples
+        uint32_t count       = 0;
+        bool     lost        = false;
+    };
+
+    struct CounterEntry
+    {
+        int64_t                  timestampNs = 0;
+        std::vector<std::string> chanNames;
+        std::vector<uInt32>      values;
+    };
+
+    struct ModuleStream
+    {
+        bool                      hasConfig         = false;
+        int32_t                   moduleType        = 0;
+        double                    samplingRate      = 0.0;
+        uint32_t                  samplesPerChannel = 0;
+        uint32_t                  nbChannels        = 0;
+        std::vector<double>       samples;
+        std::vector<AnalogEntry>  blocks;
+        std::vector<CounterEntry> counters;
+        size_t                    nextBlock         = 0;  // used by the acquisition worker of the module only
+        int64_t                   blockLoopOffsetNs = 0;
+        size_t                    nextCounter       = 0;  // guarded by m_mutex
+        int64_t                   counterLoopOffsetNs = 0;
+        bool                      finished          = false;
+    };
+
+    void    loadRecording(const std::string &recordFileName);
+    void    startClockIfNeeded();
+    int64_t replayNowNs() const;
+    void    waitUntilRecordedTime(int64_t recordedNs);
+    void    reportEndOfStream(const std::string &alias);
+
+    std::string                                  m_recordFileName;
+    bool                                         m_asFastAsPossible;
+    bool                                         m_loop;
+    std::map<std::string, ModuleStream>          m_streams;          // filled at construction, the map itself is read only afterwards
+    std::vector<DaqModuleDescription>            m_modules;          // recorded module list, in slot order
+    bool                                         m_hasModuleList    = false;
+    std::map<TaskHandle, ModuleStream*>          m_tasks;
+    std::map<std::string, bool>                  m_relayStates;      // "Mod6/port0/line0" -> state
+    int64_t                                      m_firstTimestampNs = 0;
+    int64_t                                      m_durationNs       = 0;
+    mutable std::mutex                           m_mutex;
+    bool                                         m_clockStarted     = false;
+    std::chrono::steady_clock::time_point        m_replayStart;
+    std::atomic<uint64_t>                        m_replayedBlocks{0};
+    std::atomic<int64_t>                         m_maxLatenessNs{0};
+    std::atomic<unsigned int>                    m_finishedStreams{0};
+    unsigned int                                 m_analogStreams    = 0;
+    GlobalFileNamesContainer                     m_fileNamesContainer;
+};
+
+#endif // REPLAYDAQBACKEND_H
@@ -0,0 +1,244 @@
+#include "simulatedDaqBackend.h"
+#include <cmath>
+#include <algorithm>
+#include <thread>
+#include <stdexcept>
+#include <regex>
+#include <dirent.h>
+#include "../stringUtils/stringUtils.h"
+
+SimulatedDaqBackend::SimulatedDaqBackend()
+    : m_countersStart(std::chrono::steady_clock::now())
+{
+}
+
+std::string SimulatedDaqBackend::getBackendName() const
+{
+    return "Simulated";
+}
+
+bool SimulatedDaqBackend::describeModules(std::vector<DaqModuleDescription> &modules) const
+{
+    modules.clear();
+    // Same file names as the modules save their configuration to: <product name>_<slot>.ini
+    std::regex pattern("^(NI.*)_([0-9]+)\\.ini$");
+    std::cmatch match;
+    DIR *dir = opendir(".");
+    if (dir == nullptr)
+    {
+        appendCommentWithTimestamp(m_fileNamesContainer.acquisitionEngineLogFile,
+                                   "In\n"
+                                   "bool SimulatedDaqBackend::describeModules(std::vector<DaqModuleDescription> &modules) const\n"
+                                   "Error: unable to open the working directory");
+        return true;
+    }
+    struct dirent *ent;
+    while ((ent = readdir(dir)) != nullptr)
+    {
+        if (std::regex_match(ent->d_name, match, pattern))
+        {
+            DaqModuleDescription description;
+            description.productName = match[1].str();
+            description.slotNb      = static_cast<unsigned int>(std::stoul(match[2].str()));
+            modules.push_back(description);
+        }
+    }
+    closedir(dir);
+    // readdir has no order, the modules are listed by slot as on the chassis
+    std::sort(modules.begin(), modules.end(), [](const DaqModuleDescription &a, const DaqModuleDescription &b) { return a.slotNb < b.slotNb; });
+    if (modules.empty())
+    {
+        appendCommentWithTimestamp(m_fileNamesContainer.acquisitionEngineLogFile,
+                                   "In\n"
+                                   "bool SimulatedDaqBackend::describeModules(std::vector<DaqModuleDescription> &modules) const\n"
+                                   "Warning: no NIxxxx_<slot>.ini file in the working directory, nothing to simulate\n"
+                                   "(copy the content of 'defaults config files' next to the executable)");
+    }
+    return true;
+}
+
+void SimulatedDaqBackend::buildChannels(NIDeviceModule *deviceModule, SimulatedAnalogTask &task)
+{
+    const unsigned int channelsCount = deviceModule->getNbChannel();
+    const bool isCurrent = (deviceModule->getModuleType() == ModuleType::isAnalogicInputCurrent);
+    // Current loops live between 4 and 20 mA whatever the module range, voltages use the module range
+    const double low  = isCurrent ? 0.004 : deviceModule->getChanMin();
+    const double high = isCurrent ? 0.020 : deviceModule->getChanMax();
+    const double span = high - low;
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+
+    task.channels.resize(channelsCount);
+    for (unsigned int i = 0; i < channelsCount; ++i)
+    {
+        SimulatedChannel &channel = task.channels[i];
+        // Spread the channels over the range so that each one is recognizable on the modbus side
+        channel.baseline       = low + span * (0.25 + 0.5 * (channelsCount > 1 ? double(i) / double(channelsCount - 1) : 0.5));
+        channel.processSwing   = 0.10  * span;
+        channel.processFreq    = 0.05 + 0.05 * double(i);
+        channel.phase          = 2.0 * M_PI * unit(task.generator);
+        channel.mainsAmplitude = 0.005 * span;
+        channel.noiseSigma     = 0.001 * span;
+    }
+}
+
+TaskHandle SimulatedDaqBackend::createContinuousAnalogTask(NIDeviceModule *deviceModule)
+{
+    if (!deviceModule || deviceModule->getSamplingRate() <= 0.0 || deviceModule->getSamplesPerChannel() == 0)
+    {
+        appendCommentWithTimestamp(m_fileNamesContainer.acquisitionEngineLogFile,
+                                   "In\n"
+                                   "TaskHandle SimulatedDaqBackend::createContinuousAnalogTask(NIDeviceModule *deviceModule)\n"
+                                   "Error: module is null or has no acquisition settings");
+        throw std::invalid_argument("SimulatedDaqBackend: module is null or has no acquisition settings.");
+    }
+
+    std::unique_ptr<SimulatedAnalogTask> task(new SimulatedAnalogTask());
+    task->generator.seed(deviceModule->getSlotNb() * 7919u + 17u);
+    task->samplingRate      = deviceModule->getSamplingRate();
+    task->samplesPerChannel = deviceModule->getSamplesPerChannel();
+    task->blockDuration     = std::chrono::nanoseconds(static_cast<long long>(1e9 * task->samplesPerChannel / task->samplingRate));
+    task->startTime         = std::chrono::steady_clock::now();
+    task->nextBlockTime     = task->startTime + task->blockDuration;
+    buildChannels(deviceModule, *task);
+
+    TaskHandle taskHandle = static_cast<TaskHandle>(task.get());
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_analogTasks[taskHandle] = std::move(task);
+    return taskHandle;
+}
+
+SimulatedDaqBackend::SimulatedAnalogTask *SimulatedDaqBackend::findTask(TaskHandle taskHandle, NIDeviceModule *deviceModule)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_analogTasks.find(taskHandle);
+    if (it == m_analogTasks.end())
+    {
+        throw std::runtime_error("SimulatedDaqBackend: unknown task on " + (deviceModule ? deviceModule->getAlias() : std::string("?")));
+    }
+    return it->second.get();
+}
+
+bool SimulatedDaqBackend::readAnalogBlock(TaskHandle taskHandle, NIDeviceModule *deviceModule, std::vector<double> &dataBuffer)
+{
+    SimulatedAnalogTask *task = findTask(taskHandle, deviceModule);
+
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    // The consumer is later than the simulated ring buffer allows: the samples are lost,
+    // restart the clock like recoverContinuousTask() restarts the DAQmx task
+    if (now > task->nextBlockTime + task->blockDuration * static_cast<int>(bufferBlocks))
+    {
+        task->sampleIndex   += static_cast<uint64_t>((now - task->nextBlockTime) / task->blockDuration) * task->samplesPerChannel;
+        task->nextBlockTime  = now + task->blockDuration;
+        return false;
+    }
+    // A block only exists once the sample clock produced its last sample
+    std::this_thread::sleep_until(task->nextBlockTime);
+
+    const size_t channelsCount = task->channels.size();
+    const unsigned int samplesPerChannel = task->samplesPerChannel;
+    if (dataBuffer.size() < channelsCount * samplesPerChannel)
+    {
+        dataBuffer.resize(channelsCount * samplesPerChannel);
+    }
+
+    // Same layout as DAQmx_Val_GroupByChannel: all the samples of channel 0, then channel 1...
+    const double samplePeriod = 1.0 / task->samplingRate;
+    for (size_t c = 0; c < channelsCount; ++c)
+    {
+        const SimulatedChannel &channel = task->channels[c];
+        std::normal_distribution<double> noise(0.0, channel.noiseSigma);
+        double *out = dataBuffer.data() + c * samplesPerChannel;
+        for (unsigned int s = 0; s < samplesPerChannel; ++s)
+        {
+            const double t = static_cast<double>(task->sampleIndex + s) * samplePeriod;
+            out[s] = channel.baseline
+                   + channel.processSwing   * std::sin(2.0 * M_PI * channel.processFreq * t + channel.phase)
+                   + channel.mainsAmplitude * std::sin(2.0 * M_PI * 50.0 * t)
+                   + noise(task->generator);
+        }
+    }
+    task->sampleIndex   += samplesPerChannel;
+    task->nextBlockTime += task->blockDuration;
+    return true;
+}
+
+bool SimulatedDaqBackend::getAnalogRawScaling(TaskHandle taskHandle, NIDeviceModule *deviceModule, RawAnalogBlock &rawBlock)
+{
+    // Same rule as the DAQmx backend: only voltage modules have a raw path
+    if (!deviceModule || deviceModule->getModuleType() != ModuleType::isAnalogicInputVoltage)
+    {
+        return false;
+    }
+    SimulatedAnalogTask *task = findTask(taskHandle, deviceModule);
+    const double fullScale = std::max(std::fabs(deviceModule->getChanMin()), std::fabs(deviceModule->getChanMax()));
+    task->rawLsb = (fullScale > 0.0 ? fullScale : 10.0) / 8388608.0;
+
+    const size_t channelsCount = task->channels.size();
+    rawBlock.sampleBits = 32;
+    rawBlock.scaling.assign(channelsCount, std::vector<double>{0.0, task->rawLsb});
+    rawBlock.samples16.clear();
+    rawBlock.samples32.assign(channelsCount * task->samplesPerChannel, 0);
+    return true;
+}
+
+bool SimulatedDaqBackend::readAnalogBlockRaw(TaskHandle taskHandle, NIDeviceModule *deviceModule, RawAnalogBlock &rawBlock)
+{
+    SimulatedAnalogTask *task = findTask(taskHandle, deviceModule);
+    if (!readAnalogBlock(taskHandle, deviceModule, task->rawScratch))
+    {
+        return false;
+    }
+    rawBlock.samples32.resize(task->rawScratch.size());
+    for (size_t i = 0; i < task->rawScratch.size(); ++i)
+    {
+        rawBlock.samples32[i] = static_cast<int32>(std::lround(task->rawScratch[i] / task->rawLsb));
+    }
+    return true;
+}
+
+void SimulatedDaqBackend::clearContinuousTask(TaskHandle &taskHandle)
+{
+    if (taskHandle)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_analogTasks.erase(taskHandle);
+        taskHandle = nullptr;
+    }
+}
+
+bool SimulatedDaqBackend::readCounters(NIDeviceModule *deviceModule, const std::vector<std::string> &chanNames, std::vector<uInt32> &values)
+{
+    if (!deviceModule)
+    {
+        throw std::invalid_argument("SimulatedDaqBackend::readCounters: deviceModule is null.");
+    }
+    // Counter n counts at (n + 1) * 100 Hz since the backend was created, wrapping like a 32-bit counter
+    const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_countersStart).count();
+    values.resize(chanNames.size());
+    for (size_t i = 0; i < chanNames.size(); ++i)
+    {
+        const double rate = 100.0 * static_cast<double>(extractNumberFromEnd(chanNames[i]) + 1);
+        values[i] = static_cast<uInt32>(static_cast<uint64_t>(rate * elapsed) & 0xFFFFFFFFull);
+    }
+    return true;
+}
+
+void SimulatedDaqBackend::setRelayStates(NIDeviceModule *deviceModule, const std::vector<std::pair<std::string, bool>> &lineStates)
+{
+    if (!deviceModule)
+    {
+        throw std::invalid_argument("SimulatedDaqBackend::setRelayStates: deviceModule is null.");
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const std::pair<std::string, bool> &lineState : lineStates)
+    {
+        m_relayStates[deviceModule->getAlias() + lineState.first] = lineState.second;
+    }
+}
+
+bool SimulatedDaqBackend::getRelayState(const std::string &moduleAlias, const std::string &chanName) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_relayStates.find(moduleAlias + chanName);
+    return (it != m_relayStates.end()) && it->second;
+}
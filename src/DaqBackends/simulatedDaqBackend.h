@@ -0,0 +1,78 @@
+#ifndef SIMULATEDDAQBACKEND_H
+#define SIMULATEDDAQBACKEND_H
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <chrono>
+
+#include "daqBackend.h"
+#include "../NiModulesDefinitions/NIDeviceModule.h"
+#include "../filesUtils/appendToFileHelper.h"
+#include "../globals/globalEnumStructs.h"
+
+// Hardware free backend reproducing what the cRIO delivers:
+//  - a block of samplesPerChannel samples is returned every samplesPerChannel / samplingRate seconds,
+//    on an absolute sample clock, so a slow consumer sees the same overflow (lost block) as with DAQmx
+//  - each channel carries a slow process signal, 50 Hz mains pickup and gaussian noise,
+//    current modules stay inside a 4-20 mA loop, voltage modules inside the module range
+//  - raw reads quantise the same signal as a 24 bit module would (linear scaling, full range on 2^23 codes)
+//  - counters count at a steady per channel rate, relays only keep their last state
+//  - the modules are the NIxxxx_<slot>.ini files of the working directory, no NISysCfg enumeration is needed
+class SimulatedDaqBackend : public DaqBackend {
+public:
+    SimulatedDaqBackend();
+
+    std::string getBackendName() const override;
+
+    TaskHandle createContinuousAnalogTask (NIDeviceModule *deviceModule) override;
+    bool       readAnalogBlock            (TaskHandle taskHandle, NIDeviceModule *deviceModule, std::vector<double> &dataBuffer) override;
+    void       clearContinuousTask        (TaskHandle &taskHandle) override;
+    bool       getAnalogRawScaling        (TaskHandle taskHandle, NIDeviceModule *deviceModule, RawAnalogBlock &rawBlock) override;
+    bool       readAnalogBlockRaw         (TaskHandle taskHandle, NIDeviceModule *deviceModule, RawAnalogBlock &rawBlock) override;
+    bool       readCounters               (NIDeviceModule *deviceModule, const std::vector<std::string> &chanNames, std::vector<uInt32> &values) override;
+    void       setRelayStates             (NIDeviceModule *deviceModule, const std::vector<std::pair<std::string, bool>> &lineStates) override;
+    bool       describeModules            (std::vector<DaqModuleDescription> &modules) const override;
+
+    bool       getRelayState              (const std::string &moduleAlias, const std::string &chanName) const;
+
+    //number of blocks the simulated ring buffer holds before samples are lost, same as the DAQmx configuration
+    static const unsigned int bufferBlocks = 8;
+
+private:
+    struct SimulatedChannel
+    {
+        double baseline       = 0.0; // process value around which the signal moves
+        double processSwing   = 0.0; // amplitude of the slow process variation
+        double processFreq    = 0.0; // Hz
+        double phase          = 0.0; // rad
+        double mainsAmplitude = 0.0; // 50 Hz pickup
+        double noiseSigma     = 0.0;
+    };
+
+    struct SimulatedAnalogTask
+    {
+        std::vector<SimulatedChannel>          channels;
+        double                                 samplingRate      = 0.0;
+        unsigned int                           samplesPerChannel = 0;
+        uint64_t                               sampleIndex       = 0;  // index of the next sample on the simulated sample clock
+        std::chrono::steady_clock::time_point  startTime;
+        std::chrono::steady_clock::time_point  nextBlockTime;          // absolute time at which the next block is complete
+        std::chrono::nanoseconds               blockDuration{0};
+        std::mt19937                           generator;
+        double                                 rawLsb            = 0.0; // volts per code of the raw reads
+        std::vector<double>                    rawScratch;             // scaled block quantised by readAnalogBlockRaw
+    };
+
+    void                 buildChannels(NIDeviceModule *deviceModule, SimulatedAnalogTask &task);
+    SimulatedAnalogTask *findTask     (TaskHandle taskHandle, NIDeviceModule *deviceModule);
+
+    mutable std::mutex                                                  m_mutex;
+    std::map<TaskHandle, std::unique_ptr<SimulatedAnalogTask>>          m_analogTasks;
+    std::map<std::string, bool>                                         m_relayStates;   // "Mod6/port0/line0" -> state
+    std::chrono::steady_clock::time_point                               m_countersStart;
+    GlobalFileNamesContainer                                            m_fileNamesContainer;
+};
+
+#endif // SIMULATEDDAQBACKEND_H
@@ -0,0 +1,58 @@
+#include "CounterRateEstimator.h"
+
+CounterRateEstimator::CounterRateEstimator():
+	windowSeconds(1.0),
+	frequency(0.0){}
+
+CounterRateEstimator::CounterRateEstimator(double iWindowSeconds):
+	windowSeconds(iWindowSeconds > 0.0 ? iWindowSeconds : 1.0),
+	frequency(0.0){}
+
+double CounterRateEstimator::update(uint32_t count, TimePoint time)
+{
+	if (!samples.empty())
+	{
+		// Unsigned difference handles the 32-bit wrap; a "negative" jump larger than half the range
+		// means the counter was restarted (task recreated), the history is meaningless then
+		const uint32_t lastDelta = count - samples.back().second;
+		if (lastDelta > 0x80000000u || time < samples.back().first)
+		{
+			reset();
+		}
+	}
+	samples.emplace_back(time, count);
+
+	// Keep the newest sample that is at least one window old as the reference
+	const std::chrono::nanoseconds window(static_cast<long long>(windowSeconds * 1e9));
+	while (samples.size() > 2 && (time - samples[1].first) >= window)
+	{
+		samples.pop_front();
+	}
+
+	if (samples.size() < 2)
+	{
+		frequency = 0.0;
+		return frequency;
+	}
+	const long long elapsedNs = std::chrono::duration_cast<std::chrono::nanoseconds>(time - samples.front().first).count();
+	if (elapsedNs > 0)
+	{
+		const uint32_t deltaCount = count - samples.front().second;
+		frequency = static_cast<double>(deltaCount) * 1e9 / static_cast<double>(elapsedNs);
+	}
+	return frequency;
+}
+
+void CounterRateEstimator::reset()
+{
+	samples.clear();
+	frequency = 0.0;
+}
+
+void CounterRateEstimator::reconfigure(double iWindowSeconds)
+{
+	if (iWindowSeconds > 0.0)
+	{
+		windowSeconds = iWindowSeconds;
+	}
+}
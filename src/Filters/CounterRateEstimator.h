@@ -0,0 +1,32 @@
+#ifndef CounterRateEstimator_h
+#define CounterRateEstimator_h
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <utility>
+
+// Frequency of an edge counter estimated over a sliding time window.
+// Each update() stores (time, count); the frequency is the count difference between the newest
+// sample and the oldest sample still inside the window, divided by their nanosecond time difference.
+// A longer window averages more ticks, a shorter one follows faster changes.
+class CounterRateEstimator{
+public:
+	typedef std::chrono::steady_clock::time_point TimePoint;
+	//constructors
+	CounterRateEstimator();
+	explicit CounterRateEstimator(double iWindowSeconds);
+	//functions
+	double update(uint32_t count, TimePoint time);
+	void   reset();
+	//get and configure funtions
+	double getFrequency() const{return frequency;}
+	double getWindow()    const{return windowSeconds;}
+	void   reconfigure(double iWindowSeconds);
+private:
+	std::deque<std::pair<TimePoint, uint32_t>> samples;
+	double windowSeconds;
+	double frequency;
+};
+
+#endif //CounterRateEstimator_h
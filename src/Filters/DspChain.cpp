@@ -0,0 +1,499 @@
+#include "DspChain.h"
+
+#include <cmath>
+#include <cctype>
+#include <cstdlib>
+#include <sstream>
+#include <algorithm>
+
+#include "../mathUtils/blockReduction.h"
+
+DspChain::DspChain():
+	nbChannels(0),
+	publishLast(false),
+	hasWindow(false),
+	windowLength(0),
+	windowFill(0),
+	windowPos(0){}
+
+bool DspChain::parseChain(const std::string &chain, const DspChainSettings &settings, double samplingRate,
+                          std::vector<ParsedStage> &parsed, bool &windowed, double &outputRate, std::string &error)
+{
+	double rate = samplingRate;
+	std::stringstream stream(chain);
+	std::string token;
+	while (std::getline(stream, token, ','))
+	{
+		token.erase(std::remove_if(token.begin(), token.end(), ::isspace), token.end());
+		std::transform(token.begin(), token.end(), token.begin(), ::tolower);
+		if (token.empty() || token == "none")
+		{
+			continue;
+		}
+		if (windowed)
+		{
+			error = "window must be the last stage";
+			return false;
+		}
+		// "name" or "name:factor"
+		std::string name = token;
+		unsigned int factor = 0;
+		const size_t colon = token.find(':');
+		if (colon != std::string::npos)
+		{
+			name = token.substr(0, colon);
+			const long value = std::strtol(token.c_str() + colon + 1, nullptr, 10);
+			if (value < 1)
+			{
+				error = "invalid factor in '" + token + "'";
+				return false;
+			}
+			factor = static_cast<unsigned int>(value);
+		}
+
+		// The window length and the biquad frequencies come from the [filters] keys, a factor would be ignored
+		if (colon != std::string::npos && (name == "window" || name == "notch" || name == "lowpass"))
+		{
+			error = "'" + token + "': " + name + " takes no factor, its settings are in the [filters] section";
+			return false;
+		}
+		if (name == "window")
+		{
+			windowed = true;
+			continue;
+		}
+		if (name == "notch" || name == "lowpass")
+		{
+			const double frequency = (name == "notch") ? settings.notchFrequency : settings.lowPassCutoff;
+			if (frequency >= rate / 2.0)
+			{
+				error = name + " frequency above the Nyquist frequency of its input (" + std::to_string(rate) + " Hz)";
+				return false;
+			}
+			parsed.push_back({(name == "notch") ? notchStage : lowPassStage, 1, rate});
+			continue;
+		}
+
+		StageType type;
+		if      (name == "decimate") type = decimateStage;
+		else if (name == "cic")      type = cicStage;
+		else if (name == "fir")      type = firStage;
+		else
+		{
+			error = "unknown stage '" + token + "'";
+			return false;
+		}
+		if (factor == 0)
+		{
+			factor = (settings.outputRate > 0.0) ? static_cast<unsigned int>(std::max(1.0, std::round(rate / settings.outputRate)))
+			                                     : std::max(1u, settings.decimation);
+		}
+		parsed.push_back({type, factor, rate});
+		rate /= factor;
+	}
+	outputRate = rate;
+	return true;
+}
+
+bool DspChain::compile(const DspChainSettings &settings, double samplingRate, double fullScale, size_t iNbChannels, std::string &error)
+{
+	stages.clear();
+	nbChannels = 0;
+	hasWindow  = false;
+
+	if (samplingRate <= 0.0)
+	{
+		error = "the module has no sampling rate";
+		return false;
+	}
+	if (settings.notchFrequency <= 0.0 || settings.notchQ <= 0.0 || settings.lowPassCutoff <= 0.0 || settings.lowPassQ <= 0.0)
+	{
+		error = "notch and low-pass frequencies and Q must be > 0";
+		return false;
+	}
+
+	// Parse every channel chain into its list of sample stages, the window is kept apart
+	std::vector<std::vector<ParsedStage>> channelStages(iNbChannels);
+	std::vector<char>   channelWindowed(iNbChannels, 0);
+	std::vector<double> channelRates(iNbChannels, samplingRate);
+	for (size_t channel = 0; channel < iNbChannels && channel < settings.channelChains.size(); ++channel)
+	{
+		bool windowedChannel = false;
+		if (!parseChain(settings.channelChains[channel], settings, samplingRate, channelStages[channel], windowedChannel, channelRates[channel], error))
+		{
+			error += " (channel " + std::to_string(channel) + ")";
+			return false;
+		}
+		channelWindowed[channel] = windowedChannel ? 1 : 0;
+	}
+	if (std::count(channelWindowed.begin(), channelWindowed.end(), 1) > 0 && settings.windowLength == 0)
+	{
+		error = "window length must be > 0";
+		return false;
+	}
+
+	// Stage n of every chain is grouped by type and factor, the channels keep their own order of stages
+	size_t longestChain = 0;
+	for (const std::vector<ParsedStage> &chain : channelStages)
+	{
+		longestChain = std::max(longestChain, chain.size());
+	}
+	for (size_t position = 0; position < longestChain; ++position)
+	{
+		const size_t firstStage = stages.size();
+		for (size_t channel = 0; channel < iNbChannels; ++channel)
+		{
+			if (position >= channelStages[channel].size())
+			{
+				continue;
+			}
+			const ParsedStage &parsed = channelStages[channel][position];
+			size_t stageIndex = stages.size();
+			for (size_t i = firstStage; i < stages.size(); ++i)
+			{
+				if (stages[i].type == parsed.type && stages[i].factor == parsed.factor) stageIndex = i;
+			}
+			if (stageIndex == stages.size())
+			{
+				stages.push_back(Stage());
+				Stage &stage = stages.back();
+				stage.type   = parsed.type;
+				stage.factor = parsed.factor;
+				if (stage.type == cicStage && !designCic(stage, settings, fullScale, error))
+				{
+					return false;
+				}
+				if (stage.type == firStage)
+				{
+					designFir(stage, settings);
+				}
+			}
+			Stage &stage = stages[stageIndex];
+			stage.channels.push_back(channel);
+			switch (stage.type)
+			{
+				case notchStage:
+				case lowPassStage:
+					addBiquad(stage, parsed, settings);
+					break;
+				case decimateStage:
+					stage.phases.push_back(0);
+					break;
+				case cicStage:
+					stage.phases.push_back(0);
+					stage.integrators.resize(stage.integrators.size() + stage.order, 0);
+					stage.combs.resize(stage.combs.size() + stage.order, 0);
+					break;
+				case firStage:
+					stage.phases.push_back(0);
+					stage.primed.push_back(0);
+					stage.history.resize(stage.history.size() + stage.taps.size() - 1, 0.0);
+					break;
+			}
+		}
+	}
+
+	nbChannels = iNbChannels;
+	lengths.assign(nbChannels, 0);
+	lastValues.assign(nbChannels, 0.0);
+	outputRates = channelRates;
+	publishLast = settings.publishLast;
+	windowed = channelWindowed;
+	hasWindow = std::count(windowed.begin(), windowed.end(), 1) > 0;
+	windowLength = settings.windowLength;
+	windowHistory.assign(hasWindow ? nbChannels * windowLength : 0, 0.0);
+	windowFill = 0;
+	windowPos  = 0;
+	return true;
+}
+
+void DspChain::addBiquad(Stage &stage, const ParsedStage &parsed, const DspChainSettings &settings)
+{
+	// Frequencies and Q are checked by compile() and parseChain() (> 0, below the Nyquist frequency of the stage)
+	// Audio EQ cookbook (R. Bristow-Johnson) coefficients, normalised by a0, at the rate seen by this stage
+	const bool   notch     = (parsed.type == notchStage);
+	const double frequency = notch ? settings.notchFrequency : settings.lowPassCutoff;
+	const double q         = notch ? settings.notchQ         : settings.lowPassQ;
+	const double w0        = 2.0 * M_PI * frequency / parsed.inputRate;
+	const double cosW0     = std::cos(w0);
+	const double alpha     = std::sin(w0) / (2.0 * q);
+	const double a0        = 1.0 + alpha;
+	if (notch)
+	{
+		stage.b0.push_back(1.0 / a0);
+		stage.b1.push_back(-2.0 * cosW0 / a0);
+		stage.b2.push_back(1.0 / a0);
+	}
+	else
+	{
+		stage.b0.push_back((1.0 - cosW0) / 2.0 / a0);
+		stage.b1.push_back((1.0 - cosW0) / a0);
+		stage.b2.push_back((1.0 - cosW0) / 2.0 / a0);
+	}
+	stage.a1.push_back(-2.0 * cosW0 / a0);
+	stage.a2.push_back((1.0 - alpha) / a0);
+	stage.z1.push_back(0.0);
+	stage.z2.push_back(0.0);
+	stage.primed.push_back(0);
+}
+
+bool DspChain::designCic(Stage &stage, const DspChainSettings &settings, double fullScale, std::string &error)
+{
+	if (settings.cicOrder < 1 || settings.cicOrder > 6)
+	{
+		error = "cic order must be between 1 and 6";
+		return false;
+	}
+	stage.order = settings.cicOrder;
+	// The integrators wrap, which is harmless as long as the comb output, input x factor^order, fits in 63 bits:
+	// the input is quantised with the largest power of two scale that keeps it so
+	const double gain  = std::pow(static_cast<double>(stage.factor), static_cast<double>(stage.order));
+	const double range = (fullScale > 0.0 ? fullScale : 1.0) * gain;
+	const int    bits  = static_cast<int>(std::floor(std::log2(std::ldexp(1.0, 62) / range)));
+	if (bits < 16)
+	{
+		error = "cic factor^order too large for the 64 bit integrators, use a lower order or cascade with fir";
+		return false;
+	}
+	stage.scale      = std::ldexp(1.0, bits);
+	stage.outputGain = 1.0 / (stage.scale * gain);
+	return true;
+}
+
+void DspChain::designFir(Stage &stage, const DspChainSettings &settings)
+{
+	// Blackman windowed sinc low-pass, pass band edge at 80 % of the output Nyquist frequency
+	const size_t length = std::max<size_t>(2, static_cast<size_t>(std::max(1u, settings.firTapsPerPhase)) * stage.factor);
+	const double cutoff = 0.4 / static_cast<double>(stage.factor); // cycles per input sample
+	const double center = 0.5 * static_cast<double>(length - 1);
+	std::vector<double> taps(length);
+	double sum = 0.0;
+	for (size_t n = 0; n < length; ++n)
+	{
+		const double x      = static_cast<double>(n) - center;
+		const double sinc   = (x == 0.0) ? 2.0 * cutoff : std::sin(2.0 * M_PI * cutoff * x) / (M_PI * x);
+		const double phase  = 2.0 * M_PI * static_cast<double>(n) / static_cast<double>(length - 1);
+		const double window = 0.42 - 0.5 * std::cos(phase) + 0.08 * std::cos(2.0 * phase);
+		taps[n] = sinc * window;
+		sum += taps[n];
+	}
+	// Unit gain at DC, stored reversed so that an output is a dot product over contiguous inputs
+	stage.taps.resize(length);
+	for (size_t n = 0; n < length; ++n)
+	{
+		stage.taps[length - 1 - n] = taps[n] / sum;
+	}
+}
+
+void DspChain::reset()
+{
+	for (Stage &stage : stages)
+	{
+		std::fill(stage.z1.begin(), stage.z1.end(), 0.0);
+		std::fill(stage.z2.begin(), stage.z2.end(), 0.0);
+		std::fill(stage.primed.begin(), stage.primed.end(), 0);
+		std::fill(stage.phases.begin(), stage.phases.end(), 0);
+		std::fill(stage.integrators.begin(), stage.integrators.end(), 0);
+		std::fill(stage.combs.begin(), stage.combs.end(), 0);
+		std::fill(stage.history.begin(), stage.history.end(), 0.0);
+	}
+	std::fill(lastValues.begin(), lastValues.end(), 0.0);
+	std::fill(windowHistory.begin(), windowHistory.end(), 0.0);
+	windowFill = 0;
+	windowPos  = 0;
+}
+
+void DspChain::runBiquad(Stage &stage, double *block, size_t samplesPerChannel)
+{
+	for (size_t k = 0; k < stage.channels.size(); ++k)
+	{
+		const size_t channel = stage.channels[k];
+		const size_t count   = lengths[channel];
+		if (count == 0)
+		{
+			continue;
+		}
+		double *samples = block + channel * samplesPerChannel;
+		const double b0 = stage.b0[k], b1 = stage.b1[k], b2 = stage.b2[k], a1 = stage.a1[k], a2 = stage.a2[k];
+		double z1 = stage.z1[k], z2 = stage.z2[k];
+		if (!stage.primed[k])
+		{
+			// Steady state for a constant input equal to the first sample
+			const double x0 = samples[0];
+			const double y0 = x0 * (b0 + b1 + b2) / (1.0 + a1 + a2);
+			z2 = b2 * x0 - a2 * y0;
+			z1 = b1 * x0 - a1 * y0 + z2;
+			stage.primed[k] = 1;
+		}
+		for (size_t i = 0; i < count; ++i)
+		{
+			const double x = samples[i];
+			const double y = b0 * x + z1;
+			z1 = b1 * x - a1 * y + z2;
+			z2 = b2 * x - a2 * y;
+			samples[i] = y;
+		}
+		stage.z1[k] = z1;
+		stage.z2[k] = z2;
+	}
+}
+
+void DspChain::runDecimate(Stage &stage, double *block, size_t samplesPerChannel)
+{
+	const size_t factor = stage.factor;
+	for (size_t k = 0; k < stage.channels.size(); ++k)
+	{
+		const size_t channel = stage.channels[k];
+		const size_t count   = lengths[channel];
+		double *samples = block + channel * samplesPerChannel;
+		// Kept samples are packed at the front of the channel, the phase carries over to the next block
+		size_t kept = 0;
+		size_t i    = stage.phases[k];
+		for (; i < count; i += factor)
+		{
+			samples[kept++] = samples[i];
+		}
+		stage.phases[k]  = i - count;
+		lengths[channel] = kept;
+	}
+}
+
+void DspChain::runCic(Stage &stage, double *block, size_t samplesPerChannel)
+{
+	const size_t       factor = stage.factor;
+	const unsigned int order  = stage.order;
+	for (size_t k = 0; k < stage.channels.size(); ++k)
+	{
+		const size_t channel = stage.channels[k];
+		const size_t count   = lengths[channel];
+		double   *samples     = block + channel * samplesPerChannel;
+		uint64_t *integrators = stage.integrators.data() + k * order;
+		uint64_t *combs       = stage.combs.data()       + k * order;
+		size_t    phase       = stage.phases[k];
+		size_t    kept        = 0;
+		for (size_t i = 0; i < count; ++i)
+		{
+			// unsigned arithmetic: the wrap around of the integrators is defined and cancelled by the combs
+			uint64_t value = static_cast<uint64_t>(static_cast<int64_t>(std::llround(samples[i] * stage.scale)));
+			for (unsigned int j = 0; j < order; ++j)
+			{
+				integrators[j] += value;
+				value = integrators[j];
+			}
+			if (++phase < factor)
+			{
+				continue;
+			}
+			phase = 0;
+			for (unsigned int j = 0; j < order; ++j)
+			{
+				const uint64_t delayed = combs[j];
+				combs[j] = value;
+				value -= delayed;
+			}
+			samples[kept++] = static_cast<double>(static_cast<int64_t>(value)) * stage.outputGain;
+		}
+		stage.phases[k]  = phase;
+		lengths[channel] = kept;
+	}
+}
+
+void DspChain::runFir(Stage &stage, double *block, size_t samplesPerChannel)
+{
+	const size_t factor  = stage.factor;
+	const size_t length  = stage.taps.size();
+	const size_t delay   = length - 1;
+	const double *taps   = stage.taps.data();
+	for (size_t k = 0; k < stage.channels.size(); ++k)
+	{
+		const size_t channel = stage.channels[k];
+		const size_t count   = lengths[channel];
+		if (count == 0)
+		{
+			continue;
+		}
+		double *samples = block + channel * samplesPerChannel;
+		double *history = stage.history.data() + k * delay;
+		if (!stage.primed[k])
+		{
+			// Steady state: the past is taken equal to the first sample
+			std::fill(history, history + delay, samples[0]);
+			stage.primed[k] = 1;
+		}
+		// Contiguous view of the previous inputs followed by the block
+		stage.scratch.resize(delay + count);
+		std::copy(history, history + delay, stage.scratch.begin());
+		std::copy(samples, samples + count, stage.scratch.begin() + delay);
+		const double *input = stage.scratch.data();
+
+		// Polyphase: only the kept outputs are computed, output i ends on input sample i
+		size_t kept = 0;
+		size_t i    = stage.phases[k];
+		for (; i < count; i += factor)
+		{
+			const double *x = input + i;
+			double s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0;
+			size_t n = 0;
+			for (; n + 4 <= length; n += 4)
+			{
+				s0 += taps[n]     * x[n];
+				s1 += taps[n + 1] * x[n + 1];
+				s2 += taps[n + 2] * x[n + 2];
+				s3 += taps[n + 3] * x[n + 3];
+			}
+			for (; n < length; ++n) s0 += taps[n] * x[n];
+			samples[kept++] = (s0 + s1) + (s2 + s3);
+		}
+		stage.phases[k] = i - count;
+		std::copy(input + count, input + count + delay, history);
+		lengths[channel] = kept;
+	}
+}
+
+void DspChain::runWindow(double *values)
+{
+	if (windowFill < windowLength) ++windowFill;
+	for (size_t channel = 0; channel < nbChannels; ++channel)
+	{
+		if (!windowed[channel])
+		{
+			continue;
+		}
+		double *history = windowHistory.data() + channel * windowLength;
+		history[windowPos] = values[channel];
+		double sum = 0.0;
+		for (unsigned int i = 0; i < windowFill; ++i) sum += history[i];
+		values[channel] = sum / windowFill;
+	}
+	windowPos = (windowPos + 1) % windowLength;
+}
+
+void DspChain::process(double *block, size_t samplesPerChannel, double *values)
+{
+	std::fill(lengths.begin(), lengths.end(), samplesPerChannel);
+	for (Stage &stage : stages)
+	{
+		switch (stage.type)
+		{
+			case notchStage:
+			case lowPassStage:  runBiquad  (stage, block, samplesPerChannel); break;
+			case decimateStage: runDecimate(stage, block, samplesPerChannel); break;
+			case cicStage:      runCic     (stage, block, samplesPerChannel); break;
+			case firStage:      runFir     (stage, block, samplesPerChannel); break;
+		}
+	}
+	for (size_t channel = 0; channel < nbChannels; ++channel)
+	{
+		const size_t count = lengths[channel];
+		if (count > 0)
+		{
+			const double *samples = block + channel * samplesPerChannel;
+			lastValues[channel] = publishLast ? samples[count - 1] : blockMean(samples, count);
+		}
+		values[channel] = lastValues[channel];
+	}
+	if (hasWindow)
+	{
+		runWindow(values);
+	}
+}
@@ -0,0 +1,100 @@
+#ifndef DspChain_h
+#define DspChain_h
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "../globals/globalEnumStructs.h"
+
+// Per channel processing chain of an analogic module, compiled once from its DspChainSettings.
+// Compilation turns the chain descriptions into a flat list of stages, each stage holding the channels
+// it applies to and their state in contiguous arrays: a block only pays for the stages that are enabled,
+// the switch on the stage type runs once per stage and per block, never per sample.
+//  - notch    : RBJ biquad band-stop at notchFrequency (50/60 Hz mains pickup)
+//  - lowpass  : RBJ biquad low-pass at lowPassCutoff
+//  - decimate : keeps one sample out of N, no anti-aliasing (only after a low-pass)
+//  - cic      : cascaded integrator comb decimator, cicOrder stages, exact in wrapping 64 bit integers
+//  - fir      : polyphase FIR decimator, Blackman windowed sinc designed at compile time,
+//               only the kept outputs are computed
+//  - window   : rolling average of the last windowLength block values (must end the chain, takes no factor)
+// The sample rate is followed along each chain, so a biquad placed after a decimator is designed at the decimated rate.
+// Every stage keeps its state across blocks: the rejection no longer depends on the block length,
+// which can be shortened to publish faster.
+// The biquads start in steady state on the first sample, there is no start-up transient from 0.
+class DspChain{
+public:
+	//constructors
+	DspChain();
+	//functions
+	// fullScale: largest absolute value the module can return, sizes the fixed point of the cic stages
+	bool   compile(const DspChainSettings &settings, double samplingRate, double fullScale, size_t iNbChannels, std::string &error);
+	// Filters the block (DAQmx_Val_GroupByChannel layout) in place and writes one value per channel
+	void   process(double *block, size_t samplesPerChannel, double *values);
+	void   reset();
+	//get and configure funtions
+	bool   isEmpty()     const{return nbChannels == 0;}
+	size_t getNbStages() const{return stages.size() + (hasWindow ? 1 : 0);}
+	// Output rate of a channel once all its decimations are applied
+	double getOutputRate(size_t channel) const{return channel < outputRates.size() ? outputRates[channel] : 0.0;}
+private:
+	enum StageType{notchStage, lowPassStage, decimateStage, cicStage, firStage};
+
+	struct Stage
+	{
+		StageType             type;
+		unsigned int          factor = 1;
+		std::vector<size_t>   channels;
+		//biquads, one entry per channel of the stage (transposed direct form II)
+		std::vector<double>   b0, b1, b2, a1, a2;
+		std::vector<double>   z1, z2;
+		std::vector<char>     primed;
+		//decimators, index of the next kept sample in the coming block
+		std::vector<size_t>   phases;
+		//cic: order integrators then order comb delays per channel
+		unsigned int          order = 0;
+		double                scale = 1.0;        // input quantisation, 2^k
+		double                outputGain = 1.0;   // 1 / (scale * factor^order)
+		std::vector<uint64_t> integrators;
+		std::vector<uint64_t> combs;
+		//fir: taps in reverse order, history holds the last taps-1 inputs of each channel
+		std::vector<double>   taps;
+		std::vector<double>   history;
+		std::vector<double>   scratch;
+	};
+
+	struct ParsedStage
+	{
+		StageType    type;
+		unsigned int factor;
+		double       inputRate;
+	};
+
+	bool parseChain  (const std::string &chain, const DspChainSettings &settings, double samplingRate,
+	                  std::vector<ParsedStage> &parsed, bool &windowed, double &outputRate, std::string &error);
+	void addBiquad   (Stage &stage, const ParsedStage &parsed, const DspChainSettings &settings);
+	bool designCic   (Stage &stage, const DspChainSettings &settings, double fullScale, std::string &error);
+	void designFir   (Stage &stage, const DspChainSettings &settings);
+	void runBiquad   (Stage &stage, double *block, size_t samplesPerChannel);
+	void runDecimate (Stage &stage, double *block, size_t samplesPerChannel);
+	void runCic      (Stage &stage, double *block, size_t samplesPerChannel);
+	void runFir      (Stage &stage, double *block, size_t samplesPerChannel);
+	void runWindow   (double *values);
+
+	size_t                   nbChannels;
+	std::vector<Stage>       stages;
+	std::vector<size_t>      lengths;         // samples left in each channel after the decimations of the block
+	std::vector<double>      lastValues;      // value kept when a decimation left no sample in a block
+	std::vector<double>      outputRates;
+	bool                     publishLast;
+	//window stage
+	bool                     hasWindow;
+	unsigned int             windowLength;
+	std::vector<char>        windowed;        // per channel
+	std::vector<double>      windowHistory;   // nbChannels x windowLength ring buffers
+	unsigned int             windowFill;      // values in the ring buffers, up to windowLength
+	unsigned int             windowPos;
+};
+
+#endif //DspChain_h
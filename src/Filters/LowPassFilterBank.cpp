@@ -0,0 +1,59 @@
+#include "LowPassFilterBank.h"
+
+LowPassFilterBank::LowPassFilterBank(){}
+
+LowPassFilterBank::LowPassFilterBank(size_t iNbChannels)
+{
+	resize(iNbChannels);
+}
+
+void LowPassFilterBank::resize(size_t iNbChannels)
+{
+	// A channel without configuration lets its input through (coefficient 1)
+	outputs.assign(iNbChannels, 0.0);
+	coefficients.assign(iNbChannels, 1.0);
+	deltaTimes.assign(iNbChannels, 0.0);
+	cutoffFrequencies.assign(iNbChannels, 0.0);
+}
+
+void LowPassFilterBank::reset()
+{
+	outputs.assign(outputs.size(), 0.0);
+}
+
+void LowPassFilterBank::reconfigure(double deltaTime, double cutoffFrequency)
+{
+	for (size_t channel = 0; channel < coefficients.size(); ++channel)
+	{
+		reconfigureChannel(channel, deltaTime, cutoffFrequency);
+	}
+}
+
+void LowPassFilterBank::reconfigureChannel(size_t channel, double deltaTime, double cutoffFrequency)
+{
+	if (channel >= coefficients.size() || (deltaTimes[channel] == deltaTime && cutoffFrequencies[channel] == cutoffFrequency))
+	{
+		return;
+	}
+	deltaTimes[channel]        = deltaTime;
+	cutoffFrequencies[channel] = cutoffFrequency;
+	// Same coefficient as LowPassFilter, an invalid setting disables the filter instead of freezing the output
+	coefficients[channel] = (deltaTime > 0.0 && cutoffFrequency > 0.0) ? 1.0 - std::exp(-deltaTime * 2.0 * M_PI * cutoffFrequency) : 1.0;
+}
+
+void LowPassFilterBank::filterBlock(double *block, size_t samplesPerChannel)
+{
+	const size_t nbChannels = outputs.size();
+	for (size_t channel = 0; channel < nbChannels; ++channel)
+	{
+		double *samples          = block + channel * samplesPerChannel;
+		double output            = outputs[channel];
+		const double coefficient = coefficients[channel];
+		for (size_t i = 0; i < samplesPerChannel; ++i)
+		{
+			output += (samples[i] - output) * coefficient;
+			samples[i] = output;
+		}
+		outputs[channel] = output;
+	}
+}
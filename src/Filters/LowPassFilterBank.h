@@ -0,0 +1,36 @@
+#ifndef LowPassFilterBank_h
+#define LowPassFilterBank_h
+
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+// First order low-pass filters of every channel of a module, same recurrence as LowPassFilter
+// (output += (input - output) * coefficient) but each channel keeps its own state.
+// Structure of arrays: outputs, coefficients and their settings are contiguous per channel,
+// a block (DAQmx_Val_GroupByChannel layout) is filtered in one pass, channel after channel,
+// with the state of the running channel held in registers.
+// The exp() of a coefficient only runs when its delta time or cut-off frequency actually change.
+class LowPassFilterBank{
+public:
+	//constructors
+	LowPassFilterBank();
+	explicit LowPassFilterBank(size_t iNbChannels);
+	//functions
+	void   filterBlock(double *block, size_t samplesPerChannel);
+	void   reset();
+	//get and configure funtions
+	void   resize(size_t iNbChannels);
+	void   reconfigure(double deltaTime, double cutoffFrequency);
+	void   reconfigureChannel(size_t channel, double deltaTime, double cutoffFrequency);
+	size_t getNbChannels() const{return outputs.size();}
+	double getOutput(size_t channel) const{return outputs[channel];}
+	double getCoefficient(size_t channel) const{return coefficients[channel];}
+private:
+	std::vector<double> outputs;
+	std::vector<double> coefficients;
+	std::vector<double> deltaTimes;
+	std::vector<double> cutoffFrequencies;
+};
+
+#endif //LowPassFilterBank_h
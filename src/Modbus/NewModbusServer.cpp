@@ -5,33 +5,67 @@
 #include <unistd.h>
 #include <arpa/inet.h>
 #include <cerrno>
+#include <algorithm>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <thread>
 #include "../Bridge/niToModbusBridge.h"
 
 
 NewModbusServer::NewModbusServer()
-    : ctx(nullptr), mb_mapping(nullptr), server_socket(-1), fdmax(0)
+    : mb_mapping(nullptr)
 {
-    // Initialize the reference set for socket descriptors
-    FD_ZERO(&refset);
     // Create a shared pointer for IniObject
     m_ini = std::make_shared<IniObject>();
     // Load configuration from an INI file
     loadConfig();
-    // Initialize the modbus context and handle any errors
+    // Initialize the shared modbus mapping and handle any errors
     initializeModbusContext();
-    // Setup the server socket and handle any errors
-    setupServerSocket();
+    // The relays are written by the actuator thread only, one pending command per coil of the mapping
+    m_coilCommands.reset(new CoilCommandQueue(static_cast<size_t>(mb_mapping->nb_bits)));
+    m_appliedCoilStates.assign(static_cast<size_t>(mb_mapping->nb_bits), 0);
+    m_actuatorRunning.store(true);
+    m_actuatorThread = std::thread(&NewModbusServer::runActuator, this);
+    // Setup the serving threads, their sockets and contexts, and handle any errors
+    setupWorkers();
+    m_serverRunning.store(true);
 }
 
 NewModbusServer::~NewModbusServer() {
-    // Check if the server_socket is valid and close it
-    if (server_socket != -1) {
-        close(server_socket);
+    // The workers use their epoll instance, sockets and context until they return: they are joined before any is closed
+    stopServer();
+    for (std::thread &workerThread : m_workerThreads) {
+        if (workerThread.joinable()) {
+            workerThread.join();
+        }
+    }
+
+    // The commands still queued are dropped, the actuator ends within one wait
+    m_actuatorRunning.store(false);
+    if (m_actuatorThread.joinable()) {
+        m_actuatorThread.join();
     }
 
-    // Free the modbus context
-    if (ctx != nullptr) {
-        modbus_free(ctx);
+    // Close the client connections, the epoll instances, the listening sockets and free the contexts
+    for (std::unique_ptr<ModbusWorker> &worker : m_workers) {
+        for (auto &connection : worker->connections) {
+            close(connection.first);
+        }
+        if (worker->epollFd != -1) {
+            close(worker->epollFd);
+        }
+        if (worker->stopEventFd != -1) {
+            close(worker->stopEventFd);
+        }
+        if (worker->serverSocket != -1) {
+            close(worker->serverSocket);
+        }
+        if (worker->ctx != nullptr) {
+            modbus_free(worker->ctx);
+        }
     }
 
     // Free the modbus mapping
@@ -75,6 +109,27 @@ void NewModbusServer::loadConfig()
         {
             appendCommentWithTimestamp(fileNamesContainer.newModbusServerLogFile,"in NewModbusServer::loadConfig() reading 'exlog' 'nbalarms' failed");
         }
+        // Read the 'maxconnections' setting, the clients beyond it are refused
+        m_maxConnections = m_ini->readInteger("network", "maxconnections", m_maxConnections, fileNamesContainer.modbusIniFile,ok);
+        if (!ok || m_maxConnections <= 0)
+        {
+            appendCommentWithTimestamp(fileNamesContainer.newModbusServerLogFile,"in NewModbusServer::loadConfig() reading 'network' 'maxconnections' failed");
+            m_maxConnections = 25;
+        }
+        // Read the 'workerthreads' setting, each worker serves its own share of the clients
+        m_nbWorkers = m_ini->readInteger("network", "workerthreads", m_nbWorkers, fileNamesContainer.modbusIniFile,ok);
+        if (!ok || m_nbWorkers <= 0)
+        {
+            appendCommentWithTimestamp(fileNamesContainer.newModbusServerLogFile,"in NewModbusServer::loadConfig() reading 'network' 'workerthreads' failed");
+            m_nbWorkers = 1;
+        }
+        // Read the 'idletimeoutms' setting, a client silent for longer is disconnected (0 keeps them forever)
+        m_idleTimeoutMs = m_ini->readInteger("network", "idletimeoutms", m_idleTimeoutMs, fileNamesContainer.modbusIniFile,ok);
+        if (!ok || m_idleTimeoutMs < 0)
+        {
+            appendCommentWithTimestamp(fileNamesContainer.newModbusServerLogFile,"in NewModbusServer::loadConfig() reading 'network' 'idletimeoutms' failed");
+            m_idleTimeoutMs = 60000;
+        }
     } 
     catch (const std::exception& e) 
     {
@@ -85,19 +140,7 @@ void NewModbusServer::loadConfig()
 }
 
 void NewModbusServer::initializeModbusContext() {
-    // Initialize modbus context with TCP protocol listening on "0.0.0.0" and port 502
-    ctx = modbus_new_tcp("0.0.0.0", 502);
-
-    // Check for context initialization errors
-    if (ctx == nullptr) 
-    {
-        appendCommentWithTimestamp(fileNamesContainer.newModbusServerLogFile,"inNewModbusServer::initializeModbusContext() Failed to initialize modbus context: " + std::string(modbus_strerror(errno)));
-        std::cerr << "Unable to listen TCP connection: " << modbus_strerror(errno) << std::endl;
-        std::cerr << "Failed to initialize modbus context: " << modbus_strerror(errno) << std::endl;
-        exit(EXIT_FAILURE);
-    }
-
-    // Create an internal modbus mapping
+    // Create the internal modbus mapping shared by the workers
     mb_mapping = modbus_mapping_new(20, 20, 512, 512);
 
     // Check for mapping allocation errors
@@ -105,7 +148,6 @@ void NewModbusServer::initializeModbusContext() {
     {
         appendCommentWithTimestamp(fileNamesContainer.newModbusServerLogFile,"inNewModbusServer::initializeModbusContext() Failed to allocate the mapping: " + std::string(modbus_strerror(errno)));
         std::cerr << "Failed to allocate the mapping: " << modbus_strerror(errno) << std::endl;
-        modbus_free(ctx); // Free the context before exiting
         exit(EXIT_FAILURE);
     }
 
@@ -114,60 +156,195 @@ void NewModbusServer::initializeModbusContext() {
         appendCommentWithTimestamp(fileNamesContainer.newModbusServerLogFile,"inNewModbusServer::initializeModbusContext() Failed to allocate tab_input_registers.");
         std::cerr << "Failed to allocate tab_input_registers." << std::endl;
         modbus_mapping_free(mb_mapping); // Free the mapping before exiting
-        modbus_free(ctx); // Free the context before exiting
         exit(EXIT_FAILURE);
     }
+
+    // First frame: every input register at 0, like the mapping
+    m_inputRegistersDraft.assign(static_cast<size_t>(mb_mapping->nb_input_registers), 0);
+    std::shared_ptr<InputRegistersFrame> firstFrame = std::make_shared<InputRegistersFrame>();
+    firstFrame->registers = m_inputRegistersDraft;
+    firstFrame->encodedRegisters.assign(2 * m_inputRegistersDraft.size(), 0);
+    std::atomic_store(&m_inputRegistersFrame, std::shared_ptr<const InputRegistersFrame>(firstFrame));
 }
 
-void NewModbusServer::setupServerSocket() {
-    // Create a TCP socket and listen for incoming connections
-    server_socket = modbus_tcp_listen(ctx, NB_CONNECTION);
+void NewModbusServer::publishInputRegistersFrame() {
+    // Caller holds m_inputRegistersWriterMutex
+    std::shared_ptr<InputRegistersFrame> frame;
+    if (m_spareInputRegistersFrame && m_spareInputRegistersFrame.use_count() == 1) {
+        // Nobody serves the previous frame anymore, its buffer is reused: no allocation
+        frame = std::move(m_spareInputRegistersFrame);
+    } else {
+        frame = std::make_shared<InputRegistersFrame>();
+    }
+    std::shared_ptr<const InputRegistersFrame> current = std::atomic_load(&m_inputRegistersFrame);
+    frame->version   = current->version + 1;
+    frame->registers = m_inputRegistersDraft;
+    // Encoded once here for every read of the frame, the capacity of a recycled frame is kept
+    frame->encodedRegisters.resize(2 * m_inputRegistersDraft.size());
+    for (size_t i = 0; i < m_inputRegistersDraft.size(); ++i) {
+        frame->encodedRegisters[2 * i]     = static_cast<uint8_t>(m_inputRegistersDraft[i] >> 8);
+        frame->encodedRegisters[2 * i + 1] = static_cast<uint8_t>(m_inputRegistersDraft[i] & 0xFF);
+    }
+    // The swap is the only point the readers see, they get either the whole previous frame or the whole new one
+    std::shared_ptr<const InputRegistersFrame> previous = std::atomic_exchange(&m_inputRegistersFrame, std::shared_ptr<const InputRegistersFrame>(frame));
+    m_spareInputRegistersFrame = std::const_pointer_cast<InputRegistersFrame>(previous);
+    m_inputRegistersVersion.store(frame->version, std::memory_order_release);
+}
 
-    // Check for socket setup errors
-    if (server_socket == -1) 
-    {
- 
-        appendCommentWithTimestamp(fileNamesContainer.newModbusServerLogFile,"in NewModbusServer::setupServerSocket() Failed to listen TCP connection: " + std::string(modbus_strerror(errno)));
-        std::cerr << "Unable to listen TCP connection: " << modbus_strerror(errno) << std::endl;
-        // Free the modbus context before exiting
-        modbus_free(ctx);
-        exit(EXIT_FAILURE);
+void NewModbusServer::refreshServedInputRegisters(ModbusWorker &worker) {
+    // Worker thread only: the mapping input registers are its private copy of the latest frame
+    std::shared_ptr<const InputRegistersFrame> frame = std::atomic_load(&m_inputRegistersFrame);
+    if (!frame || frame->version == worker.servedVersion) {
+        return;
+    }
+    const size_t count = std::min(frame->registers.size(), worker.inputRegisters.size());
+    std::copy(frame->registers.begin(), frame->registers.begin() + count, worker.inputRegisters.begin());
+    worker.servedVersion = frame->version;
+}
+
+int NewModbusServer::createListeningSocket() {
+    // Every worker binds the same port, SO_REUSEPORT lets the kernel balance the new connections between them
+    const int listeningSocket = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listeningSocket == -1) {
+        return -1;
+    }
+    const int enable = 1;
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family      = AF_INET;
+    address.sin_port        = htons(MODBUS_TCP_PORT);
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (setsockopt(listeningSocket, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable)) == -1 ||
+        setsockopt(listeningSocket, SOL_SOCKET, SO_REUSEPORT, &enable, sizeof(enable)) == -1 ||
+        bind(listeningSocket, (struct sockaddr *) &address, sizeof(address)) == -1 ||
+        listen(listeningSocket, m_maxConnections) == -1) {
+        close(listeningSocket);
+        return -1;
+    }
+    return listeningSocket;
+}
+
+void NewModbusServer::setupWorkers() {
+    for (int i = 0; i < m_nbWorkers; ++i) {
+        std::unique_ptr<ModbusWorker> worker(new ModbusWorker());
+        worker->index = static_cast<unsigned int>(i);
+
+        // Each worker replies with its own context, modbus_reply keeps per context state
+        worker->ctx = modbus_new_tcp("0.0.0.0", MODBUS_TCP_PORT);
+        if (worker->ctx == nullptr) 
+        {
+            appendCommentWithTimestamp(fileNamesContainer.newModbusServerLogFile,"in NewModbusServer::setupWorkers() Failed to initialize modbus context: " + std::string(modbus_strerror(errno)));
+            std::cerr << "Failed to initialize modbus context: " << modbus_strerror(errno) << std::endl;
+            exit(EXIT_FAILURE);
+        }
+
+        // Shared coils and holding registers, private input registers
+        worker->mapping = *mb_mapping;
+        worker->inputRegisters.assign(static_cast<size_t>(mb_mapping->nb_input_registers), 0);
+        worker->mapping.tab_input_registers = worker->inputRegisters.data();
+
+        // Create a TCP socket and listen for incoming connections
+        worker->serverSocket = createListeningSocket();
+        if (worker->serverSocket == -1) 
+        {
+            appendCommentWithTimestamp(fileNamesContainer.newModbusServerLogFile,"in NewModbusServer::setupWorkers() Failed to listen TCP connection: " + std::string(strerror(errno)));
+            std::cerr << "Unable to listen TCP connection: " << strerror(errno) << std::endl;
+            exit(EXIT_FAILURE);
+        }
+
+        // One epoll instance for the server socket and every client of the worker, each wakeup only returns the ready ones
+        worker->epollFd = epoll_create1(EPOLL_CLOEXEC);
+        epoll_event event;
+        memset(&event, 0, sizeof(event));
+        event.events  = EPOLLIN;
+        event.data.fd = worker->serverSocket;
+        worker->stopEventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        epoll_event stopEvent;
+        memset(&stopEvent, 0, sizeof(stopEvent));
+        stopEvent.events  = EPOLLIN;
+        stopEvent.data.fd = worker->stopEventFd;
+        if (worker->epollFd == -1 || epoll_ctl(worker->epollFd, EPOLL_CTL_ADD, worker->serverSocket, &event) == -1 ||
+            worker->stopEventFd == -1 || epoll_ctl(worker->epollFd, EPOLL_CTL_ADD, worker->stopEventFd, &stopEvent) == -1)
+        {
+            appendCommentWithTimestamp(fileNamesContainer.newModbusServerLogFile,"in NewModbusServer::setupWorkers() Failed to set up epoll: " + std::string(strerror(errno)));
+            std::cerr << "Unable to set up epoll: " << strerror(errno) << std::endl;
+            exit(EXIT_FAILURE);
+        }
+        m_workers.push_back(std::move(worker));
     }
 
     // Register a signal handler for SIGINT (Ctrl+C) to gracefully exit the server
     signal(SIGINT, NewModbusServer::closeServer);
+}
 
-    // Add the server socket to the reference set for select()
-    FD_SET(server_socket, &refset);
+void NewModbusServer::runServer() {
+    // The first worker serves in the calling thread, like the single threaded server did
+    for (size_t i = 1; i < m_workers.size(); ++i) {
+        m_workerThreads.emplace_back(&NewModbusServer::runWorker, this, std::ref(*m_workers[i]));
+    }
+    runWorker(*m_workers[0]);
+    for (std::thread &workerThread : m_workerThreads) {
+        if (workerThread.joinable()) {
+            workerThread.join();
+        }
+    }
+}
 
-    // Update fdmax with the server socket descriptor
-    fdmax = server_socket;
+void NewModbusServer::stopServer() {
+    m_serverRunning.store(false);
+    for (std::unique_ptr<ModbusWorker> &worker : m_workers) {
+        if (worker->stopEventFd != -1) {
+            const uint64_t one = 1;
+            if (write(worker->stopEventFd, &one, sizeof(one)) == -1 && errno != EAGAIN) {
+                appendCommentWithTimestamp(fileNamesContainer.newModbusServerLogFile,
+                                           "in\n"
+                                           "void NewModbusServer::stopServer()\n"
+                                           "Error: worker "+std::to_string(worker->index)+" not woken up: "+std::string(strerror(errno)));
+            }
+        }
+    }
 }
 
-void NewModbusServer::runServer() {
-    while (true) {
-        // Create a copy of the reference set for select()
-        fd_set rdset = refset;
-
-        // Use select() to wait for activity on sockets
-        if (select(fdmax + 1, &rdset, NULL, NULL, NULL) == -1) {
-            perror("Server select() failure.");
-            closeServer(EXIT_FAILURE); // Handle select() failure and exit
-        }
-         // Iterate through all possible sockets
-        for (int master_socket = 0; master_socket <= fdmax; master_socket++) {
-            if (!FD_ISSET(master_socket, &rdset)) {
-                continue; // Skip sockets with no activity
+void NewModbusServer::runWorker(ModbusWorker &worker) {
+    epoll_event events[MAX_EPOLL_EVENTS];
+    std::chrono::steady_clock::time_point lastIdleCheck = std::chrono::steady_clock::now();
+    while (m_serverRunning.load()) {
+        // Wake up at least every second to close the idle clients
+        const int nbEvents = epoll_wait(worker.epollFd, events, MAX_EPOLL_EVENTS, m_idleTimeoutMs > 0 ? 1000 : -1);
+        if (nbEvents == -1) {
+            if (errno == EINTR) {
+                continue;
             }
+            perror("Server epoll_wait() failure.");
+            closeServer(EXIT_FAILURE); // Handle epoll_wait() failure and exit
+        }
 
-            if (master_socket == server_socket) {
-                // Handle a new connection
-                handleNewConnection(); 
+        // Only the sockets with activity, whatever the number of clients
+        for (int i = 0; i < nbEvents; ++i) {
+            const int socket = events[i].data.fd;
+            if (socket == worker.stopEventFd) {
+                // stopServer(): the loop ends after this wakeup
+                continue;
+            }
+            if (socket == worker.serverSocket) {
+                // Handle new connections
+                handleNewConnection(worker);
+            } else if (events[i].events & (EPOLLHUP | EPOLLERR)) {
+                closeConnection(worker, socket);
+            } else if (events[i].events & EPOLLOUT) {
+                // The rest of a response the socket did not take
+                handleClientWritable(worker, socket);
             } else {
                 // Handle client requests
-                handleClientRequest(master_socket);
+                handleClientRequest(worker, socket);
             }
         }
+
+        const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        if (m_idleTimeoutMs > 0 && now - lastIdleCheck >= std::chrono::seconds(1)) {
+            closeIdleConnections(worker, now);
+            lastIdleCheck = now;
+        }
     }
 }
 
@@ -181,32 +358,46 @@ void NewModbusServer::handleWriteSingleCoilRequest(uint16_t coilAddr, bool state
                                   "Error: m_modbusBridge is nullptr");
  
     }
-    // TODO
-    m_modbusBridge->setRelays(coilAddr,state);
-    // modbus_reply(ctx, query, rc, mb_mapping); // This is a generic placeholder. You'll need to adapt it.
+    // Queued for the actuator thread, the worker goes back to serving without waiting for DAQmx
+    if (!m_coilCommands->push(coilAddr, state))
+    {
+       appendCommentWithTimestamp(fileNamesContainer.newModbusServerLogFile,
+                                  "in\n"
+                                  "void NewModbusServer::handleWriteSingleCoilRequest(uint16_t coilAddr, bool state)\n"
+                                  "Error: coil "+std::to_string(coilAddr)+" is beyond the "+std::to_string(m_coilCommands->nbCoils())+" coils of the mapping");
+    }
 }
 
-void NewModbusServer::acknowledgeSingleCoilWriting(const uint8_t *query, int query_length)
+bool NewModbusServer::acknowledgeSingleCoilWriting(ModbusWorker &worker, const uint8_t *query, int query_length, uint16_t coilAddr, bool state)
 {
-    if (!ctx) 
+    if (!worker.ctx) 
     {          
         appendCommentWithTimestamp(fileNamesContainer.newModbusServerLogFile,
                                   "in\n"
-                                  "void NewModbusServer::acknowledgeSingleCoilWriting(const uint8_t *query, int query_length)\n"
+                                  "bool NewModbusServer::acknowledgeSingleCoilWriting(ModbusWorker &worker, const uint8_t *query, int query_length, uint16_t coilAddr, bool state)\n"
                                   "Error: Modbus context is not initialized.");
         std::cerr << "Modbus context is not initialized." << std::endl;
-        return;
+        return false;
     }
     
-    int rc = modbus_reply(ctx, query, query_length, mb_mapping);
+    // The reply writes the requested state in the shared mapping, the command is queued in the same critical section:
+    // restoreAppliedCoils() takes mb_mapping_mutex too, so a failed write is always restored after this acknowledgement
+    int rc = 0;
+    {
+        std::lock_guard<std::mutex> lock(mb_mapping_mutex);
+        rc = modbus_reply(worker.ctx, query, query_length, &worker.mapping);
+        handleWriteSingleCoilRequest(coilAddr, state);
+    }
     if (rc == -1) 
     {
        appendCommentWithTimestamp(fileNamesContainer.newModbusServerLogFile,
                                   "in\n"
-                                  "void NewModbusServer::acknowledgeSingleCoilWriting(const uint8_t *query, int query_length)\n"
+                                  "bool NewModbusServer::acknowledgeSingleCoilWriting(ModbusWorker &worker, const uint8_t *query, int query_length, uint16_t coilAddr, bool state)\n"
                                   "Error: Failed to send acknowledgment for Write Single Coil request\n"+
                                   std::string(modbus_strerror(errno))); 
+       return false;
     }
+    return true;
 }
 
 void NewModbusServer::handleWriteMultipleCoilRequest(std::vector<uint16_t> coilsAddr, std::vector<bool> states)
@@ -215,49 +406,209 @@ void NewModbusServer::handleWriteMultipleCoilRequest(std::vector<uint16_t> coils
         // Log error: The sizes of coil addresses and states vectors do not match
         return;
     }
-
-    for (size_t i = 0; i < coilsAddr.size(); ++i) {
-        handleWriteSingleCoilRequest(coilsAddr[i], states[i]);
+    if (!m_modbusBridge)
+    {
+       appendCommentWithTimestamp(fileNamesContainer.newModbusServerLogFile,
+                                  "in\n"
+                                  "void NewModbusServer::handleWriteMultipleCoilRequest(std::vector<uint16_t> coilsAddr, std::vector<bool> states)\n"
+                                  "Error: m_modbusBridge is nullptr");
+       return;
+    }
+    // Queued for the actuator thread, which writes everything pending in one batch, one DAQmx call per output port
+    for (size_t i = 0; i < coilsAddr.size(); ++i)
+    {
+        if (!m_coilCommands->push(coilsAddr[i], states[i]))
+        {
+           appendCommentWithTimestamp(fileNamesContainer.newModbusServerLogFile,
+                                      "in\n"
+                                      "void NewModbusServer::handleWriteMultipleCoilRequest(std::vector<uint16_t> coilsAddr, std::vector<bool> states)\n"
+                                      "Error: coil "+std::to_string(coilsAddr[i])+" is beyond the "+std::to_string(m_coilCommands->nbCoils())+" coils of the mapping");
+        }
     }
 }
 
-void NewModbusServer::handleNewConnection() {
-    // Declare variables for socket address and new file descriptor
-    socklen_t addrlen;
-    struct sockaddr_in clientaddr;
-    int newfd;
-
-    // Set the size of the client address
-    addrlen = sizeof(clientaddr);
+void NewModbusServer::runActuator()
+{
+    std::vector<CoilCommandQueue::Command> commands;
+    std::vector<uint16_t>                  coilsAddr;
+    std::vector<bool>                      states;
+    std::vector<uint16_t>                  failedCoils;
+    while (m_actuatorRunning.load())
+    {
+        // Wakes up at least every 100 ms to see the server stopping
+        commands.clear();
+        if (m_coilCommands->popAll(commands, 100) == 0)
+        {
+            continue;
+        }
+        std::shared_ptr<NItoModbusBridge> bridge = std::atomic_load(&m_modbusBridge);
+        if (!bridge)
+        {
+           appendCommentWithTimestamp(fileNamesContainer.newModbusServerLogFile,
+                                      "in\n"
+                                      "void NewModbusServer::runActuator()\n"
+                                      "Error: m_modbusBridge is nullptr, "+std::to_string(commands.size())+" coil commands dropped");
+           coilsAddr.clear();
+           for (const CoilCommandQueue::Command &command : commands)
+           {
+               coilsAddr.push_back(command.coilAddr);
+           }
+           restoreAppliedCoils(commands, coilsAddr);
+           continue;
+        }
 
-    // Initialize the client address structure to zero
-    memset(&clientaddr, 0, sizeof(clientaddr));
+        // Everything pending in one batched write
+        coilsAddr.clear();
+        states.clear();
+        for (const CoilCommandQueue::Command &command : commands)
+        {
+            coilsAddr.push_back(command.coilAddr);
+            states.push_back(command.state);
+        }
+        failedCoils.clear();
+        try
+        {
+            if (!bridge->setRelays(coilsAddr, states, &failedCoils))
+            {
+               appendCommentWithTimestamp(fileNamesContainer.newModbusServerLogFile,
+                                          "in\n"
+                                          "void NewModbusServer::runActuator()\n"
+                                          "Error: "+std::to_string(failedCoils.size())+" coil commands not applied to the relays");
+            }
+        }
+        catch (const std::exception &e)
+        {
+           appendCommentWithTimestamp(fileNamesContainer.newModbusServerLogFile,
+                                      "in\n"
+                                      "void NewModbusServer::runActuator()\n"
+                                      "Exception:\n"+std::string(e.what()));
+           failedCoils = coilsAddr;
+        }
+        // The mapping coils follow what the relays really are: a failed command goes back to the applied state
+        restoreAppliedCoils(commands, failedCoils);
 
-    // Accept a new connection on the server socket
-    newfd = accept(server_socket, (struct sockaddr *) &clientaddr, &addrlen);
+        // Completion latency of each command, from its oldest coalesced write to the end of the relay write
+        const int64_t doneNs = CoilCommandQueue::monotonicNs();
+        uint64_t      maxNs  = m_coilLatencyMaxNs.load(std::memory_order_relaxed);
+        for (const CoilCommandQueue::Command &command : commands)
+        {
+            const uint64_t latencyNs = static_cast<uint64_t>(std::max<int64_t>(0, doneNs - command.queuedNs));
+            m_coilLatencyTotalNs.fetch_add(latencyNs, std::memory_order_relaxed);
+            maxNs = std::max(maxNs, latencyNs);
+        }
+        // Only this thread raises it, logActuatorLoad() only resets it
+        uint64_t expected = m_coilLatencyMaxNs.load(std::memory_order_relaxed);
+        while (maxNs > expected && !m_coilLatencyMaxNs.compare_exchange_weak(expected, maxNs, std::memory_order_relaxed))
+        {
+        }
+        m_appliedCoilCommands.fetch_add(commands.size(), std::memory_order_relaxed);
+    }
+}
 
-    // Check if the new connection is successfully accepted
-    if (newfd == -1) {
-        // Handle accept() error by printing an error message
-        perror("Server accept() error");
-    } else {
-        // Add the new socket to the reference set for select()
-        FD_SET(newfd, &refset);
+void NewModbusServer::restoreAppliedCoils(const std::vector<CoilCommandQueue::Command> &commands, const std::vector<uint16_t> &failedCoils)
+{
+    // Actuator thread only. The FC05 acknowledgement wrote the requested state before the relay was written,
+    // FC01 must never report a state that was not applied
+    uint64_t failedCommands = 0;
+    std::lock_guard<std::mutex> lock(mb_mapping_mutex);
+    for (const CoilCommandQueue::Command &command : commands)
+    {
+        if (std::find(failedCoils.begin(), failedCoils.end(), command.coilAddr) == failedCoils.end())
+        {
+            m_appliedCoilStates[command.coilAddr] = command.state ? 1 : 0;
+        }
+        else
+        {
+            ++failedCommands;
+        }
+        mb_mapping->tab_bits[command.coilAddr] = m_appliedCoilStates[command.coilAddr];
+    }
+    m_failedCoilCommands.fetch_add(failedCommands, std::memory_order_relaxed);
+}
 
-        // Update the maximum file descriptor number if the new socket is greater
-        if (newfd > fdmax) {
-            fdmax = newfd;
+void NewModbusServer::handleNewConnection(ModbusWorker &worker) {
+    // The server socket is non blocking: accept every pending connection of this wakeup
+    while (true) {
+        struct sockaddr_in clientaddr;
+        socklen_t addrlen = sizeof(clientaddr);
+        memset(&clientaddr, 0, sizeof(clientaddr));
+
+        const int newfd = accept4(worker.serverSocket, (struct sockaddr *) &clientaddr, &addrlen, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (newfd == -1) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                // Handle accept() error by printing an error message
+                perror("Server accept() error");
+            }
+            return;
         }
 
         // Convert the client's IP address to a string
         std::string ipAddress = inet_ntoa(clientaddr.sin_addr);
 
+        // The limit is for the whole server, whatever the worker the kernel chose
+        if (m_nbConnections.fetch_add(1) >= m_maxConnections) {
+            m_nbConnections.fetch_sub(1);
+            appendCommentWithTimestamp(fileNamesContainer.newModbusServerLogFile,
+                                       "in\n"
+                                       "void NewModbusServer::handleNewConnection(ModbusWorker &worker)\n"
+                                       "Warning: connection of "+ipAddress+" refused, "+std::to_string(m_maxConnections)+" clients already connected");
+            close(newfd);
+            continue;
+        }
+
+        epoll_event event;
+        memset(&event, 0, sizeof(event));
+        event.events  = EPOLLIN | EPOLLRDHUP;
+        event.data.fd = newfd;
+        if (epoll_ctl(worker.epollFd, EPOLL_CTL_ADD, newfd, &event) == -1) {
+            perror("Server epoll_ctl() error");
+            m_nbConnections.fetch_sub(1);
+            close(newfd);
+            continue;
+        }
+
+        ModbusConnection &connection = worker.connections[newfd];
+        connection.ipAddress    = ipAddress;
+        connection.received     = 0;
+        connection.lastActivity = std::chrono::steady_clock::now();
+
         // Add the new client to the client list and broadcast the update
         updateClientList(newfd, ipAddress, false);
         broadcastClientList();
     }
 }
 
+void NewModbusServer::closeConnection(ModbusWorker &worker, int socket) {
+    // Connection closed by the client, broken or idle
+    std::cout << "Connection closed on socket " << socket << std::endl;
+
+    // Update the client list to reflect the disconnection
+    updateClientList(socket, "", true);  // 'true' indicates removal
+    broadcastClientList();
+
+    epoll_ctl(worker.epollFd, EPOLL_CTL_DEL, socket, nullptr);
+    close(socket);
+    if (worker.connections.erase(socket)) {
+        m_nbConnections.fetch_sub(1);
+    }
+}
+
+void NewModbusServer::closeIdleConnections(ModbusWorker &worker, std::chrono::steady_clock::time_point now) {
+    std::vector<int> idleSockets;
+    for (const auto &connection : worker.connections) {
+        if (now - connection.second.lastActivity > std::chrono::milliseconds(m_idleTimeoutMs)) {
+            idleSockets.push_back(connection.first);
+        }
+    }
+    for (int socket : idleSockets) {
+        appendCommentWithTimestamp(fileNamesContainer.newModbusServerLogFile,
+                                   "in\n"
+                                   "void NewModbusServer::closeIdleConnections(ModbusWorker &worker, std::chrono::steady_clock::time_point now)\n"
+                                   "Warning: client "+worker.connections[socket].ipAddress+" idle for more than "+std::to_string(m_idleTimeoutMs)+" ms, disconnected");
+        closeConnection(worker, socket);
+    }
+}
+
 void NewModbusServer::updateClientList(int socket, const std::string& ipAddress, bool remove) {
     // Lock the client list mutex to ensure thread safety
     std::lock_guard<std::mutex> lock(clientListMutex);
@@ -274,6 +625,9 @@ void NewModbusServer::updateClientList(int socket, const std::string& ipAddress,
 
 void NewModbusServer::broadcastClientList() 
 {
+    // The workers connect and disconnect clients concurrently
+    std::lock_guard<std::mutex> lock(clientListMutex);
+
     // Create a message to display the connected clients
     std::string message = "cli:Connected Clients: " + std::to_string(clientList.size());
 
@@ -291,181 +645,280 @@ void NewModbusServer::broadcastClientList()
 }
 
 
-void NewModbusServer::handleClientRequest(int master_socket) {
-    uint8_t query[MODBUS_TCP_MAX_ADU_LENGTH];
-
-    // Initially, we do not know if we will receive function code 0x05.
-    bool receivedFunctionCode05 = false;
-
-    do {
-        // Reset the flag for each iteration of the loop.
-        receivedFunctionCode05 = false;
-
-        // Set the socket for the modbus context to ensure replies go to the correct client.
-        modbus_set_socket(ctx, master_socket);
-
-        // Attempt to receive a Modbus request from the client.
-        int rc = modbus_receive(ctx, query);
+void NewModbusServer::handleClientRequest(ModbusWorker &worker, int master_socket) {
+    auto found = worker.connections.find(master_socket);
+    if (found == worker.connections.end()) {
+        return;
+    }
+    ModbusConnection &connection = found->second;
 
-        if (rc > 0) 
-        {
-            // Successfully received a request, now determine the function code.
-            uint8_t function_code = query[7]; // Function code is at position 7 in the query array.
-
-            if (function_code == 0x05) {
-                // Handle Write Single Coil request.
-                receivedFunctionCode05 = true; // Mark that we've received a 0x05 request.
-
-                // Extract the coil address and the desired state from the request.
-                uint16_t coilAddr = (query[8] << 8) + query[9]; // Combine bytes 8 and 9 for the coil address.
-                bool state = query[10] == 0xFF; // State is determined by byte 10; 0xFF00 means ON, 0x0000 means OFF.
-
-                // Process the Write Single Coil request.
-                handleWriteSingleCoilRequest(coilAddr, state);
-                if (!SRUMapping.m_modeSRU)
-                {
-                    // Send an acknowledgment back to the client.
-                    acknowledgeSingleCoilWriting(query, rc);
-                }
-            } 
-            else if (function_code == 0x0F) 
-            {
-                // Handle Write Multiple Coils request.
-                // Write Multiple Coils
-                uint16_t startingAddr = (query[8] << 8) + query[9];
-                uint16_t quantityOfOutputs = (query[10] << 8) + query[11];
-                // Extract coil states from the request
-                std::vector<uint16_t> coilsAddr;
-                std::vector<bool> states;
-                for (uint16_t i = 0; i < quantityOfOutputs; i++) 
-                {
-                    coilsAddr.push_back(startingAddr + i);
-                    // Determine the bit position in the request byte array
-                    uint8_t byteIndex = 13 + (i / 8); // Starting byte index for coil values is 13
-                    uint8_t bitPosition = i % 8;
-                    bool state = query[byteIndex] & (1 << bitPosition);
-                    states.push_back(state);
-                }
-                handleWriteMultipleCoilRequest(coilsAddr, states);
-            } 
-            else 
-            {
-                // For all other function codes, process the request normally and send a standard Modbus response.
-                modbus_reply(ctx, query, rc, mb_mapping);
-            }
-        } 
-        else if (rc == -1) 
-        {
-            // Connection closed by the client
-            std::cout << "Connection closed on socket " << master_socket << std::endl;
+    // Non blocking read of what is available, a half sent request just waits in the connection buffer
+    const ssize_t nbBytes = recv(master_socket, connection.buffer + connection.received, sizeof(connection.buffer) - connection.received, 0);
+    if (nbBytes == 0 || (nbBytes == -1 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+        closeConnection(worker, master_socket);
+        return;
+    }
+    if (nbBytes == -1) {
+        return;
+    }
+    connection.received    += static_cast<size_t>(nbBytes);
+    connection.lastActivity = std::chrono::steady_clock::now();
 
-            // Update the client list to reflect the disconnection
-            updateClientList(master_socket, "", true);  // 'true' indicates removal
-            broadcastClientList();
+    if (!processBufferedRequests(worker, master_socket, connection)) {
+        closeConnection(worker, master_socket);
+    }
+}
 
-            // Close the socket and remove it from the set
-            close(master_socket);
-            FD_CLR(master_socket, &refset);
+void NewModbusServer::handleClientWritable(ModbusWorker &worker, int master_socket) {
+    auto found = worker.connections.find(master_socket);
+    if (found == worker.connections.end()) {
+        return;
+    }
+    ModbusConnection &connection = found->second;
+    // Once the pending response is gone, the requests received meanwhile are answered
+    if (!flushOutput(worker, master_socket, connection) ||
+        (connection.output.empty() && !processBufferedRequests(worker, master_socket, connection))) {
+        closeConnection(worker, master_socket);
+    }
+}
 
-            // Update fdmax if necessary
-            if (master_socket == fdmax) 
-            {
-                // Decrease fdmax to the highest active socket
-                fdmax = findMaxSocket();
-            }
-            break; // Exit the loop on error or closed connection.
+bool NewModbusServer::processBufferedRequests(ModbusWorker &worker, int master_socket, ModbusConnection &connection) {
+    // Every complete request of the buffer, bursts of 0x05 included, as long as the responses are sent in full:
+    // a pending response keeps the next requests in the buffer, the responses never interleave
+    size_t consumed = 0;
+    while (connection.output.empty() && connection.received - consumed >= MBAP_HEADER_LENGTH) {
+        const uint8_t *adu = connection.buffer + consumed;
+        // MBAP header: transaction id, protocol id (0), length of the unit id and the PDU
+        const uint16_t protocolId = static_cast<uint16_t>((adu[2] << 8) | adu[3]);
+        const uint16_t length     = static_cast<uint16_t>((adu[4] << 8) | adu[5]);
+        const size_t   aduLength  = 6 + static_cast<size_t>(length);
+        if (protocolId != 0 || length < 2 || aduLength > MODBUS_TCP_MAX_ADU_LENGTH) {
+            appendCommentWithTimestamp(fileNamesContainer.newModbusServerLogFile,
+                                       "in\n"
+                                       "bool NewModbusServer::processBufferedRequests(ModbusWorker &worker, int master_socket, ModbusConnection &connection)\n"
+                                       "Error: malformed request from "+connection.ipAddress+", connection closed");
+            return false;
         }
+        if (connection.received - consumed < aduLength) {
+            break; // the end of the request is not there yet
+        }
+        if (!processRequest(worker, master_socket, adu, static_cast<int>(aduLength))) {
+            return false;
+        }
+        consumed += aduLength;
+    }
 
-        // If we received a function code 0x05, immediately check for another request without exiting the loop.
-        // This allows handling bursts of 0x05 requests efficiently.
-    } while (receivedFunctionCode05);
-
-    // After processing any burst of 0x05 requests, normal operation resumes.
-    // Additional cleanup or processing logic can be placed here if needed.
+    // Keep the beginning of the next request
+    if (consumed) {
+        memmove(connection.buffer, connection.buffer + consumed, connection.received - consumed);
+        connection.received -= consumed;
+    }
+    return true;
 }
 
+bool NewModbusServer::sendResponse(ModbusWorker &worker, int master_socket, const uint8_t *response, size_t length) {
+    ssize_t sent = send(master_socket, response, length, MSG_NOSIGNAL);
+    if (sent == -1) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+            return false;
+        }
+        sent = 0;
+    }
+    if (static_cast<size_t>(sent) == length) {
+        return true;
+    }
+    // Slow client: the rest goes out when the socket is writable again, reading waits until then
+    ModbusConnection &connection = worker.connections[master_socket];
+    connection.output.assign(response + sent, response + length);
+    epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events  = EPOLLOUT;
+    event.data.fd = master_socket;
+    return epoll_ctl(worker.epollFd, EPOLL_CTL_MOD, master_socket, &event) != -1;
+}
 
+bool NewModbusServer::flushOutput(ModbusWorker &worker, int master_socket, ModbusConnection &connection) {
+    const ssize_t sent = send(master_socket, connection.output.data(), connection.output.size(), MSG_NOSIGNAL);
+    if (sent == -1) {
+        return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+    }
+    connection.output.erase(connection.output.begin(), connection.output.begin() + sent);
+    connection.lastActivity = std::chrono::steady_clock::now();
+    if (!connection.output.empty()) {
+        return true;
+    }
+    // Drained: back to reading the requests
+    epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events  = EPOLLIN | EPOLLRDHUP;
+    event.data.fd = master_socket;
+    return epoll_ctl(worker.epollFd, EPOLL_CTL_MOD, master_socket, &event) != -1;
+}
 
-/*void NewModbusServer::handleClientRequest(int master_socket) 
-{
-    uint8_t query[MODBUS_TCP_MAX_ADU_LENGTH];
+bool NewModbusServer::processRequest(ModbusWorker &worker, int master_socket, const uint8_t *query, int rc) {
+    // Set the socket for the modbus context of the worker to ensure replies go to the correct client.
+    modbus_set_socket(worker.ctx, master_socket);
 
-    // Set the socket for modbus context
-    modbus_set_socket(ctx, master_socket);
+    // Function code is at position 7 in the query array.
+    uint8_t function_code = query[7];
+    int     replied       = 0;
 
-    // Receive a Modbus request
-    int rc = modbus_receive(ctx, query);
+    if (rc < minimumRequestLength(query, rc)) {
+        // Truncated PDU: none of its fields is read, the client gets an exception
+        replied = modbus_reply_exception(worker.ctx, query, MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE);
+    }
+    else if (function_code == 0x05) {
+        // Handle Write Single Coil request.
+        // Extract the coil address and the desired state from the request.
+        uint16_t coilAddr = (query[8] << 8) + query[9]; // Combine bytes 8 and 9 for the coil address.
+        bool state = query[10] == 0xFF; // State is determined by byte 10; 0xFF00 means ON, 0x0000 means OFF.
 
-    if (rc > 0) 
-    {
-        
-        uint8_t function_code = query[7]; // Function code position in the query array
-        if (function_code == 0x05) 
+        if (!SRUMapping.m_modeSRU)
         {
-            // Extract coil address and state from the query
-            uint16_t coilAddr = (query[8] << 8) + query[9]; // Coil address
-            bool state = query[10] == 0xFF; // State (0xFF00 for ON, 0x0000 for OFF)
-            handleWriteSingleCoilRequest(coilAddr,state);
-            acknowledgeSingleCoilWriting(query);
-        }
-        else if (function_code == 0x0F) 
-        {   // Write Multiple Coils
-            uint16_t startingAddr = (query[8] << 8) + query[9];
-            uint16_t quantityOfOutputs = (query[10] << 8) + query[11];
-            // Extract coil states from the request
-            std::vector<uint16_t> coilsAddr;
-            std::vector<bool> states;
-            for (uint16_t i = 0; i < quantityOfOutputs; i++) 
-            {
-                coilsAddr.push_back(startingAddr + i);
-                // Determine the bit position in the request byte array
-                uint8_t byteIndex = 13 + (i / 8); // Starting byte index for coil values is 13
-                uint8_t bitPosition = i % 8;
-                bool state = query[byteIndex] & (1 << bitPosition);
-                states.push_back(state);
-            }
-            handleWriteMultipleCoilRequest(coilsAddr, states);
+            // Send an acknowledgment back to the client, the request is queued once the mapping holds it.
+            return acknowledgeSingleCoilWriting(worker, query, rc, coilAddr, state);
         }
-        else
+        // Process the Write Single Coil request.
+        handleWriteSingleCoilRequest(coilAddr, state);
+    } 
+    else if (function_code == 0x0F) 
+    {
+        // Handle Write Multiple Coils request.
+        uint16_t startingAddr = (query[8] << 8) + query[9];
+        uint16_t quantityOfOutputs = (query[10] << 8) + query[11];
+        // Extract coil states from the request, never beyond the received bytes
+        std::vector<uint16_t> coilsAddr;
+        std::vector<bool> states;
+        for (uint16_t i = 0; i < quantityOfOutputs && 13 + (i / 8) < rc; i++) 
         {
-            // Process the valid Modbus request and send a response
-            modbus_reply(ctx, query, rc, mb_mapping);
+            coilsAddr.push_back(startingAddr + i);
+            // Determine the bit position in the request byte array
+            int byteIndex = 13 + (i / 8); // Starting byte index for coil values is 13
+            uint8_t bitPosition = i % 8;
+            bool state = query[byteIndex] & (1 << bitPosition);
+            states.push_back(state);
         }
+        handleWriteMultipleCoilRequest(coilsAddr, states);
     } 
-    else if (rc == -1) 
+    else if (function_code == 0x03 || function_code == 0x04)
     {
-        // Connection closed by the client
-        std::cout << "Connection closed on socket " << master_socket << std::endl;
-
-        // Update the client list to reflect the disconnection
-        updateClientList(master_socket, "", true);  // 'true' indicates removal
-        broadcastClientList();
-
-        // Close the socket and remove it from the set
-        close(master_socket);
-        FD_CLR(master_socket, &refset);
-
-        // Update fdmax if necessary
-        if (master_socket == fdmax) {
-            // Decrease fdmax to the highest active socket
-            fdmax = findMaxSocket();
+        // Answered from the encoded responses of the worker when the request is valid
+        const CachedReadResponse *cached = cachedReadResponse(worker, query, rc);
+        if (cached) {
+            return sendResponse(worker, master_socket, cached->adu, cached->length);
         }
+        // The input registers are the latest published frame, taken as a whole without waiting for the bridge,
+        // into the private copy of the worker: the readers never lock each other
+        refreshServedInputRegisters(worker);
+        std::unique_lock<std::mutex> lock(mb_mapping_mutex, std::defer_lock);
+        if (function_code == 0x03) {
+            lock.lock();
+        }
+        replied = modbus_reply(worker.ctx, query, rc, &worker.mapping);
     }
-}*/
+    else 
+    {
+        // For all other function codes, process the request normally and send a standard Modbus response.
+        // Coils and holding registers are shared by the workers
+        refreshServedInputRegisters(worker);
+        std::lock_guard<std::mutex> lock(mb_mapping_mutex);
+        replied = modbus_reply(worker.ctx, query, rc, &worker.mapping);
+        // Write single / multiple registers, mask write, read/write multiple: the cached FC03 responses are outdated
+        if (function_code == 0x06 || function_code == 0x10 || function_code == 0x16 || function_code == 0x17) {
+            m_holdingRegistersVersion.fetch_add(1, std::memory_order_release);
+        }
+    }
+    // libmodbus drops what a non blocking socket did not take: that client stream cannot be resynchronised
+    if (replied == -1) {
+        appendCommentWithTimestamp(fileNamesContainer.newModbusServerLogFile,
+                                   "in\n"
+                                   "bool NewModbusServer::processRequest(ModbusWorker &worker, int master_socket, const uint8_t *query, int rc)\n"
+                                   "Error: response not fully sent, connection closed: "+std::string(modbus_strerror(errno)));
+        return false;
+    }
+    return true;
+}
 
+int NewModbusServer::minimumRequestLength(const uint8_t *query, int rc) {
+    // Smallest ADU holding every field read for the function code of the query, the MBAP header and function code
+    // (rc >= MBAP_HEADER_LENGTH + 1) are checked by processBufferedRequests()
+    switch (query[MBAP_HEADER_LENGTH]) {
+        case 0x01: case 0x02: case 0x03: case 0x04: case 0x05: case 0x06:
+            // address, quantity or value
+            return MBAP_HEADER_LENGTH + 5;
+        case 0x0F: case 0x10:
+            // address, quantity, byte count, then the byte count values
+            return rc < MBAP_HEADER_LENGTH + 6 ? MBAP_HEADER_LENGTH + 6 : MBAP_HEADER_LENGTH + 6 + query[MBAP_HEADER_LENGTH + 5];
+        case 0x16:
+            // address, and mask, or mask
+            return MBAP_HEADER_LENGTH + 7;
+        case 0x17:
+            // read address and quantity, write address, quantity and byte count, then the values
+            return rc < MBAP_HEADER_LENGTH + 10 ? MBAP_HEADER_LENGTH + 10 : MBAP_HEADER_LENGTH + 10 + query[MBAP_HEADER_LENGTH + 9];
+        default:
+            // libmodbus reads the two bytes after the function code of any request before rejecting it
+            return MBAP_HEADER_LENGTH + 3;
+    }
+}
 
-int NewModbusServer::findMaxSocket() {
-    int maxSock = server_socket;
+const CachedReadResponse *NewModbusServer::cachedReadResponse(ModbusWorker &worker, const uint8_t *query, int rc) {
+    // Valid requests only, libmodbus keeps building the exception responses
+    if (rc != MBAP_HEADER_LENGTH + 5) {
+        return nullptr;
+    }
+    const uint8_t  unitId      = query[6];
+    const uint8_t  function    = query[7];
+    const uint16_t address     = static_cast<uint16_t>((query[8] << 8) | query[9]);
+    const uint16_t count       = static_cast<uint16_t>((query[10] << 8) | query[11]);
+    const int      nbRegisters = function == 0x04 ? mb_mapping->nb_input_registers : mb_mapping->nb_registers;
+    if (count < 1 || count > MODBUS_MAX_READ_REGISTERS || static_cast<int>(address) + count > nbRegisters) {
+        return nullptr;
+    }
 
-    // Iterate through the client list to find the maximum socket
-    for (const auto& client : clientList) {
-        if (client.first > maxSock) {
-            maxSock = client.first;
+    const uint64_t key = (static_cast<uint64_t>(unitId) << 40) | (static_cast<uint64_t>(function) << 32) |
+                         (static_cast<uint64_t>(address) << 16) | count;
+    auto found = worker.readResponses.find(key);
+    if (found == worker.readResponses.end()) {
+        // Bounded: clients polling ever changing ranges cannot grow it forever
+        if (worker.readResponses.size() >= MAX_CACHED_READ_RESPONSES) {
+            worker.readResponses.clear();
         }
+        found = worker.readResponses.emplace(key, CachedReadResponse()).first;
+    }
+    CachedReadResponse &cached = found->second;
+
+    const uint64_t version = function == 0x04 ? m_inputRegistersVersion.load(std::memory_order_acquire)
+                                              : m_holdingRegistersVersion.load(std::memory_order_acquire);
+    if (cached.length == 0 || cached.version != version) {
+        // Build once per version: MBAP header, function, byte count, big endian registers
+        const uint16_t mbapLength = static_cast<uint16_t>(3 + 2 * count); // unit id, function, byte count, registers
+        cached.adu[2] = 0;
+        cached.adu[3] = 0;
+        cached.adu[4] = static_cast<uint8_t>(mbapLength >> 8);
+        cached.adu[5] = static_cast<uint8_t>(mbapLength & 0xFF);
+        cached.adu[6] = unitId;
+        cached.adu[7] = function;
+        cached.adu[8] = static_cast<uint8_t>(2 * count);
+        if (function == 0x04) {
+            // Already encoded by the writer, the version is the one of the frame actually copied
+            std::shared_ptr<const InputRegistersFrame> frame = std::atomic_load(&m_inputRegistersFrame);
+            memcpy(cached.adu + 9, frame->encodedRegisters.data() + 2 * address, 2 * count);
+            cached.version = frame->version;
+        } else {
+            std::lock_guard<std::mutex> lock(mb_mapping_mutex);
+            for (uint16_t i = 0; i < count; ++i) {
+                cached.adu[9 + 2 * i]  = static_cast<uint8_t>(mb_mapping->tab_registers[address + i] >> 8);
+                cached.adu[10 + 2 * i] = static_cast<uint8_t>(mb_mapping->tab_registers[address + i] & 0xFF);
+            }
+            cached.version = m_holdingRegistersVersion.load(std::memory_order_relaxed);
+        }
+        cached.length = static_cast<uint16_t>(6 + mbapLength);
     }
 
-    // Return the maximum socket found
-    return maxSock;
+    // The transaction id of this request, the caller sends the whole response at once
+    cached.adu[0] = query[0];
+    cached.adu[1] = query[1];
+    return &cached;
 }
 
 void NewModbusServer::closeServer(int signal) {
@@ -477,28 +930,78 @@ void NewModbusServer::closeServer(int signal) {
 }
 
 void NewModbusServer::reMapInputRegisterValuesForAnalogics(const std::vector<uint16_t>& newValues) {
-    // Lock the mutex to ensure thread safety while accessing mb_mapping
-    std::lock_guard<std::mutex> lock(mb_mapping_mutex);
+    // Writers only: the server thread keeps serving the current frame meanwhile
+    std::lock_guard<std::mutex> lock(m_inputRegistersWriterMutex);
 
-    // Check if mb_mapping is valid
-    if (!mb_mapping) {
-        // If mb_mapping is not valid, return without making any changes
-        return;
+    // Determine the number of registers to write, ensuring not to exceed the allocated array size
+    size_t numRegistersToWrite = std::min(newValues.size(), std::min(m_inputRegistersDraft.size(), static_cast<size_t>(MODBUS_MAX_READ_REGISTERS)));
+
+    // Copy the changed values to the next frame
+    uint64_t changedRegisters = 0;
+    for (size_t i = 0; i < numRegistersToWrite; ++i) {
+        if (m_inputRegistersDraft[i] != newValues[i]) {
+            m_inputRegistersDraft[i] = newValues[i];
+            ++changedRegisters;
+        }
+    }
+    if (changedRegisters) {
+        publishInputRegistersFrame();
     }
+    m_inputRegistersPublications.fetch_add(1, std::memory_order_relaxed);
+    m_changedInputRegisters.fetch_add(changedRegisters, std::memory_order_relaxed);
+}
 
-    // Check if tab_input_registers is valid
-    if (!mb_mapping->tab_input_registers) {
-        // If tab_input_registers is not valid, return without making any changes
-        return;
+void NewModbusServer::reMapInputRegisters(const std::vector<uint16_t>& newValues, const std::vector<int>& addresses) {
+    std::lock_guard<std::mutex> lock(m_inputRegistersWriterMutex);
+    const size_t registersCount = std::min(newValues.size(), std::min(m_inputRegistersDraft.size(), static_cast<size_t>(MODBUS_MAX_READ_REGISTERS)));
+    uint64_t changedRegisters = 0;
+    for (int address : addresses) {
+        if (address >= 0 && static_cast<size_t>(address) < registersCount && m_inputRegistersDraft[address] != newValues[address]) {
+            m_inputRegistersDraft[address] = newValues[address];
+            ++changedRegisters;
+        }
+    }
+    // All the registers of the call go out in the same frame
+    if (changedRegisters) {
+        publishInputRegistersFrame();
     }
+    m_inputRegistersPublications.fetch_add(1, std::memory_order_relaxed);
+    m_changedInputRegisters.fetch_add(changedRegisters, std::memory_order_relaxed);
+}
 
-    // Determine the number of registers to write, ensuring not to exceed the allocated array size
-    size_t numRegistersToWrite = std::min(newValues.size(), static_cast<size_t>(MODBUS_MAX_READ_REGISTERS));
+void NewModbusServer::getInputRegistersPublicationCounts(uint64_t &publications, uint64_t &changedRegisters) const {
+    publications     = m_inputRegistersPublications.load(std::memory_order_relaxed);
+    changedRegisters = m_changedInputRegisters.load(std::memory_order_relaxed);
+}
 
-    // Copy new values to the input registers
-    for (size_t i = 0; i < numRegistersToWrite; ++i) {
-        mb_mapping->tab_input_registers[i] = newValues[i];
-    }
+void NewModbusServer::logPublicationLoad() {
+    uint64_t publications     = 0;
+    uint64_t changedRegisters = 0;
+    getInputRegistersPublicationCounts(publications, changedRegisters);
+    appendCommentWithTimestamp(fileNamesContainer.newModbusServerLogFile,
+                               "input registers publication: "+std::to_string(publications - m_loggedPublications)+" remaps, "
+                               +std::to_string(changedRegisters - m_loggedChangedRegisters)+" changed registers since the previous report");
+    m_loggedPublications     = publications;
+    m_loggedChangedRegisters = changedRegisters;
+}
+
+void NewModbusServer::logActuatorLoad() {
+    const uint64_t appliedCommands = m_appliedCoilCommands.load(std::memory_order_relaxed);
+    const uint64_t coalescedWrites = m_coilCommands->coalescedWrites();
+    const uint64_t failedCommands  = m_failedCoilCommands.load(std::memory_order_relaxed);
+    const uint64_t latencyNs       = m_coilLatencyTotalNs.load(std::memory_order_relaxed);
+    const uint64_t maxLatencyNs    = m_coilLatencyMaxNs.exchange(0, std::memory_order_relaxed);
+    const uint64_t newCommands     = appliedCommands - m_loggedCoilCommands;
+    const uint64_t meanLatencyNs   = newCommands ? (latencyNs - m_loggedCoilLatencyNs) / newCommands : 0;
+    appendCommentWithTimestamp(fileNamesContainer.newModbusServerLogFile,
+                               "coil commands: "+std::to_string(newCommands)+" processed, "
+                               +std::to_string(failedCommands - m_loggedFailedCommands)+" failed, "
+                               +std::to_string(coalescedWrites - m_loggedCoalescedWrites)+" writes coalesced, mean latency "
+                               +std::to_string(meanLatencyNs / 1000)+" us, max latency "+std::to_string(maxLatencyNs / 1000)+" us since the previous report");
+    m_loggedCoilCommands    = appliedCommands;
+    m_loggedCoalescedWrites = coalescedWrites;
+    m_loggedFailedCommands  = failedCommands;
+    m_loggedCoilLatencyNs   = latencyNs;
 }
 
 void NewModbusServer::reMapCoilsValues(const std::vector<bool>& newValues) {
@@ -519,7 +1022,7 @@ void NewModbusServer::reMapCoilsValues(const std::vector<bool>& newValues) {
 }
 
 bool NewModbusServer::modbusSetSlaveId(int newSlaveId) {
-    // Lock the mutex to ensure thread safety when accessing the modbus context (ctx)
+    // Lock the mutex to ensure thread safety when accessing the modbus contexts of the workers
     std::lock_guard<std::mutex> lock(ctxMutex);
 
     // Check if the newSlaveId is within the valid range (0 to 255)
@@ -530,13 +1033,15 @@ bool NewModbusServer::modbusSetSlaveId(int newSlaveId) {
         return false; // Return false to indicate failure
     }
 
-    // Attempt to set the new slave ID
-    if (modbus_set_slave(ctx, newSlaveId) == -1) {
-        // If there was an error, retrieve the error message and handle it
-        std::string error = modbus_strerror(errno);
-        appendCommentWithTimestamp(fileNamesContainer.newModbusServerLogFile,"in NewModbusServer::modbusSetSlaveId(int newSlaveId) Failed to set the slave ID: "+error);
-        std::cerr << "Failed to set the slave ID: " << error << std::endl;
-        return false; // Return false to indicate failure
+    // Attempt to set the new slave ID on every worker
+    for (std::unique_ptr<ModbusWorker> &worker : m_workers) {
+        if (modbus_set_slave(worker->ctx, newSlaveId) == -1) {
+            // If there was an error, retrieve the error message and handle it
+            std::string error = modbus_strerror(errno);
+            appendCommentWithTimestamp(fileNamesContainer.newModbusServerLogFile,"in NewModbusServer::modbusSetSlaveId(int newSlaveId) Failed to set the slave ID: "+error);
+            std::cerr << "Failed to set the slave ID: " << error << std::endl;
+            return false; // Return false to indicate failure
+        }
     }
 
     return true; // Return true to indicate success
@@ -571,5 +1076,6 @@ std::shared_ptr<NItoModbusBridge> NewModbusServer::getModbusBridge() const
 
 void NewModbusServer::setModbusBridge(const std::shared_ptr<NItoModbusBridge> &modbusBridge)
 {
-    m_modbusBridge = modbusBridge;
+    // The actuator thread may already be running
+    std::atomic_store(&m_modbusBridge, modbusBridge);
 }
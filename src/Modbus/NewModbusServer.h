@@ -2,14 +2,21 @@
 #define NEWMODBUSSERVER_H
 
 #include <map>
+#include <unordered_map>
+#include <chrono>
 #include <modbus.h>
+#include <memory>
 #include <mutex>
+#include <atomic>
+#include <cstdint>
 #include <vector>
 #include <string>
+#include <thread>
 #include "../filesUtils/iniObject.h"
 #include "../filesUtils/cPosixFileHelper.h"
 #include "../filesUtils/appendToFileHelper.h"
 #include "../globals/globalEnumStructs.h"
+#include "../threadSafeBuffers/coilCommandQueue.h"
 
 class NItoModbusBridge;
 
@@ -23,14 +30,68 @@ struct SensorRigUpStruct {
 };
 
 
+// One immutable version of the input registers. The bridge publishes a new one by pointer swap,
+// a reply is always built from a single frame: the words of a counter never mix two acquisitions
+struct InputRegistersFrame {
+    uint64_t              version = 0;
+    std::vector<uint16_t> registers;
+    std::vector<uint8_t>  encodedRegisters; // the same registers in modbus (big endian) order, encoded once per frame
+};
+
+
+// One client of the server: its bytes are accumulated until a whole request (MBAP header + PDU) is there,
+// so a slow or half sent client never blocks the others.
+// What the socket did not take of a response waits in output: the next requests are only parsed once it is sent
+struct ModbusConnection {
+    std::string                           ipAddress;
+    uint8_t                               buffer[MODBUS_TCP_MAX_ADU_LENGTH];
+    size_t                                received = 0;
+    std::vector<uint8_t>                  output;
+    std::chrono::steady_clock::time_point lastActivity;
+};
+
+
+// Complete response to a read request (FC03 / FC04), reused while the registers it was built from keep the same version:
+// only the transaction id changes from one poll to the next
+struct CachedReadResponse {
+    uint64_t version = 0;
+    uint16_t length  = 0; // 0 until the first build
+    uint8_t  adu[MODBUS_TCP_MAX_ADU_LENGTH];
+};
+
+
+// One serving thread: its own listening socket on the same port (SO_REUSEPORT, the kernel spreads the clients),
+// epoll instance, modbus context and connections, only touched by its thread.
+// Its mapping shares the coils and holding registers of mb_mapping but serves its own copy of the latest input registers frame
+struct ModbusWorker {
+    unsigned int                    index          = 0;
+    modbus_t                       *ctx            = nullptr;
+    modbus_mapping_t                mapping;
+    std::vector<uint16_t>           inputRegisters;
+    uint64_t                        servedVersion  = 0;
+    int                             serverSocket   = -1;
+    int                             epollFd        = -1;
+    int                             stopEventFd    = -1; // in the epoll set, written by stopServer() to wake the worker up
+    std::map<int, ModbusConnection> connections;
+    std::unordered_map<uint64_t, CachedReadResponse> readResponses; // key: unit id, function, address, count
+};
+
+
 class NewModbusServer {
 public:
     NewModbusServer();
     ~NewModbusServer();
 
+    //starts the other worker threads and serves with the first one,
+    //returns once stopServer() was called and every worker ended
     void runServer();
+    //wakes every worker up and makes it end, the connections are closed by the destructor
+    void stopServer();
     bool modbusSetSlaveId                    (int newSlaveId);
+    //both remaps only write the registers whose value changed, count them and publish a new frame when any did
     void reMapInputRegisterValuesForAnalogics(const std::vector<uint16_t>& newValues);
+    //copies only the listed registers of newValues, e.g. the dirty rows of one module
+    void reMapInputRegisters                 (const std::vector<uint16_t>& newValues, const std::vector<int>& addresses);
     void reMapCoilsValues                    (const std::vector<bool>& newValues);
     
     SensorRigUpStruct getSRUMapping() const;  
@@ -38,13 +99,49 @@ public:
 
     int getSRUMappingSizeWithoutAlarms();
 
+    //publication load: remap calls and input registers actually changed since the start
+    void getInputRegistersPublicationCounts(uint64_t &publications, uint64_t &changedRegisters) const;
+    //logs the publication load since the previous call, meant to run as a periodic job
+    void logPublicationLoad();
+    //logs the coil commands applied, the coalesced writes and the completion latency since the previous call
+    void logActuatorLoad();
+
     std::shared_ptr<NItoModbusBridge> getModbusBridge() const;
     void setModbusBridge(const std::shared_ptr<NItoModbusBridge>& modbusBridge);
 
 
 protected:
-    static const int NB_CONNECTION = 25 ;
-    std::mutex mb_mapping_mutex         ; // Mutex for thread-safe access to mb_mapping
+    static const int MAX_EPOLL_EVENTS   = 64;
+    static const int MBAP_HEADER_LENGTH = 7 ; // transaction id, protocol id, length, unit id
+    static const int MODBUS_TCP_PORT    = 502;
+    static const size_t MAX_CACHED_READ_RESPONSES = 256; // per worker, the cache restarts empty beyond
+    int m_maxConnections = 25   ; // modbus.ini [network] maxconnections, for all the workers
+    int m_idleTimeoutMs  = 60000; // modbus.ini [network] idletimeoutms, 0 never disconnects
+    int m_nbWorkers      = 1    ; // modbus.ini [network] workerthreads
+    std::atomic<int> m_nbConnections{0}; // clients of all the workers
+    std::mutex mb_mapping_mutex         ; // Mutex for thread-safe access to the coils and holding registers of mb_mapping
+    std::unique_ptr<CoilCommandQueue> m_coilCommands; // coil writes of all the workers, applied by the actuator thread only
+    std::thread       m_actuatorThread                ; // single owner of the relays, the workers never wait for DAQmx
+    std::atomic<bool> m_actuatorRunning{false}        ;
+    std::atomic<uint64_t> m_appliedCoilCommands{0}    ; // commands processed by the actuator, applied or failed
+    std::atomic<uint64_t> m_failedCoilCommands{0}     ; // commands whose relay write failed, their coils went back to the applied state
+    std::vector<uint8_t>  m_appliedCoilStates         ; // actuator thread only: last state actually written to each coil
+    std::atomic<uint64_t> m_coilLatencyTotalNs{0}     ; // sum of the completion latencies (oldest write to relay written)
+    std::atomic<uint64_t> m_coilLatencyMaxNs{0}       ; // worst completion latency since the previous logActuatorLoad()
+    uint64_t m_loggedCoilCommands     = 0; // counts at the previous logActuatorLoad()
+    uint64_t m_loggedCoalescedWrites  = 0;
+    uint64_t m_loggedFailedCommands   = 0;
+    uint64_t m_loggedCoilLatencyNs    = 0;
+    std::mutex m_inputRegistersWriterMutex; // serializes the input registers writers, never taken by the workers
+    std::vector<uint16_t>                      m_inputRegistersDraft        ; // next frame, writer side
+    std::shared_ptr<const InputRegistersFrame> m_inputRegistersFrame        ; // latest frame, std::atomic_load / std::atomic_exchange only
+    std::shared_ptr<InputRegistersFrame>       m_spareInputRegistersFrame   ; // previous frame, recycled once no reader holds it anymore
+    std::atomic<uint64_t> m_inputRegistersVersion{0}     ; // version of m_inputRegistersFrame, set after each swap
+    std::atomic<uint64_t> m_holdingRegistersVersion{0}   ; // bumped under mb_mapping_mutex by every client write of holding registers
+    std::atomic<uint64_t> m_inputRegistersPublications{0}; // remap calls
+    std::atomic<uint64_t> m_changedInputRegisters{0}     ; // input registers written with a new value
+    uint64_t m_loggedPublications     = 0; // counts at the previous logPublicationLoad()
+    uint64_t m_loggedChangedRegisters = 0;
     std::mutex ctxMutex                 ; // Mutex for thread-safe access to modbus context
     mutable std::mutex sruMappingMutex  ; // Mutex for thread-safe access to sru (client) Mapping
                                           //the mutext must be mutable for the const getter
@@ -53,12 +150,11 @@ protected:
     std::map<int, std::string> clientList; // Map of client socket to IP address 
 
     
-    modbus_t          *ctx                           ; //modbus context
     modbus_mapping_t  *mb_mapping                    ; //internal modbus mapping
     std::shared_ptr<NItoModbusBridge> m_modbusBridge ; //alarms needs direct access to the bridge
-    int               server_socket                  ; //socket id
-    fd_set            refset                         ; //for select and pselect
-    int               fdmax                          ;
+    std::vector<std::unique_ptr<ModbusWorker>> m_workers; //serving threads, created with the server
+    std::vector<std::thread> m_workerThreads            ; //threads of the workers but the first one, joined before anything is freed
+    std::atomic<bool>        m_serverRunning{false}     ;
     
     SensorRigUpStruct SRUMapping    ;  //this define the client configuration
     std::shared_ptr<IniObject> m_ini;  //helper object to read/write inifiles
@@ -66,14 +162,29 @@ protected:
     void loadConfig();
 
     void        initializeModbusContext        ();
-    void        setupServerSocket              ();
-    void        handleNewConnection            ();
-    void        handleClientRequest            (int master_socket);
+    void        publishInputRegistersFrame     ();
+    void        refreshServedInputRegisters    (ModbusWorker &worker);
+    void        setupWorkers                   ();
+    int         createListeningSocket          ();
+    void        runWorker                      (ModbusWorker &worker);
+    void        handleNewConnection            (ModbusWorker &worker);
+    void        handleClientRequest            (ModbusWorker &worker, int master_socket);
+    void        handleClientWritable           (ModbusWorker &worker, int master_socket);
+    // The bool returned by the functions below is false when the connection must be closed
+    bool        processBufferedRequests        (ModbusWorker &worker, int master_socket, ModbusConnection &connection);
+    bool        processRequest                 (ModbusWorker &worker, int master_socket, const uint8_t *query, int rc);
+    bool        sendResponse                   (ModbusWorker &worker, int master_socket, const uint8_t *response, size_t length);
+    bool        flushOutput                    (ModbusWorker &worker, int master_socket, ModbusConnection &connection);
+    const CachedReadResponse *cachedReadResponse(ModbusWorker &worker, const uint8_t *query, int rc);
+    static int  minimumRequestLength           (const uint8_t *query, int rc);
+    void        closeConnection                (ModbusWorker &worker, int socket);
+    void        closeIdleConnections           (ModbusWorker &worker, std::chrono::steady_clock::time_point now);
+    void        runActuator                    ();
+    void        restoreAppliedCoils            (const std::vector<CoilCommandQueue::Command> &commands, const std::vector<uint16_t> &failedCoils);
     void        handleWriteSingleCoilRequest   (uint16_t coilAddr, bool state);
-    void        acknowledgeSingleCoilWriting   (const uint8_t *query, int query_length);
+    bool        acknowledgeSingleCoilWriting   (ModbusWorker &worker, const uint8_t *query, int query_length, uint16_t coilAddr, bool state);
 
     void        handleWriteMultipleCoilRequest (std::vector<uint16_t> coilsAddr, std::vector<bool> states);
-    int         findMaxSocket                (); 
     void        updateClientList             (int socket, const std::string& ipAddress, bool remove);
     void        broadcastClientList          (); 
     static void closeServer                  (int signal);
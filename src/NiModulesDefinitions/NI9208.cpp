@@ -36,6 +36,10 @@ void NI9208::initModule()
         m_shuntLocation = defaultLocation; // Ensure defaultLocation is a valid, safe default
         m_shuntValue = 34.01; // Consider external configuration for flexibility
         m_moduleTerminalConfig = referencedSingleEnded; // Validate if this config is always safe
+        // Continuous acquisition defaults: 7 samples per block in high speed mode
+        m_samplingRate       = 31.25;
+        m_samplesPerChannel  = 7;
+        m_acquisitionTimeout = 1.0;
     }
     catch (const std::exception& e) {
        // Handle standard exceptions
@@ -35,6 +35,10 @@ void NI9239::initModule()
         m_shuntLocation = noShunt;
         m_shuntValue = -999999.999; // Placeholder value, adjust if necessary
         m_moduleTerminalConfig = differencial; // Setting terminal configuration
+        // Continuous acquisition defaults: 5581 samples (prime) per block at 50 kHz to reject both 50 Hz and 60 Hz power lines noise
+        m_samplingRate       = 50000.0;
+        m_samplesPerChannel  = 5581;
+        m_acquisitionTimeout = 2.0;
     }
     catch (const std::exception& e) {
         // Handle standard exceptions
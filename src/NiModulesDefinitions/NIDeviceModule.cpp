@@ -232,6 +232,25 @@ bool NIDeviceModule::loadCounters(const std::string &filename, const ModuleType
     setCounterMax(counterMax);
     setCounterMin(counterMin);
 
+    // Averaging window of the frequency registers, optional: older files keep the default
+    if (aModuleType == ModuleType::isCounter)
+    {
+        double frequencyWindow = m_ini->readDouble("counters",
+                                                   "frequencywindow",
+                                                   m_frequencyWindow,
+                                                   filename,
+                                                   ok);
+        if (!ok || frequencyWindow <= 0.0)
+        {
+            appendCommentWithTimestamp(m_fileNamesContainer.niDeviceModuleLogFile,
+                                       "in\n"
+                                       "bool NIDeviceModule::loadCounters(const std::string &filename, const ModuleType &aModuleType)\n"
+                                       "Warning: read 'counters' 'frequencywindow' failed or <= 0, keep default for:\n"+filename);
+            frequencyWindow = m_frequencyWindow;
+        }
+        setFrequencyWindow(frequencyWindow);
+    }
+
     // If this point is reached, all data is successfully loaded
     return true;
 }
@@ -307,6 +326,141 @@ bool NIDeviceModule::loadOutputs(const std::string &filename, const ModuleType &
     return true;
 }
 
+bool NIDeviceModule::loadAcquisition(const std::string &filename, const ModuleType &aModuleType)
+{
+    bool ok = false;
+    // Only analogic modules are acquired continuously, other modules may omit the section
+    if (aModuleType != ModuleType::isAnalogicInputCurrent && aModuleType != ModuleType::isAnalogicInputVoltage)
+    {
+        return true;
+    }
+
+    // Read the hardware sample clock rate
+    double samplingRate = m_ini->readDouble("acquisition",
+                                            "samplingrate",
+                                            m_samplingRate,
+                                            filename,
+                                            ok);
+    if (!ok)
+    {
+        appendCommentWithTimestamp(m_fileNamesContainer.niDeviceModuleLogFile,
+                                   "in\n"
+                                   "bool NIDeviceModule::loadAcquisition(const std::string &filename, const ModuleType &aModuleType)\n"
+                                   "Error: read 'acquisition' 'samplingrate' failed, keep default for:\n"+filename);
+    }
+
+    // Read the block size (samples per channel reduced into one value)
+    unsigned int samplesPerChannel = m_ini->readUnsignedInteger("acquisition",
+                                                                "samplesperchannel",
+                                                                m_samplesPerChannel,
+                                                                filename,
+                                                                ok);
+    if (!ok)
+    {
+        appendCommentWithTimestamp(m_fileNamesContainer.niDeviceModuleLogFile,
+                                   "in\n"
+                                   "bool NIDeviceModule::loadAcquisition(const std::string &filename, const ModuleType &aModuleType)\n"
+                                   "Error: read 'acquisition' 'samplesperchannel' failed, keep default for:\n"+filename);
+    }
+
+    // Read the read timeout
+    double timeout = m_ini->readDouble("acquisition",
+                                       "timeout",
+                                       m_acquisitionTimeout,
+                                       filename,
+                                       ok);
+    if (!ok)
+    {
+        appendCommentWithTimestamp(m_fileNamesContainer.niDeviceModuleLogFile,
+                                   "in\n"
+                                   "bool NIDeviceModule::loadAcquisition(const std::string &filename, const ModuleType &aModuleType)\n"
+                                   "Error: read 'acquisition' 'timeout' failed, keep default for:\n"+filename);
+    }
+
+    // Optional raw acquisition, native codes instead of scaled doubles
+    bool rawAcquisition = m_ini->readBoolean("acquisition",
+                                             "raw",
+                                             m_rawAcquisition,
+                                             filename,
+                                             ok);
+    if (rawAcquisition && aModuleType != ModuleType::isAnalogicInputVoltage)
+    {
+        appendCommentWithTimestamp(m_fileNamesContainer.niDeviceModuleLogFile,
+                                   "in\n"
+                                   "bool NIDeviceModule::loadAcquisition(const std::string &filename, const ModuleType &aModuleType)\n"
+                                   "Warning: 'acquisition' 'raw' is only available on voltage modules, ignored for:\n"+filename);
+        rawAcquisition = false;
+    }
+
+    if (samplingRate <= 0.0 || samplesPerChannel == 0)
+    {
+        appendCommentWithTimestamp(m_fileNamesContainer.niDeviceModuleLogFile,
+                                   "in\n"
+                                   "bool NIDeviceModule::loadAcquisition(const std::string &filename, const ModuleType &aModuleType)\n"
+                                   "Error: sampling rate and samples per channel must be > 0 for:\n"+filename);
+        return false;
+    }
+
+    // A block must fit in the timeout, otherwise every read would fail
+    double blockDuration = static_cast<double>(samplesPerChannel) / samplingRate;
+    if (timeout <= blockDuration)
+    {
+        appendCommentWithTimestamp(m_fileNamesContainer.niDeviceModuleLogFile,
+                                   "in\n"
+                                   "bool NIDeviceModule::loadAcquisition(const std::string &filename, const ModuleType &aModuleType)\n"
+                                   "Warning: timeout shorter than one block, set to twice the block duration for:\n"+filename);
+        timeout = 2.0 * blockDuration;
+    }
+
+    setSamplingRate(samplingRate);
+    setSamplesPerChannel(samplesPerChannel);
+    setAcquisitionTimeout(timeout);
+    setRawAcquisition(rawAcquisition);
+    return loadFilters(filename);
+}
+
+bool NIDeviceModule::loadFilters(const std::string &filename)
+{
+    bool ok = false;
+    DspChainSettings settings;
+
+    // The section is optional: without chain the blocks are simply averaged
+    const std::string moduleChain = m_ini->readString("filters", "chain", "", filename, ok);
+    settings.channelChains.resize(m_nbChannel);
+    for (unsigned int i = 0; i < m_nbChannel; ++i)
+    {
+        // chainN overrides the module chain for channel N
+        settings.channelChains[i] = m_ini->readString("filters", "chain" + std::to_string(i), moduleChain, filename, ok);
+    }
+    if (!settings.isConfigured())
+    {
+        setDspChainSettings(settings);
+        return true;
+    }
+
+    settings.notchFrequency = m_ini->readDouble         ("filters", "notchfrequency", settings.notchFrequency, filename, ok);
+    settings.notchQ         = m_ini->readDouble         ("filters", "notchq",         settings.notchQ,         filename, ok);
+    settings.lowPassCutoff  = m_ini->readDouble         ("filters", "lowpasscutoff",  settings.lowPassCutoff,  filename, ok);
+    settings.lowPassQ       = m_ini->readDouble         ("filters", "lowpassq",       settings.lowPassQ,       filename, ok);
+    settings.decimation     = m_ini->readUnsignedInteger("filters", "decimation",     settings.decimation,     filename, ok);
+    settings.outputRate     = m_ini->readDouble         ("filters", "outputrate",     settings.outputRate,     filename, ok);
+    settings.cicOrder       = m_ini->readUnsignedInteger("filters", "cicorder",       settings.cicOrder,       filename, ok);
+    settings.firTapsPerPhase= m_ini->readUnsignedInteger("filters", "firtaps",        settings.firTapsPerPhase,filename, ok);
+    settings.windowLength   = m_ini->readUnsignedInteger("filters", "window",         settings.windowLength,   filename, ok);
+    // "mean" of the decimated samples of the block, or the "last" one
+    settings.publishLast    = m_ini->readString         ("filters", "output",         "mean",                  filename, ok) == "last";
+    if (settings.decimation == 0 || settings.windowLength == 0 || settings.firTapsPerPhase == 0 || settings.outputRate < 0.0)
+    {
+        appendCommentWithTimestamp(m_fileNamesContainer.niDeviceModuleLogFile,
+                                   "in\n"
+                                   "bool NIDeviceModule::loadFilters(const std::string &filename)\n"
+                                   "Error: 'filters' 'decimation', 'window' and 'firtaps' must be > 0, 'outputrate' >= 0 for:\n"+filename);
+        return false;
+    }
+    setDspChainSettings(settings);
+    return true;
+}
+
 bool NIDeviceModule::loadModules(const std::string &filename, ModuleType &aModuleType)
 {
     bool ok = false;
@@ -594,6 +748,7 @@ void NIDeviceModule::saveCounters(const std::string &filename, const ModuleType
         }
         m_ini->writeUnsignedInteger("counters", "countingmax", m_counterMax, filename);
         m_ini->writeUnsignedInteger("counters", "countingmin", m_counterMin, filename);
+        m_ini->writeDouble("counters", "frequencywindow", m_frequencyWindow, filename);
 
     }
 }
@@ -650,6 +805,97 @@ void NIDeviceModule::saveOutputs(const std::string &filename, const ModuleType &
 
 }
 
+void NIDeviceModule::saveAcquisition(const std::string &filename, const ModuleType &aModuleType)
+{
+    // Check if the filename is empty
+    if (filename.empty())
+    {
+        appendCommentWithTimestamp(m_fileNamesContainer.niDeviceModuleLogFile,
+                                   "in \n"
+                                   "void NIDeviceModule::saveAcquisition(const std::string &filename, const ModuleType &aModuleType)\n" 
+                                   "failed to save: file name is empty ");
+        return;
+    }
+
+    // Only analogic modules have a continuous acquisition section
+    if (aModuleType != ModuleType::isAnalogicInputCurrent && aModuleType != ModuleType::isAnalogicInputVoltage)
+    {
+        return;
+    }
+
+    bool ok;
+    ok = m_ini->writeDouble("acquisition", "samplingrate", m_samplingRate, filename);
+    if (!ok)
+    {
+        appendCommentWithTimestamp(m_fileNamesContainer.niDeviceModuleLogFile,
+                                   "in\n"
+                                   "void NIDeviceModule::saveAcquisition(const std::string &filename, const ModuleType &aModuleType)\n"
+                                   "Error: impossible to write 'acquisition' 'samplingrate'\n"
+                                   "file name:\n"+filename);
+    }
+    ok = m_ini->writeUnsignedInteger("acquisition", "samplesperchannel", m_samplesPerChannel, filename);
+    if (!ok)
+    {
+        appendCommentWithTimestamp(m_fileNamesContainer.niDeviceModuleLogFile,
+                                   "in\n"
+                                   "void NIDeviceModule::saveAcquisition(const std::string &filename, const ModuleType &aModuleType)\n"
+                                   "Error: impossible to write 'acquisition' 'samplesperchannel'\n"
+                                   "file name:\n"+filename);
+    }
+    ok = m_ini->writeDouble("acquisition", "timeout", m_acquisitionTimeout, filename);
+    if (!ok)
+    {
+        appendCommentWithTimestamp(m_fileNamesContainer.niDeviceModuleLogFile,
+                                   "in\n"
+                                   "void NIDeviceModule::saveAcquisition(const std::string &filename, const ModuleType &aModuleType)\n"
+                                   "Error: impossible to write 'acquisition' 'timeout'\n"
+                                   "file name:\n"+filename);
+    }
+    ok = m_ini->writeBoolean("acquisition", "raw", m_rawAcquisition, filename);
+    if (!ok)
+    {
+        appendCommentWithTimestamp(m_fileNamesContainer.niDeviceModuleLogFile,
+                                   "in\n"
+                                   "void NIDeviceModule::saveAcquisition(const std::string &filename, const ModuleType &aModuleType)\n"
+                                   "Error: impossible to write 'acquisition' 'raw'\n"
+                                   "file name:\n"+filename);
+    }
+    saveFilters(filename);
+}
+
+void NIDeviceModule::saveFilters(const std::string &filename)
+{
+    // Modules without chain keep their ini file without [filters] section
+    if (!m_dspChainSettings.isConfigured())
+    {
+        return;
+    }
+
+    bool ok = true;
+    for (size_t i = 0; i < m_dspChainSettings.channelChains.size(); ++i)
+    {
+        ok &= m_ini->writeString("filters", "chain" + std::to_string(i), m_dspChainSettings.channelChains[i], filename);
+    }
+    ok &= m_ini->writeDouble         ("filters", "notchfrequency", m_dspChainSettings.notchFrequency, filename);
+    ok &= m_ini->writeDouble         ("filters", "notchq",         m_dspChainSettings.notchQ,         filename);
+    ok &= m_ini->writeDouble         ("filters", "lowpasscutoff",  m_dspChainSettings.lowPassCutoff,  filename);
+    ok &= m_ini->writeDouble         ("filters", "lowpassq",       m_dspChainSettings.lowPassQ,       filename);
+    ok &= m_ini->writeUnsignedInteger("filters", "decimation",     m_dspChainSettings.decimation,     filename);
+    ok &= m_ini->writeDouble         ("filters", "outputrate",     m_dspChainSettings.outputRate,     filename);
+    ok &= m_ini->writeUnsignedInteger("filters", "cicorder",       m_dspChainSettings.cicOrder,       filename);
+    ok &= m_ini->writeUnsignedInteger("filters", "firtaps",        m_dspChainSettings.firTapsPerPhase,filename);
+    ok &= m_ini->writeUnsignedInteger("filters", "window",         m_dspChainSettings.windowLength,   filename);
+    ok &= m_ini->writeString         ("filters", "output",         m_dspChainSettings.publishLast ? "last" : "mean", filename);
+    if (!ok)
+    {
+        appendCommentWithTimestamp(m_fileNamesContainer.niDeviceModuleLogFile,
+                                   "in\n"
+                                   "void NIDeviceModule::saveFilters(const std::string &filename)\n"
+                                   "Error: impossible to write the 'filters' section\n"
+                                   "file name:\n"+filename);
+    }
+}
+
 void NIDeviceModule::saveModules(const std::string &filename, ModuleType &aModuleType)
 {
     // Check if the filename is empty
@@ -756,6 +1002,7 @@ void NIDeviceModule::loadFromFile(const std::string &filename)
     bool channelsLoaded       = loadChannels (filename, modType);
     bool countersLoaded       = loadCounters (filename, modType);
     bool digitalOutputsLoaded = loadOutputs  (filename, modType);
+    bool acquisitionLoaded    = loadAcquisition(filename, modType);
 
     // Logging failure of each loading function
     if (!channelsLoaded)
@@ -797,8 +1044,17 @@ void NIDeviceModule::loadFromFile(const std::string &filename)
                                     filename);
     }
 
+    if (!acquisitionLoaded)
+    {
+        appendCommentWithTimestamp(m_fileNamesContainer.niDeviceModuleLogFile,
+                                   "in\n"
+                                   "void NIDeviceModule::loadFromFile(const std::string &filename)\n"
+                                   "Error: Failed to load acquisition information for:\n" +
+                                    filename);
+    }
+
     // If any of the load functions failed, handle accordingly
-    if (!channelsLoaded || !countersLoaded || !modulesLoaded || !digitalOutputsLoaded)
+    if (!channelsLoaded || !countersLoaded || !modulesLoaded || !digitalOutputsLoaded || !acquisitionLoaded)
     {
         appendCommentWithTimestamp(m_fileNamesContainer.niDeviceModuleLogFile,
                                    "in void NIDeviceModule::loadFromFile(const std::string &filename) One or more components failed to load properly." +
@@ -806,7 +1062,7 @@ void NIDeviceModule::loadFromFile(const std::string &filename)
     }
 
     // Optionally, log overall success if all components loaded successfully
-    if (channelsLoaded && countersLoaded && modulesLoaded && digitalOutputsLoaded)
+    if (channelsLoaded && countersLoaded && modulesLoaded && digitalOutputsLoaded && acquisitionLoaded)
     {
         std::cout << "All components successfully loaded from " << filename << std::endl;
     }
@@ -823,7 +1079,7 @@ void NIDeviceModule::saveToFile(const std::string &filename)
     }
 
     // Boolean flags to track saving status
-    bool channelsSaved = true, countersSaved = true, modulesSaved = true, outputsSaved = true;
+    bool channelsSaved = true, countersSaved = true, modulesSaved = true, outputsSaved = true, acquisitionSaved = true;
     ModuleType modType;
 
     try
@@ -881,17 +1137,31 @@ void NIDeviceModule::saveToFile(const std::string &filename)
                            std::string(e.what()));
         outputsSaved = false;
     }
+
+    try
+    {
+        saveAcquisition(filename,modType);
+    }
+    catch(const std::exception& e)
+    {
+        appendCommentWithTimestamp(m_fileNamesContainer.niDeviceModuleLogFile,
+                           "in void void NIDeviceModule::saveToFile(const std::string &filename) Exception occurred in saveAcquisition for "+
+                           filename+
+                           " Exception: "+
+                           std::string(e.what()));
+        acquisitionSaved = false;
+    }
     
 
     // If any of the save functions failed, handle accordingly
-    if (!channelsSaved || !countersSaved || !modulesSaved || !outputsSaved)
+    if (!channelsSaved || !countersSaved || !modulesSaved || !outputsSaved || !acquisitionSaved)
     {
         appendCommentWithTimestamp(m_fileNamesContainer.niDeviceModuleLogFile,
                                    "in void void NIDeviceModule::saveToFile(const std::string &filename) one or more components failed to save properly");
     }
 
     // Optionally, log overall success if all components saved successfully
-    if (channelsSaved && countersSaved && modulesSaved && outputsSaved)
+    if (channelsSaved && countersSaved && modulesSaved && outputsSaved && acquisitionSaved)
     {
         std::cout << "All components successfully saved to " << filename << std::endl;
     }
@@ -1111,6 +1381,78 @@ moduleUnit NIDeviceModule::getModuleUnit() const
     return m_moduleUnit;
 }
 
+double NIDeviceModule::getSamplingRate() const
+{
+    return m_samplingRate;
+}
+
+unsigned int NIDeviceModule::getSamplesPerChannel() const
+{
+    return m_samplesPerChannel;
+}
+
+double NIDeviceModule::getAcquisitionTimeout() const
+{
+    return m_acquisitionTimeout;
+}
+
+void NIDeviceModule::setSamplingRate(double newSamplingRate)
+{
+    m_samplingRate = newSamplingRate;
+    if (samplingRateChangedSignal)
+    {
+        samplingRateChangedSignal(m_samplingRate, this);
+    }
+}
+
+void NIDeviceModule::setSamplesPerChannel(unsigned int newSamplesPerChannel)
+{
+    m_samplesPerChannel = newSamplesPerChannel;
+    if (samplesPerChannelChangedSignal)
+    {
+        samplesPerChannelChangedSignal(m_samplesPerChannel, this);
+    }
+}
+
+void NIDeviceModule::setAcquisitionTimeout(double newTimeout)
+{
+    m_acquisitionTimeout = newTimeout;
+}
+
+bool NIDeviceModule::getRawAcquisition() const
+{
+    return m_rawAcquisition;
+}
+
+void NIDeviceModule::setRawAcquisition(bool isRaw)
+{
+    m_rawAcquisition = isRaw;
+}
+
+DspChainSettings NIDeviceModule::getDspChainSettings() const
+{
+    return m_dspChainSettings;
+}
+
+void NIDeviceModule::setDspChainSettings(const DspChainSettings &newSettings)
+{
+    m_dspChainSettings = newSettings;
+}
+
+double NIDeviceModule::getFrequencyWindow() const
+{
+    return m_frequencyWindow;
+}
+
+void NIDeviceModule::setFrequencyWindow(double newFrequencyWindow)
+{
+    m_frequencyWindow = newFrequencyWindow;
+    if (frequencyWindowChangedSignal)
+    {
+        frequencyWindowChangedSignal(m_frequencyWindow, this);
+    }
+}
+
 void NIDeviceModule::setModuleName(const std::string &newModuleName)
 {
     m_moduleName = newModuleName;
@@ -30,12 +30,16 @@ bool loadModules (const std::string &filename,       ModuleType &aModuleType);
 bool loadChannels(const std::string &filename, const ModuleType &aModuleType);
 bool loadCounters(const std::string &filename, const ModuleType &aModuleType);
 bool loadOutputs (const std::string &filename, const ModuleType &aModuleType);
+bool loadAcquisition(const std::string &filename, const ModuleType &aModuleType);
+bool loadFilters    (const std::string &filename);
 
 //
 void saveModules (const std::string &filename ,      ModuleType &aModuleType);
 void saveChannels(const std::string &filename, const ModuleType &aModuleType);
 void saveCounters(const std::string &filename, const ModuleType &aModuleType);
 void saveOutputs (const std::string &filename, const ModuleType &aModuleType);
+void saveAcquisition(const std::string &filename, const ModuleType &aModuleType);
+void saveFilters    (const std::string &filename);
 
 protected:
     //number of channels in the module
@@ -54,9 +58,16 @@ protected:
     moduleCounterEdgeConfig  m_counterCountingEdgeMode;
     moduleCounterMode        m_counterCountDirectionMode;
     std::vector<std::string> m_counterNames;
+    double                   m_frequencyWindow  = 1.0; //sliding window in seconds used to average the counter frequency
     //----------- relays (digital outputs) ----------
     unsigned int m_nbDigitalOutputs = 0; //number of outputs for a digital ouput channel (e.g. for relays)
     std::vector<std::string> m_digitalOutputNames;
+    //----------- continuous acquisition ----------
+    double       m_samplingRate        = 0.0; //hardware sample clock rate in Hz (0 = no continuous acquisition)
+    unsigned int m_samplesPerChannel   = 0;   //block size: number of samples per channel reduced into one published value
+    double       m_acquisitionTimeout  = 1.0; //read timeout in seconds, must be larger than the duration of one block
+    bool         m_rawAcquisition      = false; //read native ADC codes and scale once per published value (voltage modules)
+    DspChainSettings m_dspChainSettings;      //optional [filters] section, per channel processing of the blocks
     //----------- modules ------------------------
 
     ModuleType           m_moduleType;
@@ -106,6 +117,12 @@ public:
     virtual double                   getChanMax                   () const;
     virtual unsigned int             getminCounters               () const;
     virtual unsigned int             getmaxCounters               () const;
+    virtual double                   getFrequencyWindow           () const;
+    virtual double                   getSamplingRate              () const;
+    virtual unsigned int             getSamplesPerChannel         () const;
+    virtual double                   getAcquisitionTimeout        () const;
+    virtual bool                     getRawAcquisition            () const;
+    virtual DspChainSettings         getDspChainSettings          () const;
       
 
 
@@ -125,6 +142,7 @@ public:
     virtual void setCounterCountDirectionMode (moduleCounterMode               newCounterCountMode       );
     virtual void setCounterMin                (unsigned int                    newCountersMin            );
     virtual void setCounterMax                (unsigned int                    newCountersMax            );
+    virtual void setFrequencyWindow           (double                          newFrequencyWindow        );
     //----------Digital outputs------------
     virtual void setNbDigitalOutputs          (unsigned int                    newNbDigitalOutpits       );
 
@@ -133,6 +151,12 @@ public:
 
     virtual void setChanMin              (double     newChanMin);
     virtual void setChanMax              (double newChanMax);
+    //----------Continuous acquisition------------
+    virtual void setSamplingRate         (double       newSamplingRate     );
+    virtual void setSamplesPerChannel    (unsigned int newSamplesPerChannel);
+    virtual void setAcquisitionTimeout   (double       newTimeout          );
+    virtual void setRawAcquisition       (bool         isRaw               );
+    virtual void setDspChainSettings     (const DspChainSettings &newSettings);
 
    
 
@@ -162,10 +186,14 @@ public:
     std::function<void(unsigned int            , NIDeviceModule *sender)>  countersMaxChangedSignal          = nullptr;
     std::function<void(moduleCounterEdgeConfig , NIDeviceModule *sender)>  counterEdgeConfigChangedSignal    = nullptr;
     std::function<void(moduleCounterMode       , NIDeviceModule *sender)>  counterModeChangedSignal          = nullptr;
+    std::function<void(double                  , NIDeviceModule *sender)>  frequencyWindowChangedSignal      = nullptr;
     //digital outputs
     std::function<void(unsigned int            , NIDeviceModule *Sender)> nbDigitalOutputsChangedSignal     = nullptr;
 
     std::function<void(unsigned int            , NIDeviceModule *sender)>  nbDigitalIoPortsChangedSignal     = nullptr;
+    //continuous acquisition
+    std::function<void(double                  , NIDeviceModule *sender)>  samplingRateChangedSignal         = nullptr;
+    std::function<void(unsigned int            , NIDeviceModule *sender)>  samplesPerChannelChangedSignal    = nullptr;
 
 
 
@@ -6,6 +6,7 @@
 #include <memory>
 #include "../NiModulesDefinitions/NIDeviceModule.h"
 #include "../mathUtils/mathUtils.h"
+#include "../mathUtils/blockReduction.h"
 
 
 
@@ -92,7 +93,20 @@ QNiDaqWrapper::QNiDaqWrapper()
 
 
 QNiDaqWrapper::~QNiDaqWrapper() {
-
+    std::lock_guard<std::mutex> lock(countersMutex);
+    for (auto &group : counterGroupsMap)
+    {
+        clearCounterGroup(group.second);
+    }
+    std::lock_guard<std::mutex> relaysLock(alarmsMutex);
+    for (auto &port : digitalOutputPortsMap)
+    {
+        if (port.second.taskHandle)
+        {
+            DAQmxStopTask(port.second.taskHandle);
+            DAQmxClearTask(port.second.taskHandle);
+        }
+    }
 }
 
 
@@ -248,21 +262,6 @@ std::string QNiDaqWrapper::generate_hex(const unsigned int len)
     return ss.str(); // Return the hex string
 }
 
-std::vector<double> QNiDaqWrapper::lowPassFilterDatas(const std::vector<double> &dataBuffer, float deltaTime, float cutOffFrequency)
-{
-    std::vector<double> filteredBuffer(dataBuffer.size());
-    lpf.reconfigureFilter(deltaTime, cutOffFrequency); // Adjusting the filter based on the current deltaTime and a fixed cutoff frequency
-    
-    for (size_t i = 0; i < dataBuffer.size(); ++i) 
-    {
-        filteredBuffer[i] = lpf.update(dataBuffer[i]);
-    }
-    
-    return filteredBuffer;
-}
-
-
-
 /*double QNiDaqWrapper::readCurrent(NIDeviceModule *deviceModule, std::string chanName, unsigned int maxRetries, bool autoConvertTomAmps)
 {
     std::lock_guard<std::mutex> lock(currentMutex);
@@ -532,722 +531,395 @@ double QNiDaqWrapper::readCurrent(NIDeviceModule *deviceModule, std::string chan
     return result;
 }
 
-/*void QNiDaqWrapper::readMod1()
+int32 QNiDaqWrapper::configureContinuousSampling(TaskHandle taskHandle, float64 samplingRate, int32 samplesPerChannel)
 {
-    // Hardcoded device name for Mod1 module
-    const char* deviceName = "Mod1";
-    // Initialize task handle to 0, which will be used to identify our task with DAQmx functions
-    TaskHandle taskHandle = readCurrentMod1Task;
-    // Error code returned by DAQmx functions
-    int32 error;
-    // Buffer for error information
-    char errBuff[2048] = {'\0'};
-    // Total number of channels to read from
-    const int32 channelsCount = 16;
-    // Specify the range of current to measure
-    const float64 minRange = 0.004, maxRange = 0.02;
-    // Timeout for DAQmxReadAnalogF64 function in seconds
-    const float64 timeout = 1.0;
-    // We will request 2 samples per channel to meet minimum sample requirement but only use the last sample
-    const int32 samplesPerChannel = 7;
-    // Vector to store the last sample from each channel
-    std::vector<double> lastSamples(channelsCount); 
-    // Number of samples actually read
-    int32 read;
-
-    // Construct full channel names for the device, spanning from /ai0 to /ai15
-    std::string fullChannelNames = std::string(deviceName) + "/ai0:" + std::to_string(channelsCount-1);
-
-    // Generate a unique task name using a helper function (assumed to be defined elsewhere)
-    std::string unicKey = "ReadCurrentMod1" + generate_hex(8);
-    // Create a task
-    if (taskHandle == nullptr)
-    {
-         error = DAQmxCreateTask(unicKey.c_str(), &taskHandle);
-         if (error) {
-             DAQmxGetExtendedErrorInfo(errBuff, 2048);
-             throw std::runtime_error("Failed to create task: " + std::string(errBuff));
-         }
-     
-         // Create analog input current channels for the specified range on the device
-         error = DAQmxCreateAICurrentChan(taskHandle, fullChannelNames.c_str(), "", DAQmx_Val_Cfg_Default, minRange, maxRange, DAQmx_Val_Amps, DAQmx_Val_Default, 0.0, NULL);
-         if (error) {
-             DAQmxGetExtendedErrorInfo(errBuff, 2048);
-             DAQmxClearTask(taskHandle);
-             throw std::runtime_error("Failed to create channels: " + std::string(errBuff));
-         }
-     
-         // Configure the sampling clock with a rate of 30 Hz, finite samples, and rising edge timing
-         error = DAQmxCfgSampClkTiming(taskHandle, "", 31.25, DAQmx_Val_Rising, DAQmx_Val_FiniteSamps, samplesPerChannel);
-         if (error) {
-             DAQmxGetExtendedErrorInfo(errBuff, 2048);
-             DAQmxClearTask(taskHandle);
-             throw std::runtime_error("Failed to configure timing: " + std::string(errBuff));
-         }
-    }
-
-    
-    
-    while (true)
-    {
-        // Start the task to begin measuring
-         error = DAQmxStartTask(taskHandle);
-         if (error) 
-         {
-             DAQmxGetExtendedErrorInfo(errBuff, 2048);
-             DAQmxClearTask(taskHandle);
-             throw std::runtime_error("Failed to start task: " + std::string(errBuff));
-         }
-
-     
-         // Prepare a buffer to read the samples into, sized for all channels and samples
-         std::vector<double> dataBuffer(channelsCount * samplesPerChannel);
-         // Read the samples from all channels into the buffer
-         error = DAQmxReadAnalogF64(taskHandle, samplesPerChannel, timeout, DAQmx_Val_GroupByChannel, dataBuffer.data(), dataBuffer.size(), &read, NULL);
-         if (error) 
-         {
-             DAQmxGetExtendedErrorInfo(errBuff, 2048);
-             DAQmxClearTask(taskHandle);
-             throw std::runtime_error("Failed to read data: " + std::string(errBuff));
-         }
-     
-        std::string result;
-         // Extract the last sample for each channel from the buffer
-         for (int i = 0; i < channelsCount; ++i) 
-         {
-             lastSamples[i] = dataBuffer[i * samplesPerChannel + samplesPerChannel - 1];
-             result += std::to_string(lastSamples[i]) + ";";
-         }
-
-        Mod1Buffer.restore(lastSamples);
-
-
-        //Acquisition goes here
-        DAQmxStopTask(taskHandle);
+    // In continuous mode the sample clock free runs and DAQmx fills its own ring buffer in the background,
+    // the reading loop only pulls fixed size blocks out of it, so block N is processed while block N+1 is acquired.
+    // The ring buffer is sized for several blocks to absorb scheduling jitter of the reading thread.
+    const uInt32 ringBufferSize = static_cast<uInt32>(samplesPerChannel) * continuousBufferBlocks;
+    int32 error = DAQmxCfgSampClkTiming(taskHandle, "", samplingRate, DAQmx_Val_Rising, DAQmx_Val_ContSamps, ringBufferSize);
+    if (error)
+    {
+        return error;
     }
-}*/
+    // Explicitly size the input buffer, otherwise DAQmx picks a size from the rate that may be smaller than our blocks
+    return DAQmxCfgInputBuffer(taskHandle, ringBufferSize);
+}
 
-void QNiDaqWrapper::readMod1()
+bool QNiDaqWrapper::recoverContinuousTask(TaskHandle taskHandle, int32 error, const std::string &deviceName)
 {
-
-    // Hardcoded device name for Mod1 module
-    const char* deviceName = "Mod1";
-    // Initialize task handle to 0, which will be used to identify our task with DAQmx functions
-    TaskHandle taskHandle = readCurrentMod1Task;
-    // Error code returned by DAQmx functions
-    int32 error;
-    // Buffer for error information
-    char errBuff[2048] = {'\0'};
-    // Total number of channels to read from
-    const int32 channelsCount = 16;
-    // Specify the range of current to measure
-    const float64 minRange = 0.004, maxRange = 0.02;
-    // Timeout for DAQmxReadAnalogF64 function in seconds
-    const float64 timeout = 1.0;
-    // We will request 2 samples per channel to meet minimum sample requirement but only use the last sample
-    const int32 samplesPerChannel = 7;
-    // Number of samples actually read
-    int32 read;
-
-    // Construct full channel names for the device, spanning from /ai0 to /ai15
-    std::string fullChannelNames = std::string(deviceName) + "/ai0:" + std::to_string(channelsCount-1);
-
-    // Generate a unique task name using a helper function (assumed to be defined elsewhere)
-    std::string unicKey = "ReadCurrentMod1" + generate_hex(8);
-    // Create a task
-    if (taskHandle == nullptr)
-    {
-         error = DAQmxCreateTask(unicKey.c_str(), &taskHandle);
-         if (error) {
-             DAQmxGetExtendedErrorInfo(errBuff, 2048);
-             throw std::runtime_error("Failed to create task: " + std::string(errBuff));
-         }
-     
-         // Create analog input current channels for the specified range on the device
-         error = DAQmxCreateAICurrentChan(taskHandle, fullChannelNames.c_str(), "", DAQmx_Val_Cfg_Default, minRange, maxRange, DAQmx_Val_Amps, DAQmx_Val_Default, 0.0, NULL);
-         if (error) {
-             DAQmxGetExtendedErrorInfo(errBuff, 2048);
-             DAQmxClearTask(taskHandle);
-             throw std::runtime_error("Failed to create channels: " + std::string(errBuff));
-         }
-     
-         // Configure the sampling clock with a rate of 30 Hz, finite samples, and rising edge timing
-         error = DAQmxCfgSampClkTiming(taskHandle, "", 31.25, DAQmx_Val_Rising, DAQmx_Val_FiniteSamps, samplesPerChannel);
-         if (error) {
-             DAQmxGetExtendedErrorInfo(errBuff, 2048);
-             DAQmxClearTask(taskHandle);
-             throw std::runtime_error("Failed to configure timing: " + std::string(errBuff));
-         }
-    }
-
-    
-    
-    while (true)
-    {
-        // Start the task to begin measuring
-         error = DAQmxStartTask(taskHandle);
-         if (error) 
-         {
-             DAQmxGetExtendedErrorInfo(errBuff, 2048);
-             DAQmxClearTask(taskHandle);
-             throw std::runtime_error("Failed to start task: " + std::string(errBuff));
-         }
-     
-         // Prepare a buffer to read the samples into, sized for all channels and samples
-         std::vector<double> dataBuffer(channelsCount * samplesPerChannel);
-         // Read the samples from all channels into the buffer
-         error = DAQmxReadAnalogF64(taskHandle, samplesPerChannel, timeout, DAQmx_Val_GroupByChannel, dataBuffer.data(), dataBuffer.size(), &read, NULL);
-         if (error) 
-         {
-             DAQmxGetExtendedErrorInfo(errBuff, 2048);
-             DAQmxClearTask(taskHandle);
-             throw std::runtime_error("Failed to read data: " + std::string(errBuff));
-         }
-
-        std::vector<double> averages(channelsCount, 0.0); 
-        // Compute the average for each channel
-        for (int i = 0; i < channelsCount; ++i) 
-        {
-            double sum = 0.0;
-            // Sum all samples for the current channel
-            for (int j = 0; j < samplesPerChannel; ++j) 
-            {
-                sum += dataBuffer[i * samplesPerChannel + j];
-            }
-            // Compute the average and store it in the vector
-            averages[i] = sum / samplesPerChannel;
-        }
-
-        if (m_rollingWindowFilterActiv && (Mod1OldValuesBuffer.size()==Mod1Buffer.size()) && (Mod1OldValuesBuffer.size()>0))
-        {
-            for (int i = 0; i < channelsCount; ++i)
-            {
-                double v1 = averages[i];
-                double v2 = Mod1OldValuesBuffer[i];
-                averages[i] = (v1+v2)/2;
-            }
-        } 
-        
-        Mod1Buffer.restore(averages);
-
-
-        if (m_rollingWindowFilterActiv) Mod1OldValuesBuffer = Mod1Buffer.copy();
-        
-        //std::cout<<std::endl<<result.c_str()<<std::endl;
-        DAQmxStopTask(taskHandle);
-
+    // Only an overwritten ring buffer (the reader was too slow) can be recovered by restarting the acquisition,
+    // every other error is reported to the caller
+    if (error != DAQmxErrorSamplesNoLongerAvailable)
+    {
+        return false;
     }
+    appendCommentWithTimestamp(fileNamesContainer.QNiDaqWrapperLogFile,
+                               "In\n"
+                               "bool QNiDaqWrapper::recoverContinuousTask(TaskHandle taskHandle, int32 error, const std::string &deviceName)\n"
+                               "Warning: ring buffer overwritten on "+deviceName+", restarting the continuous acquisition.");
+    DAQmxStopTask(taskHandle);
+    return DAQmxStartTask(taskHandle) == 0;
 }
 
-void QNiDaqWrapper::readMod2()
+TaskHandle QNiDaqWrapper::createContinuousAnalogTask(NIDeviceModule *deviceModule)
 {
+    // Check for null pointer
+    if (!deviceModule) 
+    {
+        appendCommentWithTimestamp(fileNamesContainer.QNiDaqWrapperLogFile,
+                                   "In\n"
+                                   "TaskHandle QNiDaqWrapper::createContinuousAnalogTask(NIDeviceModule *deviceModule)\n"
+                                   "Error: Null pointer passed for deviceModule.");
+        throw std::invalid_argument("Null pointer passed for deviceModule.");
+    }
 
-    // Hardcoded device name for Mod1 module
-    const char* deviceName = "Mod2";
-    // Initialize task handle to 0, which will be used to identify our task with DAQmx functions
-    TaskHandle taskHandle = readCurrentMod2Task;
-    // Error code returned by DAQmx functions
+    TaskHandle taskHandle = nullptr;
     int32 error;
-    // Buffer for error information
     char errBuff[2048] = {'\0'};
-    // Total number of channels to read from
-    const int32 channelsCount = 16;
-    // Specify the range of current to measure
-    const float64 minRange = 0.004, maxRange = 0.02;
-    // Timeout for DAQmxReadAnalogF64 function in seconds
-    const float64 timeout = 1.0;
-    // We will request 2 samples per channel to meet minimum sample requirement but only use the last sample
-    const int32 samplesPerChannel = 7;
-    // Number of samples actually read
-    int32 read;
-
-    // Construct full channel names for the device, spanning from /ai0 to /ai15
-    std::string fullChannelNames = std::string(deviceName) + "/ai0:" + std::to_string(channelsCount-1);
-
-    // Generate a unique task name using a helper function (assumed to be defined elsewhere)
-    std::string unicKey = "ReadCurrentMod2" + generate_hex(8);
-    // Create a task
-    if (taskHandle == nullptr)
-    {
-         error = DAQmxCreateTask(unicKey.c_str(), &taskHandle);
-         if (error) {
-             DAQmxGetExtendedErrorInfo(errBuff, 2048);
-             throw std::runtime_error("Failed to create task: " + std::string(errBuff));
-         }
-     
-         // Create analog input current channels for the specified range on the device
-         error = DAQmxCreateAICurrentChan(taskHandle, fullChannelNames.c_str(), "", DAQmx_Val_Cfg_Default, minRange, maxRange, DAQmx_Val_Amps, DAQmx_Val_Default, 0.0, NULL);
-         if (error) {
-             DAQmxGetExtendedErrorInfo(errBuff, 2048);
-             DAQmxClearTask(taskHandle);
-             throw std::runtime_error("Failed to create channels: " + std::string(errBuff));
-         }
-     
-         // Configure the sampling clock with a rate of 30 Hz, finite samples, and rising edge timing
-         error = DAQmxCfgSampClkTiming(taskHandle, "", 31.25, DAQmx_Val_Rising, DAQmx_Val_FiniteSamps, samplesPerChannel);
-         if (error) {
-             DAQmxGetExtendedErrorInfo(errBuff, 2048);
-             DAQmxClearTask(taskHandle);
-             throw std::runtime_error("Failed to configure timing: " + std::string(errBuff));
-         }
-    }
-
-    
-    
-    while (true)
-    {
-        // Start the task to begin measuring
-         error = DAQmxStartTask(taskHandle);
-         if (error) 
-         {
-             DAQmxGetExtendedErrorInfo(errBuff, 2048);
-             DAQmxClearTask(taskHandle);
-             throw std::runtime_error("Failed to start task: " + std::string(errBuff));
-         }
-     
-         // Prepare a buffer to read the samples into, sized for all channels and samples
-         std::vector<double> dataBuffer(channelsCount * samplesPerChannel);
-         // Read the samples from all channels into the buffer
-         error = DAQmxReadAnalogF64(taskHandle, samplesPerChannel, timeout, DAQmx_Val_GroupByChannel, dataBuffer.data(), dataBuffer.size(), &read, NULL);
-         if (error) 
-         {
-             DAQmxGetExtendedErrorInfo(errBuff, 2048);
-             DAQmxClearTask(taskHandle);
-             throw std::runtime_error("Failed to read data: " + std::string(errBuff));
-         }
-
-        std::vector<double> averages(channelsCount, 0.0); 
-        // Compute the average for each channel
-        for (int i = 0; i < channelsCount; ++i) 
-        {
-            double sum = 0.0;
-            // Sum all samples for the current channel
-            for (int j = 0; j < samplesPerChannel; ++j) 
-            {
-                sum += dataBuffer[i * samplesPerChannel + j];
-            }
-            // Compute the average and store it in the vector
-            averages[i] = sum / samplesPerChannel;
-        }
-
-        if (m_rollingWindowFilterActiv && (Mod2OldValuesBuffer.size()==Mod2Buffer.size()) && (Mod2OldValuesBuffer.size()>0))
-        {
-            for (int i = 0; i < channelsCount; ++i)
-            {
-                double v1 = averages[i];
-                double v2 = Mod2OldValuesBuffer[i];
-                averages[i] = (v1+v2)/2;
-            }
-        } 
-        
-        Mod2Buffer.restore(averages);
-
-
-        if (m_rollingWindowFilterActiv) Mod2OldValuesBuffer = Mod2Buffer.copy();
-        
-        //std::cout<<std::endl<<result.c_str()<<std::endl;
-        DAQmxStopTask(taskHandle);
 
+    // Everything comes from the module ini file: channel set, range, rate and block size
+    const std::string alias           = deviceModule->getAlias();
+    const ModuleType  modType         = deviceModule->getModuleType();
+    const float64     samplingRate    = deviceModule->getSamplingRate();
+    const int32       samplesPerChannel = static_cast<int32>(deviceModule->getSamplesPerChannel());
+    if (samplingRate <= 0.0 || samplesPerChannel <= 0)
+    {
+        appendCommentWithTimestamp(fileNamesContainer.QNiDaqWrapperLogFile,
+                                   "In\n"
+                                   "TaskHandle QNiDaqWrapper::createContinuousAnalogTask(NIDeviceModule *deviceModule)\n"
+                                   "Error: no continuous acquisition configured for "+alias);
+        throw std::invalid_argument("No continuous acquisition configured for " + alias);
     }
-}
-
-//void QNiDaqWrapper::readMod3()
-//{
-//    // Hardcoded device name for Mod1 module
-//    const char* deviceName = "Mod3";
-//    // Initialize task handle to 0, which will be used to identify our task with DAQmx functions
-//    TaskHandle taskHandle = readVoltageMod3Task;
-//    // Error code returned by DAQmx functions
-//    int32 error;
-//    // Buffer for error information
-//    char errBuff[2048] = {'\0'};
-//    // Total number of channels to read from
-//    const int32 channelsCount = 4;
-//    // Specify the range of current to measure
-//    const float64 minRange = 0.0, maxRange = 10.0;
-//    // Timeout for DAQmxReadAnalogF64 function in seconds
-//    const float64 timeout = 0.1;
-//    // We will request 2 samples per channel to meet minimum sample requirement but only use the last sample
-//    const int32 samplesPerChannel = 1;
-//    // Vector to store the last sample from each channel
-//    std::vector<double> lastSamples(channelsCount); 
-//    int32 read;
-//    // Construct full channel names for the device, spanning from /ai0 to /ai15
-//    std::string fullChannelNames = std::string(deviceName) + "/ai0:" + std::to_string(channelsCount-1);
-//
-//    // Generate a unique task name using a helper function (assumed to be defined elsewhere)
-//    std::string unicKey = "ReadVoltageMod3" + generate_hex(8);
-//    // Create a task
-//    if (taskHandle == nullptr)
-//    {
-//         error = DAQmxCreateTask(unicKey.c_str(), &taskHandle);
-//         if (error) {
-//             DAQmxGetExtendedErrorInfo(errBuff, 2048);
-//             throw std::runtime_error("Failed to create task: " + std::string(errBuff));
-//         }
-//     
-//
-//            // Create an analog input voltage channel
-//        error = DAQmxCreateAIVoltageChan(taskHandle,
-//                                         fullChannelNames.c_str(),
-//                                         "",
-//                                         differencial,
-//                                         minRange,
-//                                         maxRange,
-//                                         Val_Volts,
-//                                         NULL);
-//
-//
-//         if (error) {
-//             DAQmxGetExtendedErrorInfo(errBuff, 2048);
-//             DAQmxClearTask(taskHandle);
-//             throw std::runtime_error("Failed to create channels: " + std::string(errBuff));
-//         }
-//     
-//         // Configure the sampling clock with a rate of 1000 Hz, finite samples, and rising edge timing
-//        // Add sample clock timing configuration (NEW)
-//        error = DAQmxCfgSampClkTiming(taskHandle, "", 1000.0, DAQmx_Val_Rising, DAQmx_Val_ContSamps, 1);
-//        if (error) 
-//        {
-//            DAQmxGetExtendedErrorInfo(errBuff, 2048);
-//            appendCommentWithTimestamp(fileNamesContainer.QNiDaqWrapperLogFile,
-//                                       "In\n"
-//                                       "double QNiDaqWrapper::readVoltage(NIDeviceModule *deviceModule, std::string chanName, unsigned int maxRetries)\n"
-//                                       "Error: Failed to set sample clock timing.\n"+
-//                                       std::string(errBuff));
-//            handleErrorAndCleanTask(taskHandle);
-//            throw std::runtime_error("Failed to set sample clock timing.");
-//        }
-//
-//    }
-//    
-//    while (true)
-//    {
-//        // Start the task to begin measuring
-//         error = DAQmxStartTask(taskHandle);
-//         if (error) 
-//         {
-//             DAQmxGetExtendedErrorInfo(errBuff, 2048);
-//             DAQmxClearTask(taskHandle);
-//             throw std::runtime_error("Failed to start task: " + std::string(errBuff));
-//         }
-//     
-//         // Prepare a buffer to read the samples into, sized for all channels and samples
-//         std::vector<double> dataBuffer(channelsCount * samplesPerChannel);
-//         // Read the samples from all channels into the buffer
-//         error = DAQmxReadAnalogF64(taskHandle, samplesPerChannel, timeout, DAQmx_Val_GroupByChannel, dataBuffer.data(), dataBuffer.size(), &read, NULL);
-//         if (error) 
-//         {
-//             DAQmxGetExtendedErrorInfo(errBuff, 2048);
-//             DAQmxClearTask(taskHandle);
-//             throw std::runtime_error("Failed to read data: " + std::string(errBuff));
-//         }
-//     
-//
-//        Mod3Buffer.restore(dataBuffer);
-//        DAQmxStopTask(taskHandle);
-//    }
-//}
-
-void QNiDaqWrapper::initMod3(const std::string& deviceName, double minRange, double maxRange, int32 samplesPerChannel, double samplingRate, int32 channelsCount) 
-{
-    char errBuff[2048] = {'\0'};
-    int32 error;
 
+    // Build the physical channel list, e.g. "Mod1/ai0,Mod1/ai1,..."
+    std::string fullChannelNames;
+    for (const std::string &chanName : deviceModule->getChanNames())
+    {
+        if (!fullChannelNames.empty()) fullChannelNames += ",";
+        fullChannelNames += alias + chanName;
+    }
 
-    // Create a task
-     error = DAQmxCreateTask("ReadVoltageMod3", &readVoltageMod3Task);
+    std::string unicKey = "ContinuousRead" + alias + generate_hex(8);
+    error = DAQmxCreateTask(unicKey.c_str(), &taskHandle);
     if (error) 
     {
         DAQmxGetExtendedErrorInfo(errBuff, 2048);
+        appendCommentWithTimestamp(fileNamesContainer.QNiDaqWrapperLogFile,
+                                   "In\n"
+                                   "TaskHandle QNiDaqWrapper::createContinuousAnalogTask(NIDeviceModule *deviceModule)\n"
+                                   "Error: Failed to create task for "+alias+"\n"+
+                                   std::string(errBuff));
         throw std::runtime_error("Failed to create task: " + std::string(errBuff));
     }
 
-    // Construct full channel names for the device
-    std::string fullChannelNames = deviceName + "/ai0:" + std::to_string(channelsCount - 1);
+    if (modType == isAnalogicInputCurrent)
+    {
+        error = DAQmxCreateAICurrentChan(taskHandle,
+                                         fullChannelNames.c_str(),
+                                         "",
+                                         deviceModule->getModuleTerminalCfg(),
+                                         deviceModule->getChanMin(),
+                                         deviceModule->getChanMax(),
+                                         DAQmx_Val_Amps,
+                                         deviceModule->getModuleShuntLocation(),
+                                         deviceModule->getModuleShuntValue(),
+                                         NULL);
+    }
+    else if (modType == isAnalogicInputVoltage)
+    {
+        error = DAQmxCreateAIVoltageChan(taskHandle,
+                                         fullChannelNames.c_str(),
+                                         "",
+                                         deviceModule->getModuleTerminalCfg(),
+                                         deviceModule->getChanMin(),
+                                         deviceModule->getChanMax(),
+                                         DAQmx_Val_Volts,
+                                         NULL);
+    }
+    else
+    {
+        DAQmxClearTask(taskHandle);
+        throw std::invalid_argument("Continuous analog acquisition requested on a non analogic module: " + alias);
+    }
 
-    // Create analog input voltage channels
-    error = DAQmxCreateAIVoltageChan(readVoltageMod3Task, fullChannelNames.c_str(), "",
-                                         DAQmx_Val_Diff, minRange, maxRange, DAQmx_Val_Volts, NULL);
     if (error) 
     {
         DAQmxGetExtendedErrorInfo(errBuff, 2048);
-        DAQmxClearTask(readVoltageMod3Task);
+        appendCommentWithTimestamp(fileNamesContainer.QNiDaqWrapperLogFile,
+                                   "In\n"
+                                   "TaskHandle QNiDaqWrapper::createContinuousAnalogTask(NIDeviceModule *deviceModule)\n"
+                                   "Error: Failed to create channels "+fullChannelNames+"\n"+
+                                   std::string(errBuff));
+        handleErrorAndCleanTask(taskHandle);
         throw std::runtime_error("Failed to create channels: " + std::string(errBuff));
     }
 
-        // Configure the sampling clock
-    error = DAQmxCfgSampClkTiming(readVoltageMod3Task, "", samplingRate, DAQmx_Val_Rising, DAQmx_Val_FiniteSamps, samplesPerChannel);
+    // Configure the sampling clock for continuous acquisition into the DAQmx ring buffer
+    error = configureContinuousSampling(taskHandle, samplingRate, samplesPerChannel);
     if (error) 
     {
         DAQmxGetExtendedErrorInfo(errBuff, 2048);
-        DAQmxClearTask(readVoltageMod3Task);
-        throw std::runtime_error("Failed to set sample clock timing: " + std::string(errBuff));
-    } 
-    else 
+        appendCommentWithTimestamp(fileNamesContainer.QNiDaqWrapperLogFile,
+                                   "In\n"
+                                   "TaskHandle QNiDaqWrapper::createContinuousAnalogTask(NIDeviceModule *deviceModule)\n"
+                                   "Error: Failed to set sample clock timing for "+alias+"\n"+
+                                   std::string(errBuff));
+        handleErrorAndCleanTask(taskHandle);
+        throw std::runtime_error("Failed to configure timing: " + std::string(errBuff));
+    }
+
+    // Start the task once, blocks are then read back to back without restarting the acquisition
+    error = DAQmxStartTask(taskHandle);
+    if (error) 
     {
-        std::cout << "OverSampling hack applied with success." << std::endl;
+        DAQmxGetExtendedErrorInfo(errBuff, 2048);
+        appendCommentWithTimestamp(fileNamesContainer.QNiDaqWrapperLogFile,
+                                   "In\n"
+                                   "TaskHandle QNiDaqWrapper::createContinuousAnalogTask(NIDeviceModule *deviceModule)\n"
+                                   "Error: Failed to start task for "+alias+"\n"+
+                                   std::string(errBuff));
+        handleErrorAndCleanTask(taskHandle);
+        throw std::runtime_error("Failed to start task: " + std::string(errBuff));
     }
-    
+
+    return taskHandle;
 }
 
-void QNiDaqWrapper::averageWindow(std::vector<double> &averages, const std::vector<double> &oldValues)
+bool QNiDaqWrapper::readAnalogBlock(TaskHandle taskHandle, NIDeviceModule *deviceModule, std::vector<double> &dataBuffer)
 {
-    for (size_t i = 0; i < averages.size(); ++i) 
+    int32 read = 0;
+    const int32 samplesPerChannel = static_cast<int32>(deviceModule->getSamplesPerChannel());
+
+    // Read the next block of samples from all channels, blocks until the hardware has produced it
+    int32 error = DAQmxReadAnalogF64(taskHandle,
+                                     samplesPerChannel,
+                                     deviceModule->getAcquisitionTimeout(),
+                                     DAQmx_Val_GroupByChannel,
+                                     dataBuffer.data(),
+                                     static_cast<uInt32>(dataBuffer.size()),
+                                     &read,
+                                     NULL);
+    if (error) 
     {
-        averages[i] = (averages[i] + oldValues[i]) / 2.0;
+        if (recoverContinuousTask(taskHandle, error, deviceModule->getAlias()))
+        {
+            // The block is lost but the acquisition runs again, the caller will simply read the next one
+            return false;
+        }
+        char errBuff[2048] = {'\0'};
+        DAQmxGetExtendedErrorInfo(errBuff, 2048);
+        appendCommentWithTimestamp(fileNamesContainer.QNiDaqWrapperLogFile,
+                                   "In\n"
+                                   "bool QNiDaqWrapper::readAnalogBlock(TaskHandle taskHandle, NIDeviceModule *deviceModule, std::vector<double> &dataBuffer)\n"
+                                   "Error: Failed to read data on "+deviceModule->getAlias()+"\n"+
+                                   std::string(errBuff));
+        throw std::runtime_error("Failed to read data: " + std::string(errBuff));
     }
+    return (read == samplesPerChannel);
 }
 
-std::vector<double> QNiDaqWrapper::readMod3Samples(int32 channelsCount, int32 samplesPerChannel, float64 timeOut, bool &inError) 
+void QNiDaqWrapper::clearContinuousTask(TaskHandle &taskHandle)
 {
-    inError = false;
-    // Start the task to begin measuring
-    int32 error = DAQmxStartTask(readVoltageMod3Task);
-    if (error) 
+    if (taskHandle)
     {
-        inError = true;
-        char errBuff[2048];
-        DAQmxGetExtendedErrorInfo(errBuff, 2048);
-        DAQmxClearTask(readVoltageMod3Task);
-        throw std::runtime_error("Failed to start task: " + std::string(errBuff));
+        DAQmxStopTask(taskHandle);
+        DAQmxClearTask(taskHandle);
+        taskHandle = nullptr;
     }
+}
 
-    const int32 totalSamples = channelsCount * samplesPerChannel;
-    std::vector<double> dataBuffer(totalSamples);
+void QNiDaqWrapper::reduceAnalogBlock(NIDeviceModule *deviceModule, std::vector<double> &dataBuffer, std::vector<double> &averages, std::vector<double> &oldValues, LowPassFilterBank &filterBank, DspChain *dspChain, float deltaTime)
+{
+    const int32 channelsCount     = static_cast<int32>(averages.size());
+    const int32 samplesPerChannel = static_cast<int32>(deviceModule->getSamplesPerChannel());
 
-    // Read the samples from all channels into the buffer
-    error = DAQmxReadAnalogF64(readVoltageMod3Task, samplesPerChannel, timeOut, DAQmx_Val_GroupByChannel, dataBuffer.data(), totalSamples, nullptr, nullptr);
-    if (error) 
+    // A module with a [filters] chain only runs its own stages, the global filter switches do not apply to it
+    const bool useChain = (dspChain && !dspChain->isEmpty());
+    if (useChain)
     {
-        inError = true;
-        char errBuff[2048];
-        DAQmxGetExtendedErrorInfo(errBuff, 2048);
-        DAQmxClearTask(readVoltageMod3Task);
-        throw std::runtime_error("Failed to read data: " + std::string(errBuff));
+        dspChain->process(dataBuffer.data(), samplesPerChannel, averages.data());
+    }
+    else if (m_lowPassFilterActiv)
+    {
+        // The recurrence runs once per sample, its time step is the sample period (the block period only if the rate is unknown)
+        const double samplePeriod = (deviceModule->getSamplingRate() > 0.0) ? 1.0 / deviceModule->getSamplingRate() : deltaTime;
+        applyLowPassFilter(channelsCount, samplesPerChannel, dataBuffer, averages, filterBank, samplePeriod);
+    }
+    else
+    {
+        // Calculate averages for each channel this is where the oversampling results are made
+        blockChannelMeans(dataBuffer.data(), channelsCount, samplesPerChannel, averages.data());
     }
 
-    // Stop the task once the data is read
-    DAQmxStopTask(readVoltageMod3Task);
-
-    return dataBuffer;
+    finishReduction(deviceModule, averages, oldValues, useChain);
 }
 
-void QNiDaqWrapper::applyMod3LowPassFilter(const int32 channelsCount, const int32 samplesPerChannel, std::vector<double> &dataBuffer, std::vector<double> &averages, float deltaTime)
+void QNiDaqWrapper::finishReduction(NIDeviceModule *deviceModule, std::vector<double> &averages, std::vector<double> &oldValues, bool useChain)
 {
-     std::cout<<"apply low pass filter"<<std::endl;
-    // Filter the data for each channel
-    std::vector<double> filteredData(channelsCount * samplesPerChannel);
-    for (int channel = 0; channel < channelsCount; ++channel) 
-    {
-        // Extract samples for the current channel
-        std::vector<double> channelSamples(samplesPerChannel);
-        for (int sample = 0; sample < samplesPerChannel; ++sample) 
-        {
-            channelSamples[sample] = dataBuffer[channel * samplesPerChannel + sample];
-        }
-        // Apply the low-pass filter to the samples of the current channel
-        std::vector<double> filteredChannelSamples = lowPassFilterDatas(channelSamples, deltaTime, m_cutOffFrequency);
-        // Store the filtered samples back into the filteredData vector
-        for (int sample = 0; sample < samplesPerChannel; ++sample) 
+    // Voltages are oversampled, the average is rounded to the significant digits of the module
+    if (deviceModule->getModuleType() == isAnalogicInputVoltage)
+    {
+        for (size_t i = 0; i < averages.size(); ++i)
         {
-            filteredData[channel * samplesPerChannel + sample] = filteredChannelSamples[sample];
+            averages[i] = roundToNbSignificativDigits(averages[i], 4);
         }
     }
-    
-    for (int i = 0; i < channelsCount; ++i) 
+
+    if (useChain)
     {
-        double sum = 0.0;
-        for (int j = 0; j < samplesPerChannel; ++j) 
-        {
-            sum += filteredData[i * samplesPerChannel + j];
-        }
-        averages[i] = roundToNbSignificativDigits ((sum / samplesPerChannel),4);
+        return;
     }
 
+    if (m_rollingWindowFilterActiv && (oldValues.size()==averages.size()))
+    {
+        //this is a 2 point floating window average
+        averageWindow(averages, oldValues);
+    } 
 
+    if (m_rollingWindowFilterActiv) oldValues = averages;
 }
 
-void QNiDaqWrapper::readMod3()
+bool QNiDaqWrapper::getAnalogRawScaling(TaskHandle taskHandle, NIDeviceModule *deviceModule, RawAnalogBlock &rawBlock)
 {
-    auto lastCycleTime = std::chrono::steady_clock::now(); 
-
-    const char* deviceName = "Mod3";
-    TaskHandle taskHandle = readVoltageMod3Task;
-    const int32 channelsCount = 4;
-    const float64 minRange = 0.0, maxRange = 10.0;
-    const float64 timeout = 2.0; // Adjusted for longer reads
-    const int32 samplesPerChannel = 5581; // Number of samples to average, 5581 is prime, so it may help to filter both 50 hz and 60 hz power lines noise
-    std::vector<double> averages(channelsCount);
-    const float samplingRate = 50000.0f;
-
-    std::string fullChannelNames = std::string(deviceName) + "/ai0:" + std::to_string(channelsCount-1);
+    rawBlock.sampleBits = 0;
+    rawBlock.scaling.clear();
+    // The device polynomial gives volts, current modules would need their shunt on top: they stay on scaled reads
+    if (!taskHandle || !deviceModule || deviceModule->getModuleType() != isAnalogicInputVoltage)
+    {
+        return false;
+    }
 
-    std::string unicKey = "ReadVoltageMod3" + generate_hex(8);
-    if (taskHandle == nullptr)
+    const std::string alias = deviceModule->getAlias();
+    uInt32 sampleBits = 0;
+    for (const std::string &chanName : deviceModule->getChanNames())
     {
-        initMod3(deviceName, minRange, maxRange, samplesPerChannel, samplingRate, channelsCount); 
+        const std::string fullChannelName = alias + chanName;
+        uInt32 channelBits = 0;
+        float64 coefficients[8] = {0.0};
+        if (DAQmxGetAIRawSampSize(taskHandle, fullChannelName.c_str(), &channelBits) < 0 ||
+            DAQmxGetAIDevScalingCoeff(taskHandle, fullChannelName.c_str(), coefficients, 8) < 0)
+        {
+            char errBuff[2048] = {'\0'};
+            DAQmxGetExtendedErrorInfo(errBuff, 2048);
+            appendCommentWithTimestamp(fileNamesContainer.QNiDaqWrapperLogFile,
+                                       "In\n"
+                                       "bool QNiDaqWrapper::getAnalogRawScaling(TaskHandle taskHandle, NIDeviceModule *deviceModule, RawAnalogBlock &rawBlock)\n"
+                                       "Error: no raw format for "+fullChannelName+"\n"+
+                                       std::string(errBuff));
+            rawBlock.scaling.clear();
+            return false;
+        }
+        // Every channel of a task shares the same native format
+        if ((channelBits != 16 && channelBits != 32) || (sampleBits != 0 && channelBits != sampleBits))
+        {
+            rawBlock.scaling.clear();
+            return false;
+        }
+        sampleBits = channelBits;
+        size_t nbCoefficients = 8;
+        while (nbCoefficients > 1 && coefficients[nbCoefficients - 1] == 0.0) --nbCoefficients;
+        rawBlock.scaling.emplace_back(coefficients, coefficients + nbCoefficients);
     }
-    
-    while (true)
-    {
-
-           // Start measuring time
-           auto currentCycleTime = std::chrono::steady_clock::now();
-           auto start            = std::chrono::high_resolution_clock::now();
-           bool inError;
-           //Fill the raw data buffer with readed values
-           std::vector<double> dataBuffer = readMod3Samples(channelsCount,samplesPerChannel,timeout,inError);
-           if (!inError)
-           {
-                //post treatment
-                float deltaTime = std::chrono::duration<float>(currentCycleTime - lastCycleTime).count();
-                lastCycleTime = currentCycleTime;
-                
-                if (m_lowPassFilterActiv)
-                {
-                    std::cout<<"apply low pass filter"<<std::endl;
-                    applyMod3LowPassFilter(channelsCount,samplesPerChannel,dataBuffer,averages, deltaTime);
-              
-                }
-                else
-                {
-                    // Calculate averages for each channel this is where the oversampling results are made
-                    for (int i = 0; i < channelsCount; ++i) 
-                    {
-                        double sum = 0.0;
-                        for (int j = 0; j < samplesPerChannel; ++j) 
-                        {
-                            sum += dataBuffer[i * samplesPerChannel + j];
-                        }
-                        averages[i] = roundToNbSignificativDigits ((sum / samplesPerChannel),4);
-                    }
-                }
-           
-            if (m_rollingWindowFilterActiv && (Mod3OldValuesBuffer.size()==Mod3Buffer.size()) && (Mod3OldValuesBuffer.size()>0))
-            {
-                //this is a 2 point floating window average
-                averageWindow(averages,Mod3OldValuesBuffer);
-            } 
-        
 
+    const size_t blockSize = deviceModule->getChanNames().size() * deviceModule->getSamplesPerChannel();
+    rawBlock.sampleBits = sampleBits;
+    rawBlock.samples16.assign(sampleBits == 16 ? blockSize : 0, 0);
+    rawBlock.samples32.assign(sampleBits == 32 ? blockSize : 0, 0);
+    return sampleBits != 0;
+}
 
-            if (m_rollingWindowFilterActiv) Mod3OldValuesBuffer = Mod3Buffer.copy();
+bool QNiDaqWrapper::readAnalogBlockRaw(TaskHandle taskHandle, NIDeviceModule *deviceModule, RawAnalogBlock &rawBlock)
+{
+    int32 read = 0;
+    int32 error = 0;
+    const int32 samplesPerChannel = static_cast<int32>(deviceModule->getSamplesPerChannel());
 
-            // Use the averages to update the buffer instead
-            Mod3Buffer.restore(averages);
-            DAQmxStopTask(taskHandle);
-            auto stop = std::chrono::high_resolution_clock::now();
-            auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(stop - start);
-            std::cout << "Duration: " << duration.count() << "ms" << std::endl;
+    // Same blocking read as readAnalogBlock, the driver only skips the conversion to doubles
+    if (rawBlock.sampleBits == 16)
+    {
+        error = DAQmxReadBinaryI16(taskHandle, samplesPerChannel, deviceModule->getAcquisitionTimeout(), DAQmx_Val_GroupByChannel,
+                                   rawBlock.samples16.data(), static_cast<uInt32>(rawBlock.samples16.size()), &read, NULL);
+    }
+    else
+    {
+        error = DAQmxReadBinaryI32(taskHandle, samplesPerChannel, deviceModule->getAcquisitionTimeout(), DAQmx_Val_GroupByChannel,
+                                   rawBlock.samples32.data(), static_cast<uInt32>(rawBlock.samples32.size()), &read, NULL);
+    }
+    if (error)
+    {
+        if (recoverContinuousTask(taskHandle, error, deviceModule->getAlias()))
+        {
+            return false;
         }
+        char errBuff[2048] = {'\0'};
+        DAQmxGetExtendedErrorInfo(errBuff, 2048);
+        appendCommentWithTimestamp(fileNamesContainer.QNiDaqWrapperLogFile,
+                                   "In\n"
+                                   "bool QNiDaqWrapper::readAnalogBlockRaw(TaskHandle taskHandle, NIDeviceModule *deviceModule, RawAnalogBlock &rawBlock)\n"
+                                   "Error: Failed to read raw data on "+deviceModule->getAlias()+"\n"+
+                                   std::string(errBuff));
+        throw std::runtime_error("Failed to read raw data: " + std::string(errBuff));
     }
-    
+    return (read == samplesPerChannel);
 }
 
-
-
-void QNiDaqWrapper::readMod4()
+void QNiDaqWrapper::reduceRawAnalogBlock(NIDeviceModule *deviceModule, const RawAnalogBlock &rawBlock, std::vector<double> &dataBuffer, std::vector<double> &averages, std::vector<double> &oldValues, LowPassFilterBank &filterBank, DspChain *dspChain, float deltaTime)
 {
-    // Hardcoded device name for Mod1 module
-    const char* deviceName = "Mod4";
-    // Initialize task handle to 0, which will be used to identify our task with DAQmx functions
-    TaskHandle taskHandle = readCounterMod4Task;
-    // Error code returned by DAQmx functions
-    int32 error;
-    // Buffer for error information
-    char errBuff[2048] = {'\0'};
-    // Total number of channels to read from
-    const int32 countersCount = 4;
-    // Timeout for DAQmxReadAnalogF64 function in seconds
-    const float64 timeout = 0.1;
-    // We will request 2 samples per channel to meet minimum sample requirement but only use the last sample
-    const int32 samplesPerChannel = 1;
-    // Vector to store the last sample from each channel
-    std::vector<double> lastSamples(countersCount); 
-    int32 read;
-    // Construct full channel names for the device, spanning from /ai0 to /ai15
-    std::string fullChannelNames = std::string(deviceName) + "/ctr0:" + std::to_string(countersCount-1);
-
-    // Generate a unique task name using a helper function (assumed to be defined elsewhere)
-    std::string unicKey = "ReadCounterMod4" + generate_hex(8);
-    // Create a task
-    if (taskHandle == nullptr)
-    {
-         error = DAQmxCreateTask(unicKey.c_str(), &taskHandle);
-         if (error) 
-         {
-             DAQmxGetExtendedErrorInfo(errBuff, 2048);
-             throw std::runtime_error("Failed to create task: " + std::string(errBuff));
-         }
-     
-
-        // Create counters channels
-        error = DAQmxCreateCICountEdgesChan(taskHandle, fullChannelNames.c_str(), "", DAQmx_Val_Rising, 0, DAQmx_Val_CountUp);
-        if (error) 
-        {
-            std::cout<<"in read counter Failed to create counter channel: "<<fullChannelNames.c_str()<<std::endl;
-            char errBuff[2048];
-            DAQmxGetErrorString(error, errBuff, sizeof(errBuff));
-            appendCommentWithTimestamp(fileNamesContainer.QNiDaqWrapperLogFile,
-                                       "In\n"
-                                       "void QNiDaqWrapper::readMod4()\n"
-                                       "Failed to create counter channel. Error: " + std::string(errBuff));
-            handleErrorAndCleanTask(taskHandle);
-            taskHandle = nullptr; // Ensure the map entry is reset after cleanup
-            throw std::runtime_error("Failed to create counter channel.");
-        }
+    const size_t channelsCount     = averages.size();
+    const size_t samplesPerChannel = deviceModule->getSamplesPerChannel();
 
-         if (error) 
-         {
-             DAQmxGetExtendedErrorInfo(errBuff, 2048);
-             DAQmxClearTask(taskHandle);
-             throw std::runtime_error("Failed to create channels: " + std::string(errBuff));
-         }
-     
-         // Configure the sampling clock with a rate of 1000 Hz, finite samples, and rising edge timing
-        // Add sample clock timing configuration (NEW)
-        error = DAQmxCfgSampClkTiming(taskHandle, "", 1000.0, DAQmx_Val_Rising, DAQmx_Val_ContSamps, 1);
-        if (error) 
+    // Filters run on every sample in engineering units: the block is scaled once, then reduced as usual
+    if ((dspChain && !dspChain->isEmpty()) || m_lowPassFilterActiv)
+    {
+        for (size_t channel = 0; channel < channelsCount; ++channel)
         {
-            DAQmxGetExtendedErrorInfo(errBuff, 2048);
-            appendCommentWithTimestamp(fileNamesContainer.QNiDaqWrapperLogFile,
-                                       "In\n"
-                                       "double QNiDaqWrapper::readVoltage(NIDeviceModule *deviceModule, std::string chanName, unsigned int maxRetries)\n"
-                                       "Error: Failed to set sample clock timing.\n"+
-                                       std::string(errBuff));
-            handleErrorAndCleanTask(taskHandle);
-            throw std::runtime_error("Failed to set sample clock timing.");
+            const std::vector<double> &scaling = rawBlock.scaling[channel];
+            double *samples = dataBuffer.data() + channel * samplesPerChannel;
+            const size_t first = channel * samplesPerChannel;
+            for (size_t i = 0; i < samplesPerChannel; ++i)
+            {
+                const double code = (rawBlock.sampleBits == 16) ? rawBlock.samples16[first + i] : rawBlock.samples32[first + i];
+                samples[i] = evaluateScalingPolynomial(scaling, code);
+            }
         }
+        reduceAnalogBlock(deviceModule, dataBuffer, averages, oldValues, filterBank, dspChain, deltaTime);
+        return;
+    }
 
+    // Plain oversampling: exact integer sums, the polynomial is applied to the mean code only
+    // (identical to averaging scaled samples for the linear terms, the device higher terms are calibration trims)
+    for (size_t channel = 0; channel < channelsCount; ++channel)
+    {
+        const size_t first = channel * samplesPerChannel;
+        const int64_t sum  = (rawBlock.sampleBits == 16) ? blockSumInt16(rawBlock.samples16.data() + first, samplesPerChannel)
+                                                         : blockSumInt32(rawBlock.samples32.data() + first, samplesPerChannel);
+        const double meanCode = static_cast<double>(sum) / static_cast<double>(samplesPerChannel);
+        averages[channel] = evaluateScalingPolynomial(rawBlock.scaling[channel], meanCode);
     }
-    
-    while (true)
-    {
-        // Start the task to begin measuring
-         error = DAQmxStartTask(taskHandle);
-         if (error) 
-         {
-             DAQmxGetExtendedErrorInfo(errBuff, 2048);
-             DAQmxClearTask(taskHandle);
-             throw std::runtime_error("Failed to start task: " + std::string(errBuff));
-         }
-     
-         // Prepare a buffer to read the samples into, sized for all channels and samples
-         std::vector<uInt32> dataBuffer(countersCount * samplesPerChannel);
-         // Read the samples from all channels into the buffer
-         error = DAQmxReadCounterU32(taskHandle, samplesPerChannel, timeout, dataBuffer.data(), static_cast<uInt32>(dataBuffer.size()), &read, NULL);
-         if (error) 
-         {
-             DAQmxGetExtendedErrorInfo(errBuff, 2048);
-             DAQmxClearTask(taskHandle);
-             throw std::runtime_error("Failed to read data: " + std::string(errBuff));
-         }
-
-
-        Mod4Buffer.restore(dataBuffer);
-        DAQmxStopTask(taskHandle);
+    finishReduction(deviceModule, averages, oldValues, false);
+}
+
+void QNiDaqWrapper::averageWindow(std::vector<double> &averages, const std::vector<double> &oldValues)
+{
+    for (size_t i = 0; i < averages.size(); ++i) 
+    {
+        averages[i] = (averages[i] + oldValues[i]) / 2.0;
+    }
+}
+
+
+void QNiDaqWrapper::applyLowPassFilter(const int32 channelsCount, const int32 samplesPerChannel, std::vector<double> &dataBuffer, std::vector<double> &averages, LowPassFilterBank &filterBank, double samplePeriod)
+{
+    if (filterBank.getNbChannels() != static_cast<size_t>(channelsCount))
+    {
+        filterBank.resize(channelsCount);
     }
+    // Only recomputes the coefficients if the cut-off frequency or the sampling rate changed
+    filterBank.reconfigure(samplePeriod, m_cutOffFrequency);
+    // Each channel is filtered in place with its own state, the block is overwritten by the next read anyway
+    filterBank.filterBlock(dataBuffer.data(), samplesPerChannel);
+    blockChannelMeans(dataBuffer.data(), channelsCount, samplesPerChannel, averages.data());
 }
 
 double QNiDaqWrapper::readCurrent(NIDeviceModule *deviceModule, unsigned int chanIndex, unsigned int maxRetries, bool autoConvertTomAmps)
@@ -1656,12 +1328,7 @@ double QNiDaqWrapper::readVoltage(NIDeviceModule *deviceModule, std::string chan
 
         // Compute the average of the read samples
         std::cout<<std::endl<<"nb samples:"<<std::to_string(read)<<std::endl;
-        double sum = 0;
-        for (int i = 0; i < read; ++i)
-        {
-            sum += data[i];
-        }
-        double average = sum / read; // Ensure division by the actual number of read samples
+        double average = blockMean(data, read); // Ensure division by the actual number of read samples
 
         // Stop and clear the task after successful read operation
         DAQmxStopTask(taskHandle);
@@ -2059,6 +1726,20 @@ unsigned int QNiDaqWrapper::readCounter(NIDeviceModule *deviceModule, std::strin
         throw std::invalid_argument("readCounter: deviceModule is null.");
     }
 
+    // When the counter already belongs to a batched group (see readCounters) the group task owns it
+    auto groupIter = counterGroupsMap.find(deviceModule->getAlias());
+    if (groupIter != counterGroupsMap.end())
+    {
+        const std::vector<std::string> &groupChanNames = groupIter->second.chanNames;
+        auto chanIter = std::find(groupChanNames.begin(), groupChanNames.end(), chanName);
+        if (chanIter != groupChanNames.end())
+        {
+            std::vector<uInt32> values;
+            readCounterGroup(groupIter->second, values);
+            return values[static_cast<size_t>(chanIter - groupChanNames.begin())];
+        }
+    }
+
     int index = extractNumberFromEnd(chanName);
     //const std::string fullChannelName = deviceModule->getAlias() + chanName;
     const std::string fullChannelName = deviceModule->getAlias() + "/ctr"+std::to_string(index);
@@ -2152,6 +1833,166 @@ unsigned int QNiDaqWrapper::readCounter(NIDeviceModule *deviceModule, std::strin
 }
 
 
+TaskHandle QNiDaqWrapper::createCounterTask(NIDeviceModule *deviceModule, const std::vector<std::string> &chanNames)
+{
+    TaskHandle taskHandle = nullptr;
+    std::string uniqueKey = "readCounters" + generate_hex(8);
+    int32 error = DAQmxCreateTask(uniqueKey.c_str(), &taskHandle);
+    if (error)
+    {
+        char errBuff[2048] = {'\0'};
+        DAQmxGetErrorString(error, errBuff, sizeof(errBuff));
+        appendCommentWithTimestamp(fileNamesContainer.QNiDaqWrapperLogFile,
+                                   "In\n"
+                                   "TaskHandle QNiDaqWrapper::createCounterTask(NIDeviceModule *deviceModule, const std::vector<std::string> &chanNames)\n"
+                                   "Error: Failed to create DAQmx task. Error: " + std::string(errBuff));
+        return nullptr;
+    }
+
+    // One count edges channel per requested front terminal, created in the order of chanNames
+    // so that the values read back from the task line up with the caller's vector
+    for (const std::string &chanName : chanNames)
+    {
+        const std::string fullChannelName = deviceModule->getAlias() + "/ctr" + std::to_string(extractNumberFromEnd(chanName));
+        error = DAQmxCreateCICountEdgesChan(taskHandle, fullChannelName.c_str(), "", DAQmx_Val_Rising, 0, DAQmx_Val_CountUp);
+        if (!error)
+        {
+            error = DAQmxSetCICountEdgesTerm(taskHandle, fullChannelName.c_str(), chanName.c_str());
+        }
+        if (error)
+        {
+            char errBuff[2048] = {'\0'};
+            DAQmxGetErrorString(error, errBuff, sizeof(errBuff));
+            appendCommentWithTimestamp(fileNamesContainer.QNiDaqWrapperLogFile,
+                                       "In\n"
+                                       "TaskHandle QNiDaqWrapper::createCounterTask(NIDeviceModule *deviceModule, const std::vector<std::string> &chanNames)\n"
+                                       "Failed to create counter channel "+fullChannelName+" on "+chanName+". Error: " + std::string(errBuff));
+            DAQmxClearTask(taskHandle);
+            return nullptr;
+        }
+    }
+
+    error = DAQmxStartTask(taskHandle);
+    if (error)
+    {
+        char errBuff[2048] = {'\0'};
+        DAQmxGetErrorString(error, errBuff, sizeof(errBuff));
+        appendCommentWithTimestamp(fileNamesContainer.QNiDaqWrapperLogFile,
+                                   "In\n"
+                                   "TaskHandle QNiDaqWrapper::createCounterTask(NIDeviceModule *deviceModule, const std::vector<std::string> &chanNames)\n"
+                                   "Failed to start counter task. Error: " + std::string(errBuff));
+        DAQmxClearTask(taskHandle);
+        return nullptr;
+    }
+    return taskHandle;
+}
+
+void QNiDaqWrapper::clearCounterGroup(CounterGroupTasks &group)
+{
+    if (group.sharedTask)
+    {
+        DAQmxStopTask(group.sharedTask);
+        DAQmxClearTask(group.sharedTask);
+        group.sharedTask = nullptr;
+    }
+    for (TaskHandle &taskHandle : group.channelTasks)
+    {
+        if (taskHandle)
+        {
+            DAQmxStopTask(taskHandle);
+            DAQmxClearTask(taskHandle);
+            taskHandle = nullptr;
+        }
+    }
+    group.channelTasks.clear();
+    group.chanNames.clear();
+}
+
+bool QNiDaqWrapper::readCounterGroup(CounterGroupTasks &group, std::vector<uInt32> &values)
+{
+    const uInt32 channelsCount = static_cast<uInt32>(group.chanNames.size());
+    values.assign(channelsCount, 0);
+    int32 error = 0;
+    if (group.sharedTask)
+    {
+        // On demand read of every counter of the module in a single driver call
+        int32 sampsPerChanRead = 0;
+        error = DAQmxReadCounterU32Ex(group.sharedTask, 1, 10.0, DAQmx_Val_GroupByChannel, values.data(), channelsCount, &sampsPerChanRead, nullptr);
+    }
+    else
+    {
+        for (uInt32 i = 0; i < channelsCount && !error; ++i)
+        {
+            error = DAQmxReadCounterScalarU32(group.channelTasks[i], 10.0, &values[i], nullptr);
+        }
+    }
+    if (error)
+    {
+        char errBuff[2048] = {'\0'};
+        DAQmxGetErrorString(error, errBuff, sizeof(errBuff));
+        appendCommentWithTimestamp(fileNamesContainer.QNiDaqWrapperLogFile,
+                                   "In\n"
+                                   "bool QNiDaqWrapper::readCounterGroup(CounterGroupTasks &group, std::vector<uInt32> &values)\n"
+                                   "Error: Failed to read counter values. Error: " + std::string(errBuff));
+        return false;
+    }
+    return true;
+}
+
+bool QNiDaqWrapper::readCounters(NIDeviceModule *deviceModule, const std::vector<std::string> &chanNames, std::vector<uInt32> &values)
+{
+    std::lock_guard<std::mutex> lock(countersMutex);
+    if (!deviceModule)
+    {
+        appendCommentWithTimestamp(fileNamesContainer.QNiDaqWrapperLogFile,
+                                   "In\n"
+                                   "bool QNiDaqWrapper::readCounters(NIDeviceModule *deviceModule, const std::vector<std::string> &chanNames, std::vector<uInt32> &values)\n"
+                                   "Error: deviceModule is null.");
+        throw std::invalid_argument("readCounters: deviceModule is null.");
+    }
+
+    CounterGroupTasks &group = counterGroupsMap[deviceModule->getAlias()];
+    if (group.chanNames != chanNames)
+    {
+        clearCounterGroup(group);
+        // A counter can only be reserved by one task at a time: release the single channel tasks
+        // opened by readCounter(deviceModule, chanName) for the same terminals
+        for (const std::string &chanName : chanNames)
+        {
+            auto taskIter = counterTasksMap.find(chanName);
+            if (taskIter != counterTasksMap.end())
+            {
+                if (taskIter->second)
+                {
+                    DAQmxStopTask(taskIter->second);
+                    DAQmxClearTask(taskIter->second);
+                }
+                counterTasksMap.erase(taskIter);
+            }
+        }
+
+        // Prefer one task holding every counter of the module, C Series counter modules that refuse
+        // several counter channels in the same task fall back to one started task per counter
+        group.sharedTask = createCounterTask(deviceModule, chanNames);
+        if (!group.sharedTask)
+        {
+            for (const std::string &chanName : chanNames)
+            {
+                TaskHandle taskHandle = createCounterTask(deviceModule, std::vector<std::string>(1, chanName));
+                if (!taskHandle)
+                {
+                    clearCounterGroup(group);
+                    throw std::runtime_error("Failed to create counter task for " + deviceModule->getAlias() + "/" + chanName);
+                }
+                group.channelTasks.push_back(taskHandle);
+            }
+        }
+        group.chanNames = chanNames;
+    }
+    return readCounterGroup(group, values);
+}
+
+
 /*unsigned int QNiDaqWrapper::testReadCounter()
 {
     const std::string fullChannelName = "Mod4/ctr0";
@@ -2386,139 +2227,238 @@ void QNiDaqWrapper::testSetRelayState(unsigned int relayIndex, const bool &state
 
 void QNiDaqWrapper::setRelayState(NIDeviceModule *deviceModule, unsigned int chanIndex, const bool &state) 
 {
-    std::lock_guard<std::mutex> lock(alarmsMutex);
     if (!deviceModule) {
         throw std::invalid_argument("deviceModule is null");
     }
+    // Same persistent port task as the named overload
+    setRelayState(deviceModule, deviceModule->getChanNames().at(chanIndex), state);
+}
 
-    // Construct the channel name using the index
-    const char* deviceName   = deviceModule->getAlias().c_str();
-    const char* channelName  = deviceModule->getChanNames()[chanIndex].c_str();
-    std::string fullChanName = std::string(deviceName) + channelName;
-    //initialize an handle for the task
-    TaskHandle taskHandle = 0;
-    int32      error;
-    // Unique task name for setting relay state
-    std::string uniqueKey = "setRelayState" + generate_hex(8);
-    error = DAQmxCreateTask(uniqueKey.c_str(), &taskHandle);
-    if (error) {
-        handleErrorAndCleanTask(taskHandle);
-        throw std::runtime_error("Failed to create task for setting relay state.");
-    }
 
-    // Create a digital output channel for the specific relay
-    error = DAQmxCreateDOChan(taskHandle, fullChanName.c_str(), "", DAQmx_Val_ChanForAllLines);
-    if (error) {
-        handleErrorAndCleanTask(taskHandle);
-        throw std::runtime_error("Failed to create digital output channel for relay.");
+void QNiDaqWrapper::setRelayState(NIDeviceModule *deviceModule, const std::string &chanName, const bool &state)
+{
+    std::lock_guard<std::mutex> lock(alarmsMutex);
+    if (!deviceModule) 
+    {
+        appendCommentWithTimestamp(fileNamesContainer.QNiDaqWrapperLogFile,
+                                   "In\n"
+                                   "void QNiDaqWrapper::setRelayState(NIDeviceModule *deviceModule, const std::string &chanName, const bool &state)\n"
+                                   "Error:  deviceModule is nullptr");
+        throw std::invalid_argument("deviceModule is null");
     }
 
-    // Start the task to apply the configuration
-    error = DAQmxStartTask(taskHandle);
-    if (error) {
-        handleErrorAndCleanTask(taskHandle);
-        throw std::runtime_error("Failed to start task for setting relay state.");
+    // "/port0/line2" -> port "/port0", line 2
+    std::string portName;
+    unsigned int line = 0;
+    if (!splitRelayLine(chanName, portName, line))
+    {
+        appendCommentWithTimestamp(fileNamesContainer.QNiDaqWrapperLogFile,
+                                   "In\n"
+                                   "void QNiDaqWrapper::setRelayState(NIDeviceModule *deviceModule, const std::string &chanName, const bool &state)\n"
+                                   "Error:  not a digital output line: "+chanName);
+        throw std::invalid_argument("Not a digital output line: " + chanName);
     }
 
-    // Data to write: 1 for ON, 0 for OFF
-    uInt8 data = state ? 1 : 0;
-    int32 written;
-
-    // Write the state to the digital output channel
-    error = DAQmxWriteDigitalLines(taskHandle, 1, true, 10.0, DAQmx_Val_GroupByChannel, &data, &written, NULL);
-    if (error) {
-        handleErrorAndCleanTask(taskHandle);
-        throw std::runtime_error("Failed to write relay state.");
+    DigitalOutputPortTask &port = getDigitalOutputPortTask(deviceModule, portName);
+    if (line >= port.lineStates.size())
+    {
+        appendCommentWithTimestamp(fileNamesContainer.QNiDaqWrapperLogFile,
+                                   "In\n"
+                                   "void QNiDaqWrapper::setRelayState(NIDeviceModule *deviceModule, const std::string &chanName, const bool &state)\n"
+                                   "Error:  line out of range: "+deviceModule->getAlias()+chanName);
+        throw std::out_of_range("Digital output line out of range: " + chanName);
     }
 
-    // Clean up the task after setting the state
-    DAQmxClearTask(taskHandle);
+    // A single write on the already running task, the shadow of the port follows once it succeeded
+    std::vector<uInt8> newLineStates = port.lineStates;
+    newLineStates[line] = state ? 1 : 0;
+    writeDigitalOutputPort(deviceModule->getAlias() + portName, port, newLineStates);
 }
 
 
-void QNiDaqWrapper::setRelayState(NIDeviceModule *deviceModule, const std::string &chanName, const bool &state)
+void QNiDaqWrapper::setRelayStates(NIDeviceModule *deviceModule, const std::vector<std::pair<std::string, bool>> &lineStates)
 {
     std::lock_guard<std::mutex> lock(alarmsMutex);
     if (!deviceModule) 
     {
         appendCommentWithTimestamp(fileNamesContainer.QNiDaqWrapperLogFile,
                                    "In\n"
-                                   "void QNiDaqWrapper::setRelayState(NIDeviceModule *deviceModule, const std::string &chanName, const bool &state)\n"
+                                   "void QNiDaqWrapper::setRelayStates(NIDeviceModule *deviceModule, const std::vector<std::pair<std::string, bool>> &lineStates)\n"
                                    "Error:  deviceModule is nullptr");
         throw std::invalid_argument("deviceModule is null");
     }
 
+    // First pass: the new states of every touched port, in request order. The shadows are left as they are
+    std::vector<std::pair<std::string, std::vector<uInt8>>> touchedPorts;
+    std::string failedPorts;
+    for (const std::pair<std::string, bool> &lineState : lineStates)
+    {
+        std::string portName;
+        unsigned int line = 0;
+        if (!splitRelayLine(lineState.first, portName, line))
+        {
+            appendCommentWithTimestamp(fileNamesContainer.QNiDaqWrapperLogFile,
+                                       "In\n"
+                                       "void QNiDaqWrapper::setRelayStates(NIDeviceModule *deviceModule, const std::vector<std::pair<std::string, bool>> &lineStates)\n"
+                                       "Error:  not a digital output line, ignored: "+lineState.first);
+            continue;
+        }
+        auto touched = std::find_if(touchedPorts.begin(), touchedPorts.end(),
+                                    [&portName](const std::pair<std::string, std::vector<uInt8>> &port) { return port.first == portName; });
+        if (touched == touchedPorts.end())
+        {
+            try
+            {
+                DigitalOutputPortTask &port = getDigitalOutputPortTask(deviceModule, portName);
+                touchedPorts.emplace_back(portName, port.lineStates);
+                touched = touchedPorts.end() - 1;
+            }
+            catch (const std::exception &)
+            {
+                // Already logged, the lines of the other ports are still written
+                failedPorts += " " + deviceModule->getAlias() + portName;
+                continue;
+            }
+        }
+        if (line >= touched->second.size())
+        {
+            appendCommentWithTimestamp(fileNamesContainer.QNiDaqWrapperLogFile,
+                                       "In\n"
+                                       "void QNiDaqWrapper::setRelayStates(NIDeviceModule *deviceModule, const std::vector<std::pair<std::string, bool>> &lineStates)\n"
+                                       "Error:  line out of range, ignored: "+deviceModule->getAlias()+lineState.first);
+            continue;
+        }
+        touched->second[line] = lineState.second ? 1 : 0;
+    }
 
-    char errBuff[2048] = {'\0'};
+    // Second pass: one write per port, whatever the number of lines changed on it.
+    // A failed port keeps its shadow and does not stop the writes of the following ones
+    for (const std::pair<std::string, std::vector<uInt8>> &touched : touchedPorts)
+    {
+        const std::string fullPortName = deviceModule->getAlias() + touched.first;
+        try
+        {
+            writeDigitalOutputPort(fullPortName, digitalOutputPortsMap[fullPortName], touched.second);
+        }
+        catch (const std::exception &)
+        {
+            failedPorts += " " + fullPortName;
+        }
+    }
+
+    if (!failedPorts.empty())
+    {
+        appendCommentWithTimestamp(fileNamesContainer.QNiDaqWrapperLogFile,
+                                   "In\n"
+                                   "void QNiDaqWrapper::setRelayStates(NIDeviceModule *deviceModule, const std::vector<std::pair<std::string, bool>> &lineStates)\n"
+                                   "Error:  relay states not applied on:"+failedPorts);
+        throw std::runtime_error("Failed to set relay states on:" + failedPorts);
+    }
+}
 
 
-    TaskHandle taskHandle = 0;
-    int32 error;
+bool QNiDaqWrapper::splitRelayLine(const std::string &chanName, std::string &portName, unsigned int &line)
+{
+    const std::string::size_type linePos = chanName.find("/line");
+    if (linePos == std::string::npos || linePos + 5 >= chanName.size())
+    {
+        return false;
+    }
+    portName = chanName.substr(0, linePos);
+    line     = static_cast<unsigned int>(extractNumberFromEnd(chanName));
+    return true;
+}
 
-    // Construct the full channel name including the device alias
-    std::string fullChanName = deviceModule->getAlias() + chanName.c_str();
 
-    // Create a new task for setting the relay state
-    std::string uniqueKey = "setRelayState" + generate_hex(8);
-    error = DAQmxCreateTask(uniqueKey.c_str(), &taskHandle);
-    if (error) 
-    {   
-        DAQmxGetExtendedErrorInfo(errBuff, 2048);
-        appendCommentWithTimestamp(fileNamesContainer.QNiDaqWrapperLogFile,
-                                   "In\n"
-                                   "void QNiDaqWrapper::setRelayState(NIDeviceModule *deviceModule, const std::string &chanName, const bool &state)\n"
-                                   "Error:  Failed to create task for setting relay state.\n"+
-                                   std::string(errBuff));
-        handleErrorAndCleanTask(taskHandle);
-        throw std::runtime_error("Failed to create task for setting relay state.");
+DigitalOutputPortTask& QNiDaqWrapper::getDigitalOutputPortTask(NIDeviceModule *deviceModule, const std::string &portName)
+{
+    const std::string fullPortName = deviceModule->getAlias() + portName;
+    DigitalOutputPortTask &port = digitalOutputPortsMap[fullPortName];
+    if (port.taskHandle)
+    {
+        return port;
     }
 
-    // Create a digital output channel
-    error = DAQmxCreateDOChan(taskHandle, fullChanName.c_str(), "", DAQmx_Val_ChanPerLine);
-    if (error) 
+    char errBuff[2048] = {'\0'};
+    std::string uniqueKey = "relayPort" + generate_hex(8);
+    int32 error = DAQmxCreateTask(uniqueKey.c_str(), &port.taskHandle);
+    if (!error)
+    {
+        // One channel for every line of the port, a write always carries the whole port
+        error = DAQmxCreateDOChan(port.taskHandle, fullPortName.c_str(), "", DAQmx_Val_ChanForAllLines);
+    }
+    uInt32 linesCount = 0;
+    if (!error)
+    {
+        error = DAQmxGetDONumLines(port.taskHandle, "", &linesCount);
+    }
+    if (!error)
+    {
+        // Reserve and program the hardware now so that writes do not pay for it
+        error = DAQmxTaskControl(port.taskHandle, DAQmx_Val_Task_Commit);
+    }
+    if (error)
     {
         DAQmxGetExtendedErrorInfo(errBuff, 2048);
         appendCommentWithTimestamp(fileNamesContainer.QNiDaqWrapperLogFile,
                                    "In\n"
-                                   "void QNiDaqWrapper::setRelayState(NIDeviceModule *deviceModule, const std::string &chanName, const bool &state)\n"
-                                   "Error:  Failed to create digital output channel.\n"+
+                                   "DigitalOutputPortTask& QNiDaqWrapper::getDigitalOutputPortTask(NIDeviceModule *deviceModule, const std::string &portName)\n"
+                                   "Error:  Failed to create digital output task for "+fullPortName+"\n"+
                                    std::string(errBuff));
-        handleErrorAndCleanTask(taskHandle);
-        throw std::runtime_error("Failed to create digital output channel.");
+        handleErrorAndCleanTask(port.taskHandle);
+        digitalOutputPortsMap.erase(fullPortName);
+        throw std::runtime_error("Failed to create digital output task for " + fullPortName);
+    }
+
+    // Start from the current output state so that the first write does not flip the other relays,
+    // modules without read back start with every line off
+    port.lineStates.assign(linesCount, 0);
+    int32 sampsPerChanRead = 0;
+    int32 numBytesPerSamp  = 0;
+    error = DAQmxReadDigitalLines(port.taskHandle, 1, 1.0, DAQmx_Val_GroupByChannel, port.lineStates.data(),
+                                  linesCount, &sampsPerChanRead, &numBytesPerSamp, nullptr);
+    if (error)
+    {
+        port.lineStates.assign(linesCount, 0);
     }
 
-    // Start the task
-    error = DAQmxStartTask(taskHandle);
-    if (error) 
+    error = DAQmxStartTask(port.taskHandle);
+    if (error)
     {
         DAQmxGetExtendedErrorInfo(errBuff, 2048);
         appendCommentWithTimestamp(fileNamesContainer.QNiDaqWrapperLogFile,
                                    "In\n"
-                                   "void QNiDaqWrapper::setRelayState(NIDeviceModule *deviceModule, const std::string &chanName, const bool &state)\n"
-                                   "Error:  Failed to start task.\n"+
+                                   "DigitalOutputPortTask& QNiDaqWrapper::getDigitalOutputPortTask(NIDeviceModule *deviceModule, const std::string &portName)\n"
+                                   "Error:  Failed to start digital output task for "+fullPortName+"\n"+
                                    std::string(errBuff));
-        handleErrorAndCleanTask(taskHandle);
-        throw std::runtime_error("Failed to start task.");
+        handleErrorAndCleanTask(port.taskHandle);
+        digitalOutputPortsMap.erase(fullPortName);
+        throw std::runtime_error("Failed to start digital output task for " + fullPortName);
     }
+    return port;
+}
 
-    // Write the relay state to the channel
-    uInt8 data = state ? 1 : 0; // Convert boolean state to uInt8
-    int32 written;
-    error = DAQmxWriteDigitalLines(taskHandle, 1, 1, 10.0, DAQmx_Val_GroupByChannel, &data, &written, NULL);
+
+void QNiDaqWrapper::writeDigitalOutputPort(const std::string &fullPortName, DigitalOutputPortTask &port, const std::vector<uInt8> &lineStates)
+{
+    int32 written = 0;
+    int32 error = DAQmxWriteDigitalLines(port.taskHandle, 1, 1, 10.0, DAQmx_Val_GroupByChannel, lineStates.data(), &written, NULL);
     if (error) 
     {
+        char errBuff[2048] = {'\0'};
         DAQmxGetExtendedErrorInfo(errBuff, 2048);
         appendCommentWithTimestamp(fileNamesContainer.QNiDaqWrapperLogFile,
                                    "In\n"
-                                   "void QNiDaqWrapper::setRelayState(NIDeviceModule *deviceModule, const std::string &chanName, const bool &state)\n"
-                                   "Error:  Failed to set relay state.\n"+
+                                   "void QNiDaqWrapper::writeDigitalOutputPort(const std::string &fullPortName, DigitalOutputPortTask &port, const std::vector<uInt8> &lineStates)\n"
+                                   "Error:  Failed to set relay state on "+fullPortName+"\n"+
                                    std::string(errBuff));
-        handleErrorAndCleanTask(taskHandle);
+        // Drop the task, the next write recreates it
+        handleErrorAndCleanTask(port.taskHandle);
+        digitalOutputPortsMap.erase(fullPortName);
         throw std::runtime_error("Failed to set relay state.");
     }
-
-    // Clean up the task
-    DAQmxClearTask(taskHandle);
+    // Written: the shadow follows
+    port.lineStates = lineStates;
 }
 
 
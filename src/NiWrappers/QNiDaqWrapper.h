@@ -10,7 +10,8 @@
 #include <functional>
 #include <mutex>
 #include <atomic>
-#include "../Filters/LowPassFilter.h"
+#include "../Filters/LowPassFilterBank.h"
+#include "../Filters/DspChain.h"
 #include "../Conversions/convUtils.h"
 #include "../globals/globalEnumStructs.h"
 #include "../filesUtils/appendToFileHelper.h"
@@ -26,6 +27,21 @@
 
 class NIDeviceModule;
 
+//counter tasks of one module used by readCounters(): a single multi-channel task when the
+//hardware accepts it, otherwise one started task per counter
+struct CounterGroupTasks {
+    std::vector<std::string> chanNames;              //front terminals, in read order
+    TaskHandle               sharedTask = nullptr;   //every counter channel of the group
+    std::vector<TaskHandle>  channelTasks;           //fallback, one task per entry of chanNames
+};
+
+//persistent digital output task of one module port: created and committed on the first
+//write, every relay write then writes the whole port at once and updates lineStates once it succeeded
+struct DigitalOutputPortTask {
+    TaskHandle               taskHandle = nullptr;
+    std::vector<uInt8>       lineStates;             //last written state of each line of the port
+};
+
 class QNiDaqWrapper {
 public:
     QNiDaqWrapper();
@@ -36,31 +52,42 @@ public:
     double       readCurrent(NIDeviceModule *deviceModule, unsigned int chanIndex, unsigned int maxRetries, bool autoConvertTomAmps);
     double       readCurrent(NIDeviceModule *deviceModule, std::string  chanName, unsigned int maxRetries, bool autoConvertTomAmps);
     
-    void         readMod1();
-    void         readMod2();
-    void         initMod3(const std::string& deviceName,
-                          double minRange,
-                          double maxRange,
-                          int32 samplesPerChannel,
-                          double samplingRate,
-                          int32 channelsCount);
-    std::vector<double> readMod3Samples(int32 channelsCount,
-                                        int32 samplesPerChannel,
-                                        float64 timeOut,
-                                        bool &inError); 
-    void applyMod3LowPassFilter(const int32 channelsCount,
-                                const int32 samplesPerChannel,
-                                std::vector<double> &dataBuffer,
-                                std::vector<double> &averages,
-                                float deltaTime);
-    void                readMod3();
-    void                readMod4();
+    //continuous acquisition primitives, driven by the AcquisitionEngine (one worker per module)
+    TaskHandle   createContinuousAnalogTask(NIDeviceModule *deviceModule);
+    bool         readAnalogBlock           (TaskHandle taskHandle, NIDeviceModule *deviceModule, std::vector<double> &dataBuffer);
+    void         clearContinuousTask       (TaskHandle &taskHandle);
+    void         reduceAnalogBlock         (NIDeviceModule *deviceModule,
+                                            std::vector<double> &dataBuffer,
+                                            std::vector<double> &averages,
+                                            std::vector<double> &oldValues,
+                                            LowPassFilterBank &filterBank,
+                                            DspChain *dspChain,
+                                            float deltaTime);
+    //raw variant: native codes, scaled once per published value when no per sample filter runs
+    bool         getAnalogRawScaling       (TaskHandle taskHandle, NIDeviceModule *deviceModule, RawAnalogBlock &rawBlock);
+    bool         readAnalogBlockRaw        (TaskHandle taskHandle, NIDeviceModule *deviceModule, RawAnalogBlock &rawBlock);
+    void         reduceRawAnalogBlock      (NIDeviceModule *deviceModule,
+                                            const RawAnalogBlock &rawBlock,
+                                            std::vector<double> &dataBuffer,
+                                            std::vector<double> &averages,
+                                            std::vector<double> &oldValues,
+                                            LowPassFilterBank &filterBank,
+                                            DspChain *dspChain,
+                                            float deltaTime);
+    void         applyLowPassFilter        (const int32 channelsCount,
+                                            const int32 samplesPerChannel,
+                                            std::vector<double> &dataBuffer,
+                                            std::vector<double> &averages,
+                                            LowPassFilterBank &filterBank,
+                                            double samplePeriod);
 
     double       readVoltage(NIDeviceModule *deviceModule, unsigned int chanIndex, unsigned int maxRetries);
     double       readVoltage(NIDeviceModule *deviceModule, std::string  chanName , unsigned int maxRetries);
 
     unsigned int readCounter     (NIDeviceModule *deviceModule, unsigned int chanIndex, unsigned int maxRetries);
     unsigned int readCounter     (NIDeviceModule *deviceModule, std::string  chanName );
+    //reads every requested counter of a module in one pass, values follow the order of chanNames
+    bool         readCounters    (NIDeviceModule *deviceModule, const std::vector<std::string> &chanNames, std::vector<uInt32> &values);
     unsigned int testReadCounter1 ();
     unsigned int testReadCounter2 ();
     void         resetCounter    (NIDeviceModule *deviceModule, const unsigned int &index);
@@ -68,6 +95,8 @@ public:
 
     void         setRelayState     (NIDeviceModule* deviceModule, unsigned int chanIndex, const bool &state);
     void         setRelayState     (NIDeviceModule* deviceModule, const std::string& chanName, const bool &state);
+    //sets several lines of a module at once: one write per port however many lines it carries
+    void         setRelayStates    (NIDeviceModule* deviceModule, const std::vector<std::pair<std::string, bool>> &lineStates);
     void         testSetRelayState (unsigned int relayIndex, const bool &state); 
 
     void handleErrorAndCleanTask(TaskHandle taskHandle);
@@ -107,24 +136,31 @@ public:
     std::string generate_hex(const unsigned int len);
 
     std::atomic<bool> keepCurrentRunning{true}; // Control flag for the reading loop
-    ThreadSafeVector<double> Mod1Buffer;
-    std::vector<double> Mod1OldValuesBuffer;
-    ThreadSafeVector<double> Mod2Buffer;
-    std::vector<double> Mod2OldValuesBuffer;
-    ThreadSafeVector<double> Mod3Buffer;
-    std::vector<double> Mod3OldValuesBuffer;
-    ThreadSafeVector<uInt32> Mod4Buffer;
 
 protected:
 
-  std::vector<double> lowPassFilterDatas(const std::vector<double>& dataBuffer, float deltaTime, float cutOffFrequency);
   void averageWindow(std::vector<double>& averages, const std::vector<double>& oldValues);
+  //rounding and 2 point window shared by the scaled and the raw reductions
+  void finishReduction(NIDeviceModule *deviceModule, std::vector<double> &averages, std::vector<double> &oldValues, bool useChain);
+  //continuous acquisition helpers
+  int32 configureContinuousSampling  (TaskHandle taskHandle, float64 samplingRate, int32 samplesPerChannel);
+  bool  recoverContinuousTask        (TaskHandle taskHandle, int32 error, const std::string &deviceName);
+  //batched counter helpers, countersMutex must be held by the caller
+  TaskHandle createCounterTask       (NIDeviceModule *deviceModule, const std::vector<std::string> &chanNames);
+  void       clearCounterGroup       (CounterGroupTasks &group);
+  bool       readCounterGroup        (CounterGroupTasks &group, std::vector<uInt32> &values);
+  //persistent relay helpers, alarmsMutex must be held by the caller
+  bool                   splitRelayLine           (const std::string &chanName, std::string &portName, unsigned int &line);
+  DigitalOutputPortTask& getDigitalOutputPortTask (NIDeviceModule *deviceModule, const std::string &portName);
+  void                   writeDigitalOutputPort   (const std::string &fullPortName, DigitalOutputPortTask &port, const std::vector<uInt8> &lineStates);
   
 
   bool  m_lowPassFilterActiv       = false;
   bool  m_notchFilterActiv         = false;
   bool  m_rollingWindowFilterActiv = false;
   float m_cutOffFrequency          = 10.0f;
+  //number of acquisition blocks the DAQmx ring buffer can hold in continuous mode
+  static const uInt32 continuousBufferBlocks = 8;
 
     
 private:
@@ -137,11 +173,6 @@ private:
     TaskHandle counterHandle2 = nullptr;
 
     
-    TaskHandle readCurrentMod1Task = nullptr;
-    TaskHandle readCurrentMod2Task = nullptr;
-    TaskHandle readVoltageMod3Task = nullptr;
-    TaskHandle readCounterMod4Task = nullptr;
-    
     
     
     
@@ -149,10 +180,9 @@ private:
     std::atomic<double> m_lastSingleVoltageChannelValue;
     unsigned int m_lastSingleCounter             = 0;
     std::map<std::string, TaskHandle> counterTasksMap;
+    std::map<std::string, CounterGroupTasks> counterGroupsMap; //keyed by module alias
+    std::map<std::string, DigitalOutputPortTask> digitalOutputPortsMap; //keyed by module alias + port, e.g. "Mod6/port0"
     std::map<std::string, TaskHandle> currentTaskMap;
-
-
-    LowPassFilter lpf; 
 };
 
 
@@ -297,6 +297,66 @@ std::vector<std::string> QNiSysConfigWrapper::EnumerateCRIOPluggedModules() {
     return modules;
 }
 
+std::vector<std::string> QNiSysConfigWrapper::loadDescribedModules(const std::vector<DaqModuleDescription> &descriptions)
+{
+    std::vector<std::string> modules;
+    for (const DaqModuleDescription &description : descriptions)
+    {
+        std::string moduleInfo = description.productName +
+                                 "\n║ Slot: " + std::to_string(description.slotNb);
+        auto module = NIDeviceModuleFactory::createModule(description.productName);
+        if (!module)
+        {
+            moduleInfo += "\n║ Module inner definition not yet implemented";
+            modules.push_back(moduleInfo);
+            continue;
+        }
+        module->setSlotNb(description.slotNb);
+        //ini file of the slot if there is one, the module defaults otherwise
+        module->loadConfig();
+        if (description.hasSettings)
+        {
+            //what the backend delivers wins over the local ini file, e.g. a recording made with another configuration
+            module->setAlias            (description.alias);
+            module->setModuleType       (description.moduleType);
+            module->setNbChannel        (static_cast<unsigned int>(description.chanNames.size()));
+            module->setChanNames        (description.chanNames);
+            module->setChanMin          (description.chanMin);
+            module->setChanMax          (description.chanMax);
+            module->setSamplingRate     (description.samplingRate);
+            module->setSamplesPerChannel(description.samplesPerChannel);
+            module->setNbCounters       (static_cast<unsigned int>(description.counterNames.size()));
+            module->setCounterNames     (description.counterNames);
+            module->setNbDigitalOutputs (description.nbDigitalOutputs);
+        }
+        //no saveConfig here: nothing was read from the hardware that the ini file would miss
+        moduleList.push_back(module);
+
+        const ModuleType modType = module->getModuleType();
+        moduleInfo += "\n║ Alias: " + module->getAlias();
+        moduleInfo += (modType >= 0 && static_cast<size_t>(modType) < lookupModType.size()) ? lookupModType[modType] : std::string("\n║ type: Not recognized");
+        moduleInfo += "\n║ nb digital output: " + std::to_string(module->getNbDigitalOutputs()) +
+                      "\n║ nb channels: "       + std::to_string(module->getNbChannel()) +
+                      "\n║ nb counters: "       + std::to_string(module->getNbCounters());
+        for (const std::string &chanName : module->getChanNames())
+        {
+            moduleInfo += "\n║ ╬" + chanName;
+        }
+        for (const std::string &counterName : module->getCounterNames())
+        {
+            moduleInfo += "\n║ ╬" + counterName;
+        }
+        if (module->getSamplingRate() > 0.0)
+        {
+            moduleInfo += "\n║ Sampling rate     : " + std::to_string(module->getSamplingRate()) +
+                          "\n║ Samples per block : " + std::to_string(module->getSamplesPerChannel());
+        }
+        module->setModuleInfo(moduleInfo);
+        modules.push_back(moduleInfo);
+    }
+    return modules;
+}
+
 
  //   std::vector<std::string> QNiSysConfigWrapper::EnumerateCRIOPluggedModules() {
  //          std::vector<std::string>   modules;
@@ -20,6 +20,7 @@
 #include "../stringUtils/stringUtils.h"
 #include "../NiModulesDefinitions/NIDeviceModule.h"
 #include "../NiModulesDefinitions/NIDeviceModuleFactory.h"
+#include "../DaqBackends/daqBackend.h"
 
 
 class QNiSysConfigWrapper {
@@ -29,6 +30,9 @@ public:
 
     // Method to enumerate cRIO modules and their properties
     std::vector<std::string> EnumerateCRIOPluggedModules();
+    // Same module list built from a backend description (simulation, replay) when there is no cRIO to enumerate,
+    // the ini files are loaded but not saved back
+    std::vector<std::string> loadDescribedModules(const std::vector<DaqModuleDescription> &descriptions);
     NIDeviceModule * getModuleByIndex(size_t index);
     NIDeviceModule * getModuleBySlot(unsigned int slotNb);
     NIDeviceModule * getModuleByAlias(const std::string& alias);
@@ -454,7 +454,7 @@ std::string CrioSSLServer::parseRequest(const std::string& request, std::shared_
         }        
         try
         {
-            if (m_bridge->getSimulateTimer()->isActive()) 
+            if (m_bridge->isModbusSimulationActive()) 
             {
                 //simulation already avtive
                 return "ACK";
@@ -505,7 +505,7 @@ std::string CrioSSLServer::parseRequest(const std::string& request, std::shared_
         
         try
         {
-            if (m_bridge->getDataAcquTimer()->isActive()) 
+            if (m_bridge->isAcquisitionActive()) 
             {
                 return "ACK";
             }
@@ -230,7 +230,7 @@ std::string CrioTCPServer::parseRequest(const std::string& request)
         //broadCastStr("crio debug:\nstartModbusSimulation detected\nin std::string CrioTCPServer::parseRequest(const std::string& request)\n"); 
         try
         {
-            if (m_bridge->getSimulateTimer()->isActive()) 
+            if (m_bridge->isModbusSimulationActive()) 
             {
                 //broadCastStr("crio debug:\nsimulation timer already active\nin std::string CrioTCPServer::parseRequest(const std::string& request)\n"); 
                 //simulation already avtive
@@ -283,7 +283,7 @@ std::string CrioTCPServer::parseRequest(const std::string& request)
         
         try
         {
-            if (m_bridge->getDataAcquTimer()->isActive()) 
+            if (m_bridge->isAcquisitionActive()) 
             {
                 return "ACK";
             }
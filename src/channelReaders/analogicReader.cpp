@@ -76,67 +76,27 @@ void AnalogicReader::manualReadOneShot(const std::string &moduleAlias, const std
         return;
     }
 
-    // Getting the device module based on the alias
-    NIDeviceModule *deviceModule = m_sysConfig->getModuleByAlias(moduleAlias);
-    if (!deviceModule) 
+    // The latest values are published by the acquisition worker of the module,
+    // only acquired analogic modules own a store so no module lookup is needed
+    SeqlockFrameStore<double> *moduleStore = m_acquisitionEngine ? m_acquisitionEngine->getModuleStore(moduleAlias) : nullptr;
+    if (!moduleStore)
     {
         returnedValue = std::numeric_limits<double>::min();
         return;
     }
 
-    // Check the module type
-    ModuleType modType = deviceModule->getModuleType();
-    std::string modName = deviceModule->getAlias();
-
-    if (modType != isAnalogicInputCurrent && modType != isAnalogicInputVoltage) 
-    {
-        returnedValue = std::numeric_limits<double>::min();
-        return;
-    }
-    
-    std::vector<double> valueVector;
     double value = std::numeric_limits<double>::min(); // Initialize value
-    unsigned int index = 0;
     try {
-        // Reading the value based on module type
-        if (modType == isAnalogicInputCurrent) 
+        // The frame follows the order of the module channel names, fall back on the ai number otherwise
+        size_t index = 0;
+        if (!m_acquisitionEngine->findChannelIndex(moduleAlias, chanName, index))
         {
-            if (modName=="Mod1") 
-            {
-                valueVector = m_daqMx->Mod1Buffer.copy();
-            }
-            else if (modName=="Mod2")
-            {
-                valueVector = m_daqMx->Mod2Buffer.copy();
-            }
-            index = extractChanIndex(chanName);        
-            if (index < valueVector.size()) 
-            {
-                value = valueVector[index];
-            } 
-            else 
-            {
-                value = 0.0; // Set to NaN or another error-indicating value
-            }
-        } 
-        else 
-        { 
-            if (modName=="Mod3") 
-            {
-                valueVector = m_daqMx->Mod3Buffer.copy();
-                index = extractChanIndex(chanName);
-
-            }
-            
-            if (index < valueVector.size()) 
-            {
-                value = valueVector[index];
-            } 
-            else 
-            {
-                value = 0.0; // Set to NaN or another error-indicating value
-            }
-        
+            index = extractChanIndex(chanName);
+        }
+        // Lock free and allocation free single value read, no copy of the whole frame
+        if (!moduleStore->readValue(index, value)) 
+        {
+            value = 0.0; // Set to NaN or another error-indicating value
         }
 
         returnedValue = value;
@@ -149,3 +109,13 @@ void AnalogicReader::manualReadOneShot(const std::string &moduleAlias, const std
     }
 }
 //Patch chantier end:
+
+void AnalogicReader::setAcquisitionEngine(const std::shared_ptr<AcquisitionEngine> &newAcquisitionEngine)
+{
+    m_acquisitionEngine = newAcquisitionEngine;
+}
+
+std::shared_ptr<AcquisitionEngine> AnalogicReader::getAcquisitionEngine() const
+{
+    return m_acquisitionEngine;
+}
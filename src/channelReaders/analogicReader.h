@@ -2,6 +2,7 @@
 #define AnalogicReader_H
 
 #include "baseReader.h"
+#include "../Acquisition/acquisitionEngine.h"
 
 class AnalogicReader : public BaseReader {
 public:
@@ -13,8 +14,12 @@ public:
     void manualReadOneShot(const std::string &moduleAlias, const unsigned int &index, double &returnedValue)    override;
     void manualReadOneShot(const std::string &moduleAlias, const std::string  &chanName, double &returnedValue) override;
 
-    
-    // Add any additional member functions specific to DigitalReader here
+    // The continuous acquisition engine providing the latest values of each module
+    void setAcquisitionEngine(const std::shared_ptr<AcquisitionEngine> &newAcquisitionEngine);
+    std::shared_ptr<AcquisitionEngine> getAcquisitionEngine() const;
+
+private:
+    std::shared_ptr<AcquisitionEngine> m_acquisitionEngine = nullptr;
 };
 
 #endif // DigitalReader_H
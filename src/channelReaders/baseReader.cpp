@@ -7,6 +7,7 @@ BaseReader::BaseReader(std::shared_ptr<QNiSysConfigWrapper> aSysConfigInstance,
      //thread safe atomic variables
     m_sysConfig = aSysConfigInstance; //the object to handle Ni configuration via NiSysConfig API
     m_daqMx     = aDaqMxInstance;     //the object that handles IO operations withs the devices (crio and its modules)
+    m_daqBackend = std::make_shared<DaqmxBackend>(aDaqMxInstance); //replaced by setDaqBackend() when running on the simulator
     m_daqMx->channelCurrentDataReadySignal = std::bind(&BaseReader::onChannelDataReady, //Signal to Slot c++ style
                                               this,
                                               std::placeholders::_1,
@@ -67,6 +68,11 @@ std::shared_ptr<QNiDaqWrapper> BaseReader::getDaqMx() const
     return m_daqMx;
 }
 
+std::shared_ptr<DaqBackend> BaseReader::getDaqBackend() const
+{
+    return m_daqBackend;
+}
+
 //-------------- setters ----------
 
 void BaseReader::setSysConfig(const std::shared_ptr<QNiSysConfigWrapper> &newSysConfig)
@@ -86,3 +92,8 @@ void BaseReader::setDaqMx(const std::shared_ptr<QNiDaqWrapper> &newDaqMx)
         daqMxChangedSignal(m_daqMx, this);
     }
 }
+
+void BaseReader::setDaqBackend(const std::shared_ptr<DaqBackend> &newDaqBackend)
+{
+    m_daqBackend = newDaqBackend;
+}
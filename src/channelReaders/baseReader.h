@@ -10,6 +10,7 @@
 
 #include "../NiWrappers/QNiSysConfigWrapper.h"
 #include "../NiWrappers/QNiDaqWrapper.h"
+#include "../DaqBackends/daqmxBackend.h"
 #include "../NiModulesDefinitions/NIDeviceModule.h"
 #include "../stringUtils/stringUtils.h"
 #include "../threadSafeBuffers/threadSafeVector.h"
@@ -33,9 +34,11 @@ public:
     // Getters
     virtual std::shared_ptr<QNiSysConfigWrapper> getSysConfig() const;
     virtual std::shared_ptr<QNiDaqWrapper>       getDaqMx()     const;
+    virtual std::shared_ptr<DaqBackend>          getDaqBackend() const;
     // Setters
     virtual void setSysConfig(const std::shared_ptr<QNiSysConfigWrapper>& newSysConfig);
     virtual void setDaqMx    (const std::shared_ptr<QNiDaqWrapper>&       newDaqMx    );
+    virtual void setDaqBackend(const std::shared_ptr<DaqBackend>&         newDaqBackend);
     // Signals
     std::function<void(std::shared_ptr<QNiSysConfigWrapper>, BaseReader* sender)> sysConfigChangedSignal  = nullptr;
     std::function<void(std::shared_ptr<QNiDaqWrapper>,       BaseReader* sender)> daqMxChangedSignal      = nullptr;
@@ -44,6 +47,7 @@ public:
 protected:
     std::shared_ptr<QNiSysConfigWrapper> m_sysConfig        ; //wrapper around NiSysConfig
     std::shared_ptr<QNiDaqWrapper>       m_daqMx            ; //wrapper around NiDaqMx
+    std::shared_ptr<DaqBackend>          m_daqBackend       ; //hardware (or simulated) access for the batched reads, DAQmx by default
 
 
     char            m_manuallySelectedModuleName[256] = ""      ;
@@ -142,3 +142,32 @@ void DigitalReader::manualReadOneShot(const std::string &moduleAlias, const std:
     }
 }
 
+bool DigitalReader::readCounters(NIDeviceModule *deviceModule, const std::vector<std::string> &chanNames, std::vector<uint32_t> &values)
+{
+    if (!deviceModule || deviceModule->getModuleType() != ModuleType::isCounter)
+    {
+        appendCommentWithTimestamp(fileNamesContainer.digitalReaderLogFile,
+                                   "in\n"
+                                   "bool DigitalReader::readCounters(NIDeviceModule *deviceModule, const std::vector<std::string> &chanNames, std::vector<uint32_t> &values)\n"
+                                   "Error: deviceModule is nullptr or is not a counter module");
+        values.assign(chanNames.size(), 0);
+        return false;
+    }
+    try
+    {
+        std::vector<uInt32> counts;
+        bool ok = m_daqBackend->readCounters(deviceModule, chanNames, counts);
+        values.assign(counts.begin(), counts.end());
+        return ok;
+    }
+    catch (const std::exception& e)
+    {
+        appendCommentWithTimestamp(fileNamesContainer.digitalReaderLogFile,
+                                   "in\n"
+                                   "bool DigitalReader::readCounters(NIDeviceModule *deviceModule, const std::vector<std::string> &chanNames, std::vector<uint32_t> &values)\n"
+                                   "Error: reading counters failed\n"
+                                   "Exception:\n"+std::string(e.what()));
+        values.assign(chanNames.size(), 0);
+        return false;
+    }
+}
@@ -15,6 +15,9 @@ public:
     void manualReadOneShot(const std::string &moduleAlias, const unsigned int &index, double &returnedValue) override;
     void manualReadOneShot(const std::string &moduleAlias, const std::string  &chanName, double &returnedValue) override;
     
+    // Reads every listed counter of a counter module in one pass, values follow the order of chanNames
+    bool readCounters(NIDeviceModule *deviceModule, const std::vector<std::string> &chanNames, std::vector<uint32_t> &values);
+    
     // Add any additional member functions specific to DigitalReader here
 private:
     GlobalFileNamesContainer fileNamesContainer;
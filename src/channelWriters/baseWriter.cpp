@@ -7,6 +7,7 @@ BaseWriter::BaseWriter(std::shared_ptr<QNiSysConfigWrapper> aSysConfigInstance,
      //thread safe atomic variables
     m_sysConfig = aSysConfigInstance; //the object to handle Ni configuration via NiSysConfig API
     m_daqMx     = aDaqMxInstance;     //the object that handles IO operations withs the devices (crio and its modules)   
+    m_daqBackend = std::make_shared<DaqmxBackend>(aDaqMxInstance); //replaced by setDaqBackend() when running on the simulator
 }
 
 //---------- destructor -------------
@@ -46,6 +47,11 @@ std::shared_ptr<QNiDaqWrapper> BaseWriter::getDaqMx() const
     return m_daqMx;
 }
 
+std::shared_ptr<DaqBackend> BaseWriter::getDaqBackend() const
+{
+    return m_daqBackend;
+}
+
 //-------------- setters ----------
 
 void BaseWriter::setSysConfig(const std::shared_ptr<QNiSysConfigWrapper> &newSysConfig)
@@ -65,3 +71,8 @@ void BaseWriter::setDaqMx(const std::shared_ptr<QNiDaqWrapper> &newDaqMx)
         daqMxChangedSignal(m_daqMx, this);
     }
 }
+
+void BaseWriter::setDaqBackend(const std::shared_ptr<DaqBackend> &newDaqBackend)
+{
+    m_daqBackend = newDaqBackend;
+}
@@ -75,7 +75,7 @@ void DigitalWriter::manualSetOutput(const std::string &moduleAlias, const std::s
     { 
         try 
         {
-            m_daqMx->setRelayState(deviceModule,chanName,state);
+            m_daqBackend->setRelayStates(deviceModule, std::vector<std::pair<std::string, bool>>(1, std::make_pair(chanName, state)));
         } 
         catch (const std::exception& e)
         {
@@ -90,3 +90,38 @@ void DigitalWriter::manualSetOutput(const std::string &moduleAlias, const std::s
     //}
 }
 
+bool DigitalWriter::manualSetOutputs(const std::string &moduleAlias, const std::vector<std::pair<std::string, bool>> &lineStates)
+{
+    if (moduleAlias.empty() || lineStates.empty()) 
+    {
+        appendCommentWithTimestamp(fileNamesContainer.DigitalWriterLogFile,
+                                    "in\n"
+                                    "void DigitalWriter::manualSetOutputs(const std::string &moduleAlias, const std::vector<std::pair<std::string, bool>> &lineStates)\n"
+                                    "Error: moduleAlias or lineStates empty.\n"
+                                    "moduleAlias: "+ moduleAlias);
+        return false;
+    }
+    NIDeviceModule *deviceModule = m_sysConfig->getModuleByAlias(moduleAlias);
+    if (!deviceModule) 
+    {
+        appendCommentWithTimestamp(fileNamesContainer.DigitalWriterLogFile,
+                                    "in\n"
+                                    "void DigitalWriter::manualSetOutputs(const std::string &moduleAlias, const std::vector<std::pair<std::string, bool>> &lineStates)\n"
+                                    "Error: deviceModule is nullptr.");
+        std::cerr<<"manualSetOutputs Error: deviceModule is nullptr."<<std::endl;
+        return false;
+    }
+    try 
+    {
+        m_daqBackend->setRelayStates(deviceModule, lineStates);
+        return true;
+    } 
+    catch (const std::exception& e)
+    {
+        appendCommentWithTimestamp(fileNamesContainer.DigitalWriterLogFile,
+                                    "in\n"
+                                    "void DigitalWriter::manualSetOutputs(const std::string &moduleAlias, const std::vector<std::pair<std::string, bool>> &lineStates)\n"
+                                    "Exception:\n"+std::string(e.what()));
+        return false;
+    }
+}
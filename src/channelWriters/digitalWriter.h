@@ -14,6 +14,8 @@ public:
     // Override the pure virtual functions
     void manualSetOutput (const std::string &moduleAlias, const unsigned int &index,const bool &state) override;
     void manualSetOutput (const std::string &moduleAlias, const std::string  &chanName,const bool &state) override;
+    // Sets several lines of one module, each port of the module is written once. Returns false when the write failed (logged)
+    bool manualSetOutputs(const std::string &moduleAlias, const std::vector<std::pair<std::string, bool>> &lineStates);
     
 protected:
     GlobalFileNamesContainer fileNamesContainer;
@@ -2,5 +2,20 @@
 #define CONFIG_H
 
 #define CrossCompiled
+//acquisition, counters and relays go through the simulated DAQ backend instead of the modules
+//#define SimulatedDaq
+//every block, counter read and relay write of the backend above is recorded to the daqRecordFile
+//#define RecordDaq
+//the recording stops once it reaches one of these limits, 0 for no limit (a NI9239 at 50 kS/s records about 1.6 MB/s)
+#define RecordDaqMaxMegaBytes 512
+#define RecordDaqMaxSeconds   0
+//acquisition, counters and relays replay the daqRecordFile instead of the modules (takes precedence over SimulatedDaq)
+//#define ReplayDaq
+//replay as fast as the consumers allow instead of the recorded speed, and loop at the end of the recording
+//#define ReplayDaqAsFastAsPossible
+//#define ReplayDaqLoop
+
+//analogic registers are updated as soon as their module publishes a frame instead of on the 125 ms bridge tick
+//#define EventDrivenBridge
 
 #endif 
\ No newline at end of file
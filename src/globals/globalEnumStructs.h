@@ -1,6 +1,10 @@
 #ifndef GLOBALENUMSTRUCTS_H
 #define GLOBALENUMSTRUCTS_H
 
+#include <chrono>
+#include <string>
+#include <vector>
+
 // Include the appropriate NIDAQmx.h based on whether it's a cross-compiled environment or not
 #include "../config.h"
 #ifdef CrossCompiled
@@ -27,6 +31,16 @@ enum ModuleType
     isCoder                = 5 
 };
 
+// Update rate group of a mapping.csv row (optional 10th column: fast, medium or slow, fast by default),
+// each group is published by its own bridge job with the period set in modbus.ini [rategroups]
+enum RateGroup
+{
+    fastRateGroup   = 0,
+    mediumRateGroup = 1,
+    slowRateGroup   = 2
+};
+const int rateGroupsCount = 3;
+
 // Enum for shunt locations in a module, including internal and external locations
 enum moduleShuntLocation
 {
@@ -125,6 +139,8 @@ struct MappingConfig {
     uint16_t minDest;         // Minimum value for the destination after mapping (e.g., in a control system or display)
     uint16_t maxDest;         // Maximum value for the destination after mapping
     int modbusChannel;        // Modbus channel number, if applicable (used in industrial communication protocols)
+    RateGroup rateGroup;      // How often the bridge publishes this row
+    float deadband;           // Optional 11th column: minimal change, in source units, before the register is republished
  //These are only for counters tracking, so they are not initialized by the csv files
     std::chrono::time_point<std::chrono::steady_clock> currentTime;  //when asking for counters this variable will be filled to help for frequency calculation
     std::chrono::time_point<std::chrono::steady_clock> previousTime; //when asking for counters this variable will keep track of the previous time , then we can calculate delta time
@@ -139,6 +155,8 @@ struct MappingConfig {
                       minDest       (0                                 ),
                       maxDest       (0                                 ),
                       modbusChannel (0                                 ), //Initialize the destination channel in modbus
+                      rateGroup     (fastRateGroup                     ), //Rows without rate group keep the fastest tick
+                      deadband      (0.0f                              ), //Every change is published by default
                       currentTime(std::chrono::steady_clock::now()), // Initialize to current time
                       previousTime(std::chrono::steady_clock::now()), // Initialize to current time, will be updated on first use
                       currentCounterValue(0), // Initialize to zero, will be updated on first read
@@ -162,6 +180,45 @@ struct MappingConfig {
                                 {}  
     };
 
+    // Per channel processing chain of an analogic module, from the optional [filters] section of its ini file.
+    // A chain is a comma separated list of stages run in order on every acquired block:
+    // notch, lowpass, decimate, cic and fir work on the samples, window on the reduced values of the successive blocks.
+    // Decimating stages take an optional factor ("cic:50"), otherwise outputRate or decimation gives it.
+    struct DspChainSettings
+    {
+        std::vector<std::string> channelChains;            // one chain per channel, empty = raw average
+        double                   notchFrequency = 50.0;     // Hz, mains frequency
+        double                   notchQ         = 30.0;
+        double                   lowPassCutoff  = 10.0;     // Hz
+        double                   lowPassQ       = 0.707107; // Butterworth
+        unsigned int             decimation     = 1;        // default factor of the decimating stages
+        double                   outputRate     = 0.0;      // Hz, when > 0 the decimating stages without factor aim at this rate
+        unsigned int             cicOrder       = 3;        // integrator/comb pairs of a cic stage
+        unsigned int             firTapsPerPhase= 8;        // fir length = firTapsPerPhase x factor
+        bool                     publishLast    = false;    // publish the newest output sample of the block instead of the block mean
+        unsigned int             windowLength   = 2;        // number of block values averaged by the window stage
+
+        bool isConfigured() const
+        {
+            for (const std::string &chain : channelChains)
+            {
+                if (!chain.empty()) return true;
+            }
+            return false;
+        }
+    };
+
+    // One block of native ADC codes of an analogic module (raw acquisition), DAQmx_Val_GroupByChannel layout.
+    // Only the buffer matching sampleBits is used: 16 bit modules move 2 bytes per sample, 24 bit modules 4,
+    // instead of the 8 bytes of a scaled double.
+    struct RawAnalogBlock
+    {
+        unsigned int                     sampleBits = 0;   // 16 or 32, 0 = no raw acquisition on this task
+        std::vector<int16>               samples16;
+        std::vector<int32>               samples32;
+        std::vector<std::vector<double>> scaling;          // per channel device polynomial, code -> volts
+    };
+
     struct GlobalFileNamesContainer
     {
         std::string newModbusServerLogFile  ;
@@ -173,9 +230,12 @@ struct MappingConfig {
         std::string digitalReaderLogFile    ;
         std::string QNiDaqWrapperLogFile    ;
         std::string DigitalWriterLogFile    ;
+        std::string acquisitionEngineLogFile;
+        std::string schedulerLogFile        ;
         std::string modbusIniFile           ;
         std::string modbusMappingFile       ;
         std::string modbusAlarmsMappingFile ;  
+        std::string daqRecordFile           ;
         GlobalFileNamesContainer() : newModbusServerLogFile  ("./newModbusServerLogFile.txt"  ) ,
                                      niDeviceModuleLogFile   ("./niDeviceModuleLogFile.txt"   ) ,
                                      iniObjectLogFile        ("./iniObjectLogFile.txt"        ) ,
@@ -185,9 +245,12 @@ struct MappingConfig {
                                      digitalReaderLogFile    ("./digitalReaderLogFile.txt"    ) ,
                                      QNiDaqWrapperLogFile    ("./QNiDaqWrapperLogFile.txt"    ) ,
                                      DigitalWriterLogFile    ("DigitalWriterLogFile.txt"      ) ,
+                                     acquisitionEngineLogFile("./acquisitionEngineLogFile.txt") ,
+                                     schedulerLogFile        ("./schedulerLogFile.txt"        ) ,
                                      modbusIniFile           ("./modbus.ini"                  ) ,
                                      modbusMappingFile       ("./mapping.csv"                 ) ,
-                                     modbusAlarmsMappingFile ("./alarmsMapping.csv"           ){}
+                                     modbusAlarmsMappingFile ("./alarmsMapping.csv"           ) ,
+                                     daqRecordFile           ("./daqRecord.bin"               ){}
     };
 
 
@@ -11,11 +11,17 @@
 #include "./NiWrappers/QNiDaqWrapper.h"
 #include "./channelReaders/analogicReader.h"
 #include "./channelReaders/digitalReader.h"
+#include "./Acquisition/acquisitionEngine.h"
+#include "./DaqBackends/daqmxBackend.h"
+#include "./DaqBackends/simulatedDaqBackend.h"
+#include "./DaqBackends/recordingDaqBackend.h"
+#include "./DaqBackends/replayDaqBackend.h"
 #include "./Modbus/NewModbusServer.h"
 #include "./Bridge/niToModbusBridge.h"
 #include "./Signals/QSignalTest.h"
 #include "./stringUtils/stringUtils.h"
 #include "./TCP Command server/CrioSSLServer.h"
+#include "./timers/periodicScheduler.h"
 #include "testFunctions.h"
 
 
@@ -24,11 +30,17 @@
 // Using smart pointers like std::shared_ptr ensures safer and automatic resource management.
 std::shared_ptr<QNiSysConfigWrapper> sysConfig             ;
 std::shared_ptr<QNiDaqWrapper      > daqMx                 ;
+std::shared_ptr<DaqBackend         > daqBackend            ;
+#if defined(RecordDaq) && !defined(ReplayDaq)
+std::shared_ptr<RecordingDaqBackend> daqRecorder           ;
+#endif
+std::shared_ptr<AcquisitionEngine  > acquisitionEngine     ;
 std::shared_ptr<AnalogicReader     > analogReader          ;
 std::shared_ptr<DigitalReader      > digitalReader         ;
 std::shared_ptr<DigitalWriter      > m_digitalWriter       ;
 std::shared_ptr<NewModbusServer    > modbusServer          ;
 std::shared_ptr<NItoModbusBridge   >  m_crioToModbusBridge ;
+std::shared_ptr<PeriodicScheduler  > scheduler             ;
 
 
 //std::shared_ptr<CrioTCPServer>       m_crioTCPServer;
@@ -43,21 +55,57 @@ void createNecessaryInstances()
   //c++ wrapper around NISysConfig low level C API (used to get or set parameters of devices)
   sysConfig      = std::make_shared<QNiSysConfigWrapper>();
   std::cout<<"sysconfig Wrapper created"<<std::endl;
+  //hardware access of the acquisition, counters and relays: the real modules, the simulator or a recording
+  GlobalFileNamesContainer fileNames;
+#if defined(ReplayDaq)
+  #ifdef ReplayDaqAsFastAsPossible
+  const bool replayAsFastAsPossible = true;
+  #else
+  const bool replayAsFastAsPossible = false;
+  #endif
+  #ifdef ReplayDaqLoop
+  const bool replayLoop = true;
+  #else
+  const bool replayLoop = false;
+  #endif
+  daqBackend     = std::make_shared<ReplayDaqBackend>(fileNames.daqRecordFile, replayAsFastAsPossible, replayLoop);
+#elif defined(SimulatedDaq)
+  daqBackend     = std::make_shared<SimulatedDaqBackend>();
+#else
+  daqBackend     = std::make_shared<DaqmxBackend>(daqMx);
+#endif
+#if defined(RecordDaq) && !defined(ReplayDaq)
+  daqRecorder    = std::make_shared<RecordingDaqBackend>(daqBackend, fileNames.daqRecordFile,
+                                                         static_cast<uint64_t>(RecordDaqMaxMegaBytes) * 1024 * 1024,
+                                                         std::chrono::seconds(RecordDaqMaxSeconds));
+  daqBackend     = daqRecorder;
+#endif
+  std::cout<<daqBackend->getBackendName()<<" DAQ backend created"<<std::endl;
+  //one continuous acquisition worker per plugged module, configured from the modules ini files
+  acquisitionEngine = std::make_shared<AcquisitionEngine>(sysConfig,daqMx,daqBackend);
+  std::cout<<"acquisition engine created"<<std::endl;
   //object to read anlogic channels (both current and voltage)
   analogReader   = std::make_shared<AnalogicReader>     (sysConfig,daqMx);
+  analogReader->setAcquisitionEngine(acquisitionEngine);
   std::cout<<"analogic reader created"<<std::endl;
   //object to read mainly coders and 32 bit counters
   digitalReader   = std::make_shared<DigitalReader>      (sysConfig,daqMx);
+  digitalReader->setDaqBackend(daqBackend);
     std::cout<<"digital reader created"<<std::endl;
   //object to write to coils (relays and alarms typically)
   m_digitalWriter = std::make_shared<DigitalWriter>      (sysConfig,daqMx);
+  m_digitalWriter->setDaqBackend(daqBackend);
   std::cout<<"digital writer created"<<std::endl;
   //Object that handle the modbus server
   modbusServer = std::make_shared<NewModbusServer>();
   modbusServer->modbusSetSlaveId(1);
   std::cout << "Modbus server created" << std::endl;
+  //every periodic job of the application (bridge ticks, statistics) on absolute deadlines, one thread
+  scheduler = std::make_shared<PeriodicScheduler>(1);
+  scheduler->startJob(scheduler->addJob("scheduler statistics", std::chrono::seconds(60), []() { scheduler->logOverruns(); modbusServer->logPublicationLoad(); modbusServer->logActuatorLoad(); }));
+  std::cout<<"periodic scheduler created"<<std::endl;
   //Object in charge of routing crio datas to modbus
-  m_crioToModbusBridge = std::make_shared<NItoModbusBridge>(analogReader,digitalReader,m_digitalWriter,modbusServer);
+  m_crioToModbusBridge = std::make_shared<NItoModbusBridge>(analogReader,digitalReader,m_digitalWriter,modbusServer,scheduler);
   //but the modbus server also needs direct access to the bridge for alarms
   modbusServer->setModbusBridge(m_crioToModbusBridge);
   // Run the server in a separate thread
@@ -86,18 +134,23 @@ int main(void)
   //if (!ok) return EXIT_FAILURE;
   //testIniFileSystem(ok);
   //if (!ok) return EXIT_FAILURE;
+  //benchmarkRegisterFrameScaler(ok);
+  //if (!ok) return EXIT_FAILURE;
 
   createNecessaryInstances();
-
-  m_crioToModbusBridge->loadMapping();
-  m_crioToModbusBridge->loadAlarmMapping();
   
   //auto closeLambda = []() { std::exit(EXIT_SUCCESS); };
   //-----------------------------------------------------------
-  //get the number of modules for security testing
-  daqMx->GetNumberOfModules();
-  int32 numberOfModules = daqMx->GetNumberOfModules();
-  if (numberOfModules >= 0) 
+  //without a cRIO (simulation, replay) the backend knows the modules, there is nothing to ask NISysCfg or DAQmx
+  std::vector<DaqModuleDescription> describedModules;
+  const bool modulesFromBackend = daqBackend->describeModules(describedModules);
+  std::vector<std::string> modules;
+  if (!modulesFromBackend)
+  {
+    //get the number of modules for security testing
+    daqMx->GetNumberOfModules();
+    int32 numberOfModules = daqMx->GetNumberOfModules();
+    if (numberOfModules >= 0) 
     {
         printf("Number of modules: %d\n", numberOfModules);
     } 
@@ -105,11 +158,20 @@ int main(void)
     {
         printf("An error occurred.\n");
     }
+  }
    //here no error let's continue
    std::cout <<  std::endl;
    std::cout << "*** Init phase 2: retrieve modules and load defaults ***" << std::endl<< std::endl;
-   //show a list of all modules REALLY PHYSICALLY present on the crio
-   std::vector<std::string> modules = sysConfig->EnumerateCRIOPluggedModules();
+   if (modulesFromBackend)
+   {
+     std::cout << "Modules described by the " << daqBackend->getBackendName() << " DAQ backend: " << describedModules.size() << std::endl;
+     modules = sysConfig->loadDescribedModules(describedModules);
+   }
+   else
+   {
+     //show a list of all modules REALLY PHYSICALLY present on the crio
+     modules = sysConfig->EnumerateCRIOPluggedModules();
+   }
    //Show internal of each module
    for (const std::string& str : modules)
    {
@@ -118,6 +180,10 @@ int main(void)
      std::cout << "╚═══════════════════════════════════════╝"<< std::endl;
    }
    std::cout <<  std::endl;
+#if defined(RecordDaq) && !defined(ReplayDaq)
+   //the recording starts with the module list so that it can be replayed without this cRIO
+   daqRecorder->recordModules(sysConfig->getModuleList());
+#endif
    
    std::cout << "*** Init phase 3 ***" << std::endl<< std::endl;
   /* bool state = true;
@@ -143,14 +209,17 @@ int main(void)
   }*/
 
 
-    std::thread readMod1Thread([&daqMx](){ daqMx->readMod1(); });
-    std::thread readMod2Thread([&daqMx](){ daqMx->readMod2(); });
     daqMx->setLWindowFilterActiv(true);
-     std::thread readMod3Thread([&daqMx](){ daqMx->readMod3(); });
     /*daqMx->setLowPassFilterActiv (true);
-    daqMx->setLowPassFilterCutoffFrequency(10.0f);
-    std::thread readMod3Thread([&daqMx](){ daqMx->readMod3(); });*/
+    daqMx->setLowPassFilterCutoffFrequency(10.0f);*/
+    //one worker per analogic module, rate, block size and channels are read from each module ini file
     //No threads for the counters as the NI 9423 module does not support multi-read 
+    acquisitionEngine->start();
+    std::cout << "Acquisition engine started with " << acquisitionEngine->getNbWorkers() << " workers" << std::endl;
+
+    //the mapping is compiled against the running acquisition workers, so it is loaded once they exist
+    m_crioToModbusBridge->loadMapping();
+    m_crioToModbusBridge->loadAlarmMapping();
 
     //boot strap finished
     m_crioTCPServer->startServer();
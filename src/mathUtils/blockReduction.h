@@ -0,0 +1,369 @@
+#ifndef BLOCKREDUCTION_H
+#define BLOCKREDUCTION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+  #include <immintrin.h>
+  #define BLOCKREDUCTION_X86 1
+#endif
+
+// Reduction kernels of the oversampled analogic blocks (one channel = samplesPerChannel contiguous doubles,
+// DAQmx_Val_GroupByChannel layout), shared by every analogic module.
+// Sums are Kahan compensated lane by lane and the lanes are merged with Neumaier's algorithm,
+// so averaging thousands of samples does not lose the low digits of a 24 bit module.
+// Raw blocks (native ADC codes) are summed exactly in 64 bit integers, the scaling to engineering units
+// is then applied once to the mean instead of once per sample.
+// x86_64 always has SSE2, the AVX2 kernels are selected at run time on the CPUs that have it,
+// any other target uses the scalar kernels. Must not be compiled with -ffast-math (it removes the compensation).
+struct BlockStatistics
+{
+    double sum          = 0.0;
+    double mean         = 0.0;
+    double min          = 0.0;
+    double max          = 0.0;
+    double sumOfSquares = 0.0;
+    size_t count        = 0;
+};
+
+namespace blockReductionDetail {
+
+// Neumaier accumulation, used for the scalar tail and to merge the SIMD lanes
+struct CompensatedSum
+{
+    double sum          = 0.0;
+    double compensation = 0.0;
+
+    void add(double value)
+    {
+        const double t = sum + value;
+        if (std::fabs(sum) >= std::fabs(value)) compensation += (sum - t) + value;
+        else                                    compensation += (value - t) + sum;
+        sum = t;
+    }
+
+    double result() const { return sum + compensation; }
+};
+
+static inline double scalarSum(const double *data, size_t count)
+{
+    CompensatedSum sum;
+    for (size_t i = 0; i < count; ++i) sum.add(data[i]);
+    return sum.result();
+}
+
+static inline void scalarStatistics(const double *data, size_t count, BlockStatistics &stats)
+{
+    CompensatedSum sum, squares;
+    double minimum = data[0], maximum = data[0];
+    for (size_t i = 0; i < count; ++i)
+    {
+        const double value = data[i];
+        sum.add(value);
+        squares.add(value * value);
+        minimum = value < minimum ? value : minimum;
+        maximum = value > maximum ? value : maximum;
+    }
+    stats.sum          = sum.result();
+    stats.sumOfSquares = squares.result();
+    stats.min          = minimum;
+    stats.max          = maximum;
+}
+
+template <typename T>
+static inline int64_t scalarIntegerSum(const T *data, size_t count)
+{
+    int64_t sum = 0;
+    for (size_t i = 0; i < count; ++i) sum += data[i];
+    return sum;
+}
+
+#ifdef BLOCKREDUCTION_X86
+
+// Kahan step on every lane: the compensation keeps what the addition rounded away
+#define BLOCKREDUCTION_KAHAN(ADD, SUB, sum, comp, value)      \
+    {                                                         \
+        const auto y = SUB(value, comp);                      \
+        const auto t = ADD(sum, y);                           \
+        comp = SUB(SUB(t, sum), y);                           \
+        sum  = t;                                             \
+    }
+
+static inline void mergeLanes(const double *sums, const double *comps, size_t lanes, CompensatedSum &merged)
+{
+    for (size_t i = 0; i < lanes; ++i)
+    {
+        merged.add(sums[i]);
+        merged.add(-comps[i]);
+    }
+}
+
+static inline double sse2Sum(const double *data, size_t count)
+{
+    __m128d sum0 = _mm_setzero_pd(), comp0 = _mm_setzero_pd();
+    __m128d sum1 = _mm_setzero_pd(), comp1 = _mm_setzero_pd();
+    size_t i = 0;
+    // two independent accumulators hide the latency of the compensated chain
+    for (; i + 4 <= count; i += 4)
+    {
+        BLOCKREDUCTION_KAHAN(_mm_add_pd, _mm_sub_pd, sum0, comp0, _mm_loadu_pd(data + i));
+        BLOCKREDUCTION_KAHAN(_mm_add_pd, _mm_sub_pd, sum1, comp1, _mm_loadu_pd(data + i + 2));
+    }
+    double sums[4], comps[4];
+    _mm_storeu_pd(sums, sum0);  _mm_storeu_pd(sums + 2, sum1);
+    _mm_storeu_pd(comps, comp0); _mm_storeu_pd(comps + 2, comp1);
+    CompensatedSum merged;
+    mergeLanes(sums, comps, 4, merged);
+    for (; i < count; ++i) merged.add(data[i]);
+    return merged.result();
+}
+
+static inline void sse2Statistics(const double *data, size_t count, BlockStatistics &stats)
+{
+    __m128d sum  = _mm_setzero_pd(), comp    = _mm_setzero_pd();
+    __m128d sq   = _mm_setzero_pd(), sqComp  = _mm_setzero_pd();
+    __m128d vmin = _mm_set1_pd(data[0]), vmax = vmin;
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2)
+    {
+        const __m128d value = _mm_loadu_pd(data + i);
+        BLOCKREDUCTION_KAHAN(_mm_add_pd, _mm_sub_pd, sum, comp, value);
+        BLOCKREDUCTION_KAHAN(_mm_add_pd, _mm_sub_pd, sq, sqComp, _mm_mul_pd(value, value));
+        vmin = _mm_min_pd(vmin, value);
+        vmax = _mm_max_pd(vmax, value);
+    }
+    double sums[2], comps[2], sqs[2], sqComps[2], mins[2], maxs[2];
+    _mm_storeu_pd(sums, sum); _mm_storeu_pd(comps, comp);
+    _mm_storeu_pd(sqs, sq);   _mm_storeu_pd(sqComps, sqComp);
+    _mm_storeu_pd(mins, vmin); _mm_storeu_pd(maxs, vmax);
+    CompensatedSum mergedSum, mergedSquares;
+    mergeLanes(sums, comps, 2, mergedSum);
+    mergeLanes(sqs, sqComps, 2, mergedSquares);
+    double minimum = mins[0] < mins[1] ? mins[0] : mins[1];
+    double maximum = maxs[0] > maxs[1] ? maxs[0] : maxs[1];
+    for (; i < count; ++i)
+    {
+        mergedSum.add(data[i]);
+        mergedSquares.add(data[i] * data[i]);
+        minimum = data[i] < minimum ? data[i] : minimum;
+        maximum = data[i] > maximum ? data[i] : maximum;
+    }
+    stats.sum          = mergedSum.result();
+    stats.sumOfSquares = mergedSquares.result();
+    stats.min          = minimum;
+    stats.max          = maximum;
+}
+
+__attribute__((target("avx2")))
+static inline double avx2Sum(const double *data, size_t count)
+{
+    __m256d sum0 = _mm256_setzero_pd(), comp0 = _mm256_setzero_pd();
+    __m256d sum1 = _mm256_setzero_pd(), comp1 = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        BLOCKREDUCTION_KAHAN(_mm256_add_pd, _mm256_sub_pd, sum0, comp0, _mm256_loadu_pd(data + i));
+        BLOCKREDUCTION_KAHAN(_mm256_add_pd, _mm256_sub_pd, sum1, comp1, _mm256_loadu_pd(data + i + 4));
+    }
+    double sums[8], comps[8];
+    _mm256_storeu_pd(sums, sum0);  _mm256_storeu_pd(sums + 4, sum1);
+    _mm256_storeu_pd(comps, comp0); _mm256_storeu_pd(comps + 4, comp1);
+    CompensatedSum merged;
+    mergeLanes(sums, comps, 8, merged);
+    for (; i < count; ++i) merged.add(data[i]);
+    return merged.result();
+}
+
+__attribute__((target("avx2")))
+static inline void avx2Statistics(const double *data, size_t count, BlockStatistics &stats)
+{
+    __m256d sum  = _mm256_setzero_pd(), comp   = _mm256_setzero_pd();
+    __m256d sq   = _mm256_setzero_pd(), sqComp = _mm256_setzero_pd();
+    __m256d vmin = _mm256_set1_pd(data[0]), vmax = vmin;
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        const __m256d value = _mm256_loadu_pd(data + i);
+        BLOCKREDUCTION_KAHAN(_mm256_add_pd, _mm256_sub_pd, sum, comp, value);
+        BLOCKREDUCTION_KAHAN(_mm256_add_pd, _mm256_sub_pd, sq, sqComp, _mm256_mul_pd(value, value));
+        vmin = _mm256_min_pd(vmin, value);
+        vmax = _mm256_max_pd(vmax, value);
+    }
+    double sums[4], comps[4], sqs[4], sqComps[4], mins[4], maxs[4];
+    _mm256_storeu_pd(sums, sum); _mm256_storeu_pd(comps, comp);
+    _mm256_storeu_pd(sqs, sq);   _mm256_storeu_pd(sqComps, sqComp);
+    _mm256_storeu_pd(mins, vmin); _mm256_storeu_pd(maxs, vmax);
+    CompensatedSum mergedSum, mergedSquares;
+    mergeLanes(sums, comps, 4, mergedSum);
+    mergeLanes(sqs, sqComps, 4, mergedSquares);
+    double minimum = mins[0], maximum = maxs[0];
+    for (size_t lane = 1; lane < 4; ++lane)
+    {
+        minimum = mins[lane] < minimum ? mins[lane] : minimum;
+        maximum = maxs[lane] > maximum ? maxs[lane] : maximum;
+    }
+    for (; i < count; ++i)
+    {
+        mergedSum.add(data[i]);
+        mergedSquares.add(data[i] * data[i]);
+        minimum = data[i] < minimum ? data[i] : minimum;
+        maximum = data[i] > maximum ? data[i] : maximum;
+    }
+    stats.sum          = mergedSum.result();
+    stats.sumOfSquares = mergedSquares.result();
+    stats.min          = minimum;
+    stats.max          = maximum;
+}
+
+#undef BLOCKREDUCTION_KAHAN
+
+// madd against ones adds the int16 codes by pairs into int32 lanes, which cannot overflow
+// before 32768 iterations: the lanes are flushed into the 64 bit total well before that
+static const size_t int16FlushIterations = 16384;
+
+static inline int64_t sse2SumInt16(const int16_t *data, size_t count)
+{
+    const __m128i ones = _mm_set1_epi16(1);
+    int64_t total = 0;
+    size_t i = 0;
+    while (i + 8 <= count)
+    {
+        __m128i lanes = _mm_setzero_si128();
+        for (size_t n = 0; n < int16FlushIterations && i + 8 <= count; ++n, i += 8)
+        {
+            lanes = _mm_add_epi32(lanes, _mm_madd_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i)), ones));
+        }
+        int32_t parts[4];
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(parts), lanes);
+        total += static_cast<int64_t>(parts[0]) + parts[1] + parts[2] + parts[3];
+    }
+    return total + scalarIntegerSum(data + i, count - i);
+}
+
+__attribute__((target("avx2")))
+static inline int64_t avx2SumInt16(const int16_t *data, size_t count)
+{
+    const __m256i ones = _mm256_set1_epi16(1);
+    int64_t total = 0;
+    size_t i = 0;
+    while (i + 16 <= count)
+    {
+        __m256i lanes = _mm256_setzero_si256();
+        for (size_t n = 0; n < int16FlushIterations && i + 16 <= count; ++n, i += 16)
+        {
+            lanes = _mm256_add_epi32(lanes, _mm256_madd_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i)), ones));
+        }
+        int32_t parts[8];
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(parts), lanes);
+        for (int lane = 0; lane < 8; ++lane) total += parts[lane];
+    }
+    return total + scalarIntegerSum(data + i, count - i);
+}
+
+// int32 codes are widened to int64 lanes, SSE2 has no sign extension so only AVX2 gets a vector kernel
+__attribute__((target("avx2")))
+static inline int64_t avx2SumInt32(const int32_t *data, size_t count)
+{
+    __m256i sum0 = _mm256_setzero_si256(), sum1 = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        sum0 = _mm256_add_epi64(sum0, _mm256_cvtepi32_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i))));
+        sum1 = _mm256_add_epi64(sum1, _mm256_cvtepi32_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i + 4))));
+    }
+    int64_t parts[4];
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(parts), _mm256_add_epi64(sum0, sum1));
+    return parts[0] + parts[1] + parts[2] + parts[3] + scalarIntegerSum(data + i, count - i);
+}
+
+static inline bool hasAvx2()
+{
+    static const bool avx2 = __builtin_cpu_supports("avx2");
+    return avx2;
+}
+
+#endif // BLOCKREDUCTION_X86
+
+} // namespace blockReductionDetail
+
+// Compensated sum of count contiguous samples
+static inline double blockSum(const double *data, size_t count)
+{
+#ifdef BLOCKREDUCTION_X86
+    if (blockReductionDetail::hasAvx2()) return blockReductionDetail::avx2Sum(data, count);
+    return blockReductionDetail::sse2Sum(data, count);
+#else
+    return blockReductionDetail::scalarSum(data, count);
+#endif
+}
+
+// Oversampling average of one channel, the hot path of every analogic worker
+static inline double blockMean(const double *data, size_t count)
+{
+    return count ? blockSum(data, count) / static_cast<double>(count) : 0.0;
+}
+
+// Sum, mean, min, max and sum of squares of one channel in a single pass
+static inline BlockStatistics blockStatistics(const double *data, size_t count)
+{
+    BlockStatistics stats;
+    stats.count = count;
+    if (count == 0)
+    {
+        return stats;
+    }
+#ifdef BLOCKREDUCTION_X86
+    if (blockReductionDetail::hasAvx2()) blockReductionDetail::avx2Statistics(data, count, stats);
+    else                                 blockReductionDetail::sse2Statistics(data, count, stats);
+#else
+    blockReductionDetail::scalarStatistics(data, count, stats);
+#endif
+    stats.mean = stats.sum / static_cast<double>(count);
+    return stats;
+}
+
+// Means of every channel of a block, averages must hold channelsCount values
+static inline void blockChannelMeans(const double *data, size_t channelsCount, size_t samplesPerChannel, double *averages)
+{
+    for (size_t channel = 0; channel < channelsCount; ++channel)
+    {
+        averages[channel] = blockMean(data + channel * samplesPerChannel, samplesPerChannel);
+    }
+}
+
+// Exact sum of count native 16 bit codes
+static inline int64_t blockSumInt16(const int16_t *data, size_t count)
+{
+#ifdef BLOCKREDUCTION_X86
+    if (blockReductionDetail::hasAvx2()) return blockReductionDetail::avx2SumInt16(data, count);
+    return blockReductionDetail::sse2SumInt16(data, count);
+#else
+    return blockReductionDetail::scalarIntegerSum(data, count);
+#endif
+}
+
+// Exact sum of count native 32 bit codes (24 bit modules)
+static inline int64_t blockSumInt32(const int32_t *data, size_t count)
+{
+#ifdef BLOCKREDUCTION_X86
+    if (blockReductionDetail::hasAvx2()) return blockReductionDetail::avx2SumInt32(data, count);
+#endif
+    return blockReductionDetail::scalarIntegerSum(data, count);
+}
+
+// DAQmx device scaling polynomial (coefficient i multiplies code^i), Horner form
+static inline double evaluateScalingPolynomial(const std::vector<double> &coefficients, double code)
+{
+    double value = 0.0;
+    for (size_t i = coefficients.size(); i-- > 0;)
+    {
+        value = value * code + coefficients[i];
+    }
+    return value;
+}
+
+#endif // BLOCKREDUCTION_H
@@ -13,8 +13,31 @@ static inline double roundToNbSignificativDigits(double value, unsigned int nbSi
         return value;
     }
 
+    // Puissances de dix tabulées: la décade vient de l'exposant binaire au lieu de log10/floor/pow,
+    // cette fonction est appelée sur chaque canal de chaque bloc
+    static const double powersOfTen[] = { 1e-22, 1e-21, 1e-20, 1e-19, 1e-18, 1e-17, 1e-16, 1e-15, 1e-14, 1e-13, 1e-12,
+                                          1e-11, 1e-10, 1e-9 , 1e-8 , 1e-7 , 1e-6 , 1e-5 , 1e-4 , 1e-3 , 1e-2 , 1e-1 ,
+                                          1e0  , 1e1  , 1e2  , 1e3  , 1e4  , 1e5  , 1e6  , 1e7  , 1e8  , 1e9  , 1e10 ,
+                                          1e11 , 1e12 , 1e13 , 1e14 , 1e15 , 1e16 , 1e17 , 1e18 , 1e19 , 1e20 , 1e21 , 1e22 };
+    const int tableOffset = 22;
+    const int tableMax    = 22;
+    const double magnitude = fabs(value);
+    // floor(log10(2^e)) ~ e*1233/4096, then corrected by comparisons against the table
+    int decade = (ilogb(magnitude) * 1233) >> 12;
+    if (decade > -tableOffset && decade < tableMax)
+    {
+        while (decade < tableMax - 1 && magnitude >= powersOfTen[decade + 1 + tableOffset]) ++decade;
+        while (decade > -tableOffset && magnitude <  powersOfTen[decade     + tableOffset]) --decade;
+        const int scaleExponent = static_cast<int>(nbSignificativDigits) - 1 - decade;
+        if (scaleExponent >= -tableOffset && scaleExponent <= tableMax)
+        {
+            const double scale = powersOfTen[scaleExponent + tableOffset];
+            return round(value * scale) / scale;
+        }
+    }
+
     // Calculer le facteur d'échelle pour arrondir le nombre
-    double scale = pow(10.0, nbSignificativDigits - 1 - (int)floor(log10(fabs(value))));
+    double scale = pow(10.0, static_cast<int>(nbSignificativDigits) - 1 - (int)floor(log10(fabs(value))));
 
     // Arrondir la valeur et la remettre à l'échelle
     return round(value * scale) / scale;
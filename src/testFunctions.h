@@ -11,6 +11,9 @@
 #endif
 #include "./NiModulesDefinitions/NI9208.h"
 #include "./Signals/QSignalTest.h"
+#include "./Bridge/registerFrameScaler.h"
+#include <chrono>
+#include <random>
 
 
 
@@ -102,6 +105,141 @@ static inline void testSignalSlotMechanism(bool &ok)
     }
 }
 
+// Copy of NItoModbusBridge::linearInterpolation16Bits(), the per row conversion of acquireData() before
+// the frame scaler: a division and a try block for every row (the catch only logs in the bridge)
+static inline uint16_t previousLinearInterpolation16Bits(double value, double minSource, double maxSource, uint16_t minDestination, uint16_t maxDestination)
+{
+    try
+    {
+        double scale       = (maxDestination - minDestination) / (maxSource - minSource);
+        double mappedValue = minDestination + scale * (value - minSource);
+        if (mappedValue < static_cast<double>(minDestination))
+        {
+            mappedValue = static_cast<double>(minDestination);
+        }
+        else if (mappedValue > static_cast<double>(maxDestination))
+        {
+            mappedValue = static_cast<double>(maxDestination);
+        }
+        return static_cast<uint16_t>(mappedValue);
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "An exception occurred: " << e.what() << std::endl;
+        return minDestination;
+    }
+}
+
+// Per frame cost of the analogic register scaling for 64, 512 and 4096 mapped channels, on a sequence of frames
+// where about one value in ten moves: one RegisterFrameScaler pass (without then with a deadband on every row)
+// against the previous acquireData() conversion (linearInterpolation16Bits() per row) and the precomputed per row loop.
+// The hardware reads and the mapping line copies of the previous path are left out.
+// Without deadband the scaler must end with the registers of the loop, and within one count of the previous
+// path (its scale and offset are not rounded the same way)
+static inline void benchmarkRegisterFrameScaler(bool &ok)
+{
+    ok = true;
+    std::cout << "Test 5: register frame scaling benchmark" << std::endl;
+    std::mt19937 generator(12345);
+    std::uniform_real_distribution<double> sourceValues(-5.0, 25.0);
+    std::uniform_real_distribution<double> drift(-0.05, 0.05);
+    std::uniform_int_distribution<int>     moving(0, 9);
+    for (size_t channelsCount : {size_t(64), size_t(512), size_t(4096)})
+    {
+        struct Row { double minSource, maxSource; uint16_t minDest, maxDest; double scale, offset; int destination; };
+        std::vector<Row> rows(channelsCount);
+        for (size_t i = 0; i < channelsCount; ++i)
+        {
+            // 4-20 mA style rows on the full 16 bit range, scale and offset as compileMappingPlan() computes them
+            const double scale = 65535.0 / (20.0 - 4.0);
+            rows[i] = {4.0, 20.0, 0, 65535, scale, 0.0 - scale * 4.0, static_cast<int>(channelsCount - 1 - i)};
+        }
+
+        // Changing input: each frame moves about one value in ten
+        const size_t sequenceLength = 8;
+        std::vector<std::vector<double>> sequence(sequenceLength, std::vector<double>(channelsCount));
+        std::vector<double> values(channelsCount);
+        for (double &value : values)
+        {
+            value = sourceValues(generator);
+        }
+        for (std::vector<double> &frameValues : sequence)
+        {
+            for (double &value : values)
+            {
+                if (moving(generator) == 0)
+                {
+                    value += drift(generator);
+                }
+            }
+            frameValues = values;
+        }
+
+        const unsigned int frames = 20000;
+        std::vector<uint16_t> previousRegisters(channelsCount);
+        auto start = std::chrono::steady_clock::now();
+        for (unsigned int frame = 0; frame < frames; ++frame)
+        {
+            const std::vector<double> &frameValues = sequence[frame % sequenceLength];
+            for (size_t i = 0; i < channelsCount; ++i)
+            {
+                previousRegisters[rows[i].destination] = previousLinearInterpolation16Bits(frameValues[i], rows[i].minSource, rows[i].maxSource,
+                                                                                           rows[i].minDest, rows[i].maxDest);
+            }
+        }
+        const double previousNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / frames;
+
+        std::vector<uint16_t> loopRegisters(channelsCount);
+        start = std::chrono::steady_clock::now();
+        for (unsigned int frame = 0; frame < frames; ++frame)
+        {
+            const std::vector<double> &frameValues = sequence[frame % sequenceLength];
+            for (size_t i = 0; i < channelsCount; ++i)
+            {
+                double mappedValue = rows[i].offset + rows[i].scale * frameValues[i];
+                if (mappedValue < rows[i].minDest)      mappedValue = rows[i].minDest;
+                else if (mappedValue > rows[i].maxDest) mappedValue = rows[i].maxDest;
+                loopRegisters[rows[i].destination] = static_cast<uint16_t>(mappedValue);
+            }
+        }
+        const double loopNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / frames;
+        std::cout << channelsCount << " channels: previous linearInterpolation16Bits path " << previousNs
+                  << " ns/frame, precomputed per row loop " << loopNs << " ns/frame" << std::endl;
+
+        for (double deadband : {0.0, 0.02})
+        {
+            RegisterFrameScaler   scaler;
+            std::vector<uint16_t> scaledRegisters(channelsCount);
+            for (const Row &row : rows)
+            {
+                scaler.addRow(row.scale, row.offset, row.minDest, row.maxDest, row.destination, deadband);
+            }
+            size_t written = 0;
+            start = std::chrono::steady_clock::now();
+            for (unsigned int frame = 0; frame < frames; ++frame)
+            {
+                const std::vector<double> &frameValues = sequence[frame % sequenceLength];
+                std::copy(frameValues.begin(), frameValues.end(), scaler.values());
+                written += scaler.scaleFrame(scaledRegisters.data());
+            }
+            const double scalerNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / frames;
+
+            // Without deadband the last frame of the sequence leaves the registers of the loop
+            bool same = true;
+            for (size_t i = 0; deadband == 0.0 && i < channelsCount; ++i)
+            {
+                same = same && scaledRegisters[i] == loopRegisters[i]
+                            && std::abs(static_cast<int>(scaledRegisters[i]) - static_cast<int>(previousRegisters[i])) <= 1;
+            }
+            ok = ok && same;
+            std::cout << "    frame scaler, deadband " << deadband << ": " << scalerNs << " ns/frame, "
+                      << static_cast<double>(written) / frames << " changed registers/frame"
+                      << (same ? "" : " MISMATCH") << std::endl;
+        }
+    }
+    std::cout << (ok ? "Test succes!" : "Test Failed!") << std::endl;
+}
+
 static inline void testIniFileSystem(bool &ok)
 {
     ok = false;
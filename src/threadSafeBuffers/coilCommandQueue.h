@@ -0,0 +1,209 @@
+#ifndef COIL_COMMAND_QUEUE_H
+#define COIL_COMMAND_QUEUE_H
+
+#include <vector>
+#include <atomic>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+#include <cerrno>
+#include <time.h>
+#include <semaphore.h>
+
+// Lock free, bounded queue of the coil writes of the modbus workers (any number of producers),
+// consumed by a single actuator thread.
+// Every coil has a pending slot holding its requested state and the time of its oldest write not applied yet:
+// a write to a coil already pending only updates that slot, so a burst of writes to the same coil is coalesced
+// and the actuator applies the last state once. Only the write opening a pending period enqueues the coil address,
+// the ring never holds a coil twice and its capacity (the number of coils) can never be exceeded.
+// A producer never waits: a few atomic operations and a sem_post.
+class CoilCommandQueue {
+public:
+    struct Command {
+        uint16_t coilAddr = 0;
+        bool     state    = false;
+        int64_t  queuedNs = 0; // CLOCK_MONOTONIC time of the oldest write coalesced in this command
+    };
+
+    explicit CoilCommandQueue(size_t nbCoils)
+        : m_slots(new std::atomic<uint64_t>[nbCoils ? nbCoils : 1])
+        , m_nbCoils(nbCoils)
+    {
+        size_t capacity = 1;
+        while (capacity < m_nbCoils)
+        {
+            capacity <<= 1;
+        }
+        m_mask = capacity - 1;
+        m_cells.reset(new Cell[capacity]);
+        for (size_t i = 0; i < capacity; ++i)
+        {
+            m_cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        for (size_t i = 0; i < m_nbCoils; ++i)
+        {
+            m_slots[i].store(0, std::memory_order_relaxed);
+        }
+        sem_init(&m_pendingCommands, 0, 0);
+    }
+
+    ~CoilCommandQueue()
+    {
+        sem_destroy(&m_pendingCommands);
+    }
+
+    CoilCommandQueue(const CoilCommandQueue &) = delete;
+    CoilCommandQueue &operator=(const CoilCommandQueue &) = delete;
+
+    // Producer side, returns false when coilAddr is beyond the coils of the queue
+    bool push(uint16_t coilAddr, bool state)
+    {
+        if (coilAddr >= m_nbCoils)
+        {
+            return false;
+        }
+        std::atomic<uint64_t> &slot = m_slots[coilAddr];
+        const uint64_t now     = static_cast<uint64_t>(monotonicNs()) & timeMask;
+        uint64_t       current = slot.load(std::memory_order_acquire);
+        uint64_t       next    = 0;
+        do
+        {
+            // A pending coil keeps the time of its oldest write, the latency covers the whole wait
+            next = pendingFlag | (state ? stateFlag : 0) | ((current & pendingFlag) ? (current & timeMask) : now);
+        } while (!slot.compare_exchange_weak(current, next, std::memory_order_acq_rel, std::memory_order_acquire));
+
+        if (current & pendingFlag)
+        {
+            m_coalescedWrites.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+        enqueue(coilAddr);
+        sem_post(&m_pendingCommands);
+        return true;
+    }
+
+    // Consumer side: waits up to timeoutMs for a command, then appends every pending one to commands.
+    // Returns the number of appended commands
+    size_t popAll(std::vector<Command> &commands, int timeoutMs)
+    {
+        timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec  += timeoutMs / 1000;
+        deadline.tv_nsec += static_cast<long>(timeoutMs % 1000) * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L)
+        {
+            deadline.tv_sec  += 1;
+            deadline.tv_nsec -= 1000000000L;
+        }
+        int rc = 0;
+        while ((rc = sem_timedwait(&m_pendingCommands, &deadline)) == -1 && errno == EINTR)
+        {
+        }
+        if (rc == -1)
+        {
+            return 0;
+        }
+
+        // One token per enqueued address, posted once the address is in the ring
+        size_t popped = 0;
+        do
+        {
+            const uint16_t coilAddr = dequeue();
+            // The slot is freed after the dequeue: a write from now on opens a new command
+            const uint64_t slot = m_slots[coilAddr].exchange(0, std::memory_order_acq_rel);
+            if (!(slot & pendingFlag))
+            {
+                continue;
+            }
+            Command command;
+            command.coilAddr = coilAddr;
+            command.state    = (slot & stateFlag) != 0;
+            command.queuedNs = static_cast<int64_t>(slot & timeMask);
+            commands.push_back(command);
+            ++popped;
+        } while (sem_trywait(&m_pendingCommands) == 0);
+        return popped;
+    }
+
+    // Writes merged into an already pending command since the creation of the queue
+    uint64_t coalescedWrites() const
+    {
+        return m_coalescedWrites.load(std::memory_order_relaxed);
+    }
+
+    size_t nbCoils() const
+    {
+        return m_nbCoils;
+    }
+
+    static int64_t monotonicNs()
+    {
+        timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        return static_cast<int64_t>(now.tv_sec) * 1000000000LL + now.tv_nsec;
+    }
+
+private:
+    // Slot layout: pending flag, requested state, CLOCK_MONOTONIC ns of the oldest write (62 bits, about 146 years)
+    static constexpr uint64_t pendingFlag = 1ULL << 63;
+    static constexpr uint64_t stateFlag   = 1ULL << 62;
+    static constexpr uint64_t timeMask    = stateFlag - 1;
+
+    // Bounded ring with a sequence number per cell: a producer claims a position with a CAS on m_tail,
+    // then publishes the cell by moving its sequence, the consumer only reads published cells
+    struct Cell
+    {
+        std::atomic<size_t> sequence{0};
+        uint16_t            coilAddr = 0;
+    };
+
+    void enqueue(uint16_t coilAddr)
+    {
+        size_t position = m_tail.load(std::memory_order_relaxed);
+        while (true)
+        {
+            Cell          &cell     = m_cells[position & m_mask];
+            const size_t   sequence = cell.sequence.load(std::memory_order_acquire);
+            const intptr_t distance = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+            if (distance == 0)
+            {
+                if (m_tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                {
+                    cell.coilAddr = coilAddr;
+                    cell.sequence.store(position + 1, std::memory_order_release);
+                    return;
+                }
+            }
+            else
+            {
+                // Never full (one cell per coil at most): only another producer claimed this position first
+                position = m_tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    uint16_t dequeue()
+    {
+        // Single consumer, called once per semaphore token: the token is posted after the cell is published
+        const size_t position = m_head;
+        Cell        &cell     = m_cells[position & m_mask];
+        while (cell.sequence.load(std::memory_order_acquire) != position + 1)
+        {
+        }
+        const uint16_t coilAddr = cell.coilAddr;
+        cell.sequence.store(position + m_mask + 1, std::memory_order_release);
+        m_head = position + 1;
+        return coilAddr;
+    }
+
+    std::unique_ptr<std::atomic<uint64_t>[]> m_slots;
+    size_t                                   m_nbCoils = 0;
+    std::unique_ptr<Cell[]>                  m_cells;
+    size_t                                   m_mask = 0;
+    std::atomic<size_t>                      m_tail{0};
+    size_t                                   m_head = 0;        // consumer only
+    std::atomic<uint64_t>                    m_coalescedWrites{0};
+    sem_t                                    m_pendingCommands; // one token per enqueued coil address
+};
+
+#endif // COIL_COMMAND_QUEUE_H
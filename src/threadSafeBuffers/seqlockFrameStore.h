@@ -0,0 +1,134 @@
+#ifndef SEQLOCK_FRAME_STORE_H
+#define SEQLOCK_FRAME_STORE_H
+
+#include <vector>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <cstddef>
+#include <cstdint>
+
+// Lock free, allocation free store of the latest frame of a module (one value per channel).
+// Single writer (the acquisition worker of the module), any number of readers.
+// Seqlock semantics: the sequence number is odd while a frame is being written,
+// readers copy optimistically and retry if the sequence moved, so the writer is never blocked
+// and a reader never sees a frame mixing values of two acquisition blocks.
+template <typename T>
+class SeqlockFrameStore {
+public:
+    explicit SeqlockFrameStore(size_t frameSize = 0)
+    {
+        resize(frameSize);
+    }
+
+    // Allocates the storage, must be called before the writer and readers start
+    void resize(size_t frameSize)
+    {
+        m_size = frameSize;
+        m_data.reset(frameSize ? new std::atomic<T>[frameSize] : nullptr);
+        for (size_t i = 0; i < m_size; ++i)
+        {
+            m_data[i].store(T(), std::memory_order_relaxed);
+        }
+        m_sequence.store(0, std::memory_order_release);
+    }
+
+    // Number of values in a frame
+    size_t size() const
+    {
+        return m_size;
+    }
+
+    // Publishes a whole frame (writer side, never blocks)
+    void publish(const T *frame, size_t count)
+    {
+        if (count > m_size) count = m_size;
+        uint64_t sequence = m_sequence.load(std::memory_order_relaxed);
+        // odd: write in progress
+        m_sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < count; ++i)
+        {
+            m_data[i].store(frame[i], std::memory_order_relaxed);
+        }
+        // even again: frame complete and visible to the readers
+        m_sequence.store(sequence + 2, std::memory_order_release);
+    }
+
+    void publish(const std::vector<T> &frame)
+    {
+        publish(frame.data(), frame.size());
+    }
+
+    // Copies a consistent frame into destination, returns false if nothing was ever published
+    bool readFrame(T *destination, size_t count, uint64_t *frameNumber = nullptr) const
+    {
+        if (count > m_size) count = m_size;
+        uint64_t before, after;
+        unsigned int spins = 0;
+        do
+        {
+            before = m_sequence.load(std::memory_order_acquire);
+            if (before & 1)
+            {
+                backOff(spins);
+                after = before + 1;
+                continue;
+            }
+            for (size_t i = 0; i < count; ++i)
+            {
+                destination[i] = m_data[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = m_sequence.load(std::memory_order_relaxed);
+            if (before != after) backOff(spins);
+        } while (before != after);
+
+        if (frameNumber) *frameNumber = before >> 1;
+        return before != 0;
+    }
+
+    // Reads a single channel of the latest frame, returns false if out of range or nothing was ever published
+    bool readValue(size_t index, T &value) const
+    {
+        if (index >= m_size) return false;
+        uint64_t before, after;
+        unsigned int spins = 0;
+        do
+        {
+            before = m_sequence.load(std::memory_order_acquire);
+            if (before & 1)
+            {
+                backOff(spins);
+                after = before + 1;
+                continue;
+            }
+            value = m_data[index].load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = m_sequence.load(std::memory_order_relaxed);
+        } while (before != after);
+        return before != 0;
+    }
+
+    // Number of frames published so far
+    uint64_t frameNumber() const
+    {
+        return m_sequence.load(std::memory_order_acquire) >> 1;
+    }
+
+private:
+    // The writer only holds the sequence odd for a few stores, spin a little then let it run
+    static void backOff(unsigned int &spins)
+    {
+        if (++spins > 64)
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    std::unique_ptr<std::atomic<T>[]> m_data;
+    size_t                            m_size = 0;
+    std::atomic<uint64_t>             m_sequence{0};
+};
+
+#endif // SEQLOCK_FRAME_STORE_H
@@ -0,0 +1,268 @@
+#include "periodicScheduler.h"
+
+#include <time.h>
+#include <cerrno>
+#include <stdexcept>
+#include <algorithm>
+
+#include "../filesUtils/appendToFileHelper.h"
+
+PeriodicScheduler::PeriodicScheduler(unsigned int nbThreads)
+{
+    if (nbThreads == 0)
+    {
+        nbThreads = 1;
+    }
+    for (unsigned int i = 0; i < nbThreads; ++i)
+    {
+        m_threads.emplace_back([this, i]() { runThread(i); });
+    }
+}
+
+PeriodicScheduler::~PeriodicScheduler()
+{
+    m_keepRunning.store(false);
+    for (std::thread &thread : m_threads)
+    {
+        if (thread.joinable())
+        {
+            thread.join();
+        }
+    }
+}
+
+int64_t PeriodicScheduler::monotonicNs()
+{
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<int64_t>(now.tv_sec) * 1000000000LL + now.tv_nsec;
+}
+
+void PeriodicScheduler::sleepUntilNs(int64_t deadlineNs)
+{
+    timespec deadline;
+    deadline.tv_sec  = static_cast<time_t>(deadlineNs / 1000000000LL);
+    deadline.tv_nsec = static_cast<long>(deadlineNs % 1000000000LL);
+    // Absolute sleep: a signal only makes it restart towards the same instant
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, nullptr) == EINTR)
+    {
+    }
+}
+
+PeriodicScheduler::Job &PeriodicScheduler::getJob(JobId jobId) const
+{
+    if (jobId >= m_jobs.size())
+    {
+        appendCommentWithTimestamp(m_fileNamesContainer.schedulerLogFile,
+                                   "in\n"
+                                   "PeriodicScheduler::Job &PeriodicScheduler::getJob(JobId jobId) const\n"
+                                   "Error: unknown job "+std::to_string(jobId));
+        throw std::invalid_argument("PeriodicScheduler: unknown job " + std::to_string(jobId));
+    }
+    return *m_jobs[jobId];
+}
+
+bool PeriodicScheduler::isSchedulerThread() const
+{
+    const std::thread::id self = std::this_thread::get_id();
+    for (const std::thread &thread : m_threads)
+    {
+        if (thread.get_id() == self) return true;
+    }
+    return false;
+}
+
+PeriodicScheduler::JobId PeriodicScheduler::addJob(const std::string &name, std::chrono::nanoseconds period, std::function<void()> function)
+{
+    if (period.count() <= 0 || !function)
+    {
+        appendCommentWithTimestamp(m_fileNamesContainer.schedulerLogFile,
+                                   "in\n"
+                                   "PeriodicScheduler::JobId PeriodicScheduler::addJob(const std::string &name, std::chrono::nanoseconds period, std::function<void()> function)\n"
+                                   "Error: job "+name+" needs a period > 0 and a function");
+        throw std::invalid_argument("PeriodicScheduler: job " + name + " needs a period > 0 and a function");
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::unique_ptr<Job> job(new Job());
+    job->name     = name;
+    job->periodNs = period.count();
+    job->function = function;
+    job->thread   = static_cast<unsigned int>(m_jobs.size() % m_threads.size());
+    m_jobs.push_back(std::move(job));
+    return m_jobs.size() - 1;
+}
+
+void PeriodicScheduler::startJob(JobId jobId)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Job &job = getJob(jobId);
+    if (job.active)
+    {
+        return;
+    }
+    job.active         = true;
+    job.generation    += 1;
+    job.nextDeadlineNs = monotonicNs() + job.periodNs;
+}
+
+void PeriodicScheduler::stopJob(JobId jobId)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    Job &job = getJob(jobId);
+    job.active      = false;
+    job.generation += 1;
+    // A job stopping itself, or another job of the scheduler, cannot wait for the run in progress
+    if (isSchedulerThread())
+    {
+        return;
+    }
+    m_jobFinished.wait(lock, [&job]() { return !job.running; });
+}
+
+void PeriodicScheduler::setJobPeriod(JobId jobId, std::chrono::nanoseconds period)
+{
+    if (period.count() <= 0)
+    {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    // Taken into account from the deadline following the next one
+    getJob(jobId).periodNs = period.count();
+}
+
+bool PeriodicScheduler::isJobActive(JobId jobId) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return getJob(jobId).active;
+}
+
+PeriodicJobStatistics PeriodicScheduler::getJobStatistics(JobId jobId) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return getJob(jobId).statistics;
+}
+
+std::string PeriodicScheduler::getJobName(JobId jobId) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return getJob(jobId).name;
+}
+
+size_t PeriodicScheduler::getNbJobs() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_jobs.size();
+}
+
+void PeriodicScheduler::logOverruns()
+{
+    std::vector<std::string> reports;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (std::unique_ptr<Job> &job : m_jobs)
+        {
+            const PeriodicJobStatistics &statistics = job->statistics;
+            if (statistics.overruns == job->loggedOverruns)
+            {
+                continue;
+            }
+            reports.push_back("job "+job->name+": "+std::to_string(statistics.overruns - job->loggedOverruns)+" new overruns, "
+                              +std::to_string(statistics.overruns)+" overruns and "+std::to_string(statistics.skippedPeriods)+" skipped periods in "
+                              +std::to_string(statistics.runs)+" runs, max lateness "+std::to_string(statistics.maxLatenessNs / 1000)+" us, max duration "
+                              +std::to_string(statistics.maxDurationNs / 1000)+" us for a period of "+std::to_string(job->periodNs / 1000)+" us");
+            job->loggedOverruns = statistics.overruns;
+        }
+    }
+    // The file is written outside of the lock, the other threads keep scheduling meanwhile
+    for (const std::string &report : reports)
+    {
+        appendCommentWithTimestamp(m_fileNamesContainer.schedulerLogFile, "Warning: " + report);
+    }
+}
+
+void PeriodicScheduler::runThread(unsigned int threadIndex)
+{
+    while (m_keepRunning.load())
+    {
+        // Earliest deadline among the active jobs of this thread
+        Job     *nextJob    = nullptr;
+        int64_t  deadlineNs = 0;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (std::unique_ptr<Job> &job : m_jobs)
+            {
+                if (job->active && job->thread == threadIndex && (!nextJob || job->nextDeadlineNs < deadlineNs))
+                {
+                    nextJob    = job.get();
+                    deadlineNs = job->nextDeadlineNs;
+                }
+            }
+        }
+
+        const int64_t nowNs = monotonicNs();
+        if (!nextJob || nowNs < deadlineNs)
+        {
+            sleepUntilNs((nextJob && deadlineNs - nowNs < maxSleepSliceNs) ? deadlineNs : nowNs + maxSleepSliceNs);
+            continue;
+        }
+
+        std::function<void()> function;
+        uint64_t generation = 0;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            // Stopped or restarted while this thread was sleeping
+            if (!nextJob->active || nextJob->nextDeadlineNs != deadlineNs)
+            {
+                continue;
+            }
+            nextJob->running = true;
+            generation = nextJob->generation;
+            function   = nextJob->function;
+        }
+
+        const int64_t startNs = monotonicNs();
+        try
+        {
+            function();
+        }
+        catch (const std::exception &e)
+        {
+            appendCommentWithTimestamp(m_fileNamesContainer.schedulerLogFile,
+                                       "in\n"
+                                       "void PeriodicScheduler::runThread(unsigned int threadIndex)\n"
+                                       "Error: job "+nextJob->name+" threw:\n"+std::string(e.what()));
+        }
+        catch (...)
+        {
+            // A non standard exception must not end the thread with the job still marked running
+            appendCommentWithTimestamp(m_fileNamesContainer.schedulerLogFile,
+                                       "in\n"
+                                       "void PeriodicScheduler::runThread(unsigned int threadIndex)\n"
+                                       "Error: job "+nextJob->name+" threw an unknown exception");
+        }
+        const int64_t endNs = monotonicNs();
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            PeriodicJobStatistics &statistics = nextJob->statistics;
+            statistics.runs         += 1;
+            statistics.maxLatenessNs = std::max(statistics.maxLatenessNs, startNs - deadlineNs);
+            statistics.maxDurationNs = std::max(statistics.maxDurationNs, endNs - startNs);
+            nextJob->running = false;
+            if (nextJob->generation == generation)
+            {
+                // Next deadline of the same phase, the ones already passed are dropped
+                int64_t nextDeadlineNs = deadlineNs + nextJob->periodNs;
+                if (endNs >= nextDeadlineNs)
+                {
+                    const int64_t missed = (endNs - deadlineNs) / nextJob->periodNs;
+                    statistics.overruns       += 1;
+                    statistics.skippedPeriods += static_cast<uint64_t>(missed);
+                    nextDeadlineNs = deadlineNs + (missed + 1) * nextJob->periodNs;
+                }
+                nextJob->nextDeadlineNs = nextDeadlineNs;
+            }
+        }
+        m_jobFinished.notify_all();
+    }
+}
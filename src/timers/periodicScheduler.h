@@ -0,0 +1,84 @@
+#ifndef PeriodicScheduler_h
+#define PeriodicScheduler_h
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <chrono>
+#include <cstdint>
+
+#include "../globals/globalEnumStructs.h"
+
+struct PeriodicJobStatistics {
+    uint64_t runs           = 0;
+    uint64_t overruns       = 0; // runs that ended after the next deadline
+    uint64_t skippedPeriods = 0; // deadlines dropped because of the overruns
+    int64_t  maxLatenessNs  = 0; // worst delay between a deadline and the start of its run
+    int64_t  maxDurationNs  = 0;
+};
+
+// Periodic jobs multiplexed on a few threads (acquisition tick, simulation tick, statistics...).
+// Every job runs on absolute CLOCK_MONOTONIC deadlines (clock_nanosleep TIMER_ABSTIME):
+// deadline n is start + n * period whatever the execution time, so the cadence does not drift.
+// A run that ends after its next deadline is an overrun: it is counted, the missed deadlines are dropped
+// and the job goes on with the next deadline of the same phase, it never runs twice in a row to catch up.
+// A job always runs on the same thread, so it never runs concurrently with itself.
+class PeriodicScheduler {
+public:
+    typedef size_t JobId;
+
+    explicit PeriodicScheduler(unsigned int nbThreads = 1);
+    ~PeriodicScheduler();
+
+    // The job is created stopped, the thread is chosen round robin
+    JobId                 addJob            (const std::string &name, std::chrono::nanoseconds period, std::function<void()> function);
+    // First run one period after the call
+    void                  startJob          (JobId jobId);
+    // Returns once the job is not running anymore (immediately when called from a scheduler thread)
+    void                  stopJob           (JobId jobId);
+    void                  setJobPeriod      (JobId jobId, std::chrono::nanoseconds period);
+    bool                  isJobActive       (JobId jobId) const;
+    PeriodicJobStatistics getJobStatistics  (JobId jobId) const;
+    std::string           getJobName        (JobId jobId) const;
+    size_t                getNbJobs         () const;
+    // Logs the jobs whose overruns grew since the previous call, meant to run as a job itself
+    void                  logOverruns       ();
+
+private:
+    struct Job {
+        std::string            name;
+        int64_t                periodNs       = 0;
+        std::function<void()>  function;
+        unsigned int           thread         = 0;
+        bool                   active         = false;
+        bool                   running        = false;
+        uint64_t               generation     = 0;   // bumped by start/stop, a run of an older generation does not reschedule
+        int64_t                nextDeadlineNs = 0;
+        PeriodicJobStatistics  statistics;
+        uint64_t               loggedOverruns = 0;
+    };
+
+    void           runThread          (unsigned int threadIndex);
+    Job           &getJob             (JobId jobId) const;
+    bool           isSchedulerThread  () const;
+    static int64_t monotonicNs        ();
+    static void    sleepUntilNs       (int64_t deadlineNs);
+
+    // A sleeping thread wakes up at least this often to see the jobs started or stopped meanwhile,
+    // the last slice still ends on the absolute deadline
+    static const int64_t maxSleepSliceNs = 20000000;
+
+    mutable std::mutex                 m_mutex;
+    std::condition_variable            m_jobFinished;
+    std::vector<std::unique_ptr<Job>>  m_jobs;
+    std::vector<std::thread>           m_threads;
+    std::atomic<bool>                  m_keepRunning{true};
+    GlobalFileNamesContainer           m_fileNamesContainer;
+};
+
+#endif // PeriodicScheduler_h